@@ -10,8 +10,8 @@
 #include "LoggerDisplay.h"
 
 // Which display to debug?
-LoggerDisplay *lcd = new LoggerDisplay(16, 2);
-//LoggerDisplay *lcd = new LoggerDisplay(20, 4);
+LoggerDisplay lcd(16, 2);
+//LoggerDisplay lcd(20, 4);
 
 int last_second = 0;
 int last_message = 0;
@@ -29,14 +29,14 @@ void info_handler(const char *topic, const char *data)
 	{
 		Serial.println("Device name: " + String(data));
 		strncpy(device_name, data, sizeof(device_name));
-		lcd->printLine(1, "Name: " + String(device_name));
+		lcd.printLine(1, "Name: " + String(device_name));
 	}
 	else if (strcmp(topic, "spark/device/ip") == 0)
 	{
 		Serial.println("Device public IP: " + String(data));
 		strncpy(device_public_ip, data, sizeof(device_public_ip));
-		lcd->printLine(3, "IP address: ");
-		lcd->printLine(4, device_public_ip);
+		lcd.printLine(3, "IP address: ");
+		lcd.printLine(4, device_public_ip);
 	}
 	// unsubscribe from events
 	if (strlen(device_name) > 0 && strlen(device_public_ip) > 0)
@@ -67,10 +67,10 @@ void setup(void) {
 	Time.zone(-6); // to get the time correctly
 
 	// LCD screen
-	lcd->init();
-	lcd->setTempTextShowTime(3); // 3 seconds temporary text show time
-	lcd->printLine(1, "Starting up...");
-	lcd->printLine(2, "extra long super testing");
+	lcd.init();
+	lcd.setTempTextShowTime(3); // 3 seconds temporary text show time
+	lcd.printLine(1, "Starting up...");
+	lcd.printLine(2, "extra long super testing");
 
 	// particle subscriptions
 	Particle.subscribe("spark/", info_handler, ALL_DEVICES);
@@ -120,7 +120,7 @@ void loop(void)
 	if (Time.second() != last_second)
 	{
 		Serial.println(Time.format(Time.now(), "%H:%M:%S %d.%m.%Y %Z"));
-		lcd->printLine(2, Time.format(Time.now(), "%H:%M:%S %d.%m.%Y %Z"));
+		lcd.printLine(2, Time.format(Time.now(), "%H:%M:%S %d.%m.%Y %Z"));
 		last_second = Time.second();
 	}
 
@@ -130,52 +130,52 @@ void loop(void)
 
 		if (test == 0)
 		{
-			lcd->resetBuffer();
-			lcd->addToBuffer("line 1");
-			lcd->addToBuffer(" temp msg");
-			lcd->addToBuffer(" extra long");
-			lcd->printLineTempFromBuffer(1);
+			lcd.resetBuffer();
+			lcd.addToBuffer("line 1");
+			lcd.addToBuffer(" temp msg");
+			lcd.addToBuffer(" extra long");
+			lcd.printLineTempFromBuffer(1);
 		}
 		else if (test == 1)
 		{
-			lcd->printLineTemp(2, "full left temp");
+			lcd.printLineTemp(2, "full left temp");
 		}
 		else if (test == 2)
 		{
-			lcd->printLineTempRight(2, "right temp", 11);
+			lcd.printLineTempRight(2, "right temp", 11);
 		}
 		else if (test == 3)
 		{
-			lcd->printLineTempRight(1, "2 line temp", 12);
-			lcd->printLineTempRight(2, "2 line temp", 12);
+			lcd.printLineTempRight(1, "2 line temp", 12);
+			lcd.printLineTempRight(2, "2 line temp", 12);
 		}
 		else if (test == 4)
 		{
-			lcd->printLineRight(1, "right perm", 11);
+			lcd.printLineRight(1, "right perm", 11);
 		}
 		else if (test == 5)
 		{
-			lcd->printLineTempRight(1, "TEMP", 4);
+			lcd.printLineTempRight(1, "TEMP", 4);
 		}
 		else if (test == 6)
 		{
-			lcd->printLine(1, " add part left ", 10, 4);
+			lcd.printLine(1, " add part left ", 10, 4);
 		}
 		else if (test == 7)
 		{
-			lcd->goToLine(1);
-			lcd->print("1 ");
-			lcd->print("2 ");
-			lcd->print("3...");
+			lcd.goToLine(1);
+			lcd.print("1 ");
+			lcd.print("2 ");
+			lcd.print("3...");
 		}
 		else if (test == 8)
 		{
-			lcd->printLine(1, "Name: " + String(device_name));
+			lcd.printLine(1, "Name: " + String(device_name));
 		}
 
 		test++;
 		last_message = millis();
 	}
 
-	lcd->update();
+	lcd.update();
 }
@@ -0,0 +1,81 @@
+/*
+ * Compares full screen redraws with the LiquidCrystal_I2C library and the burst I2C driver (LoggerDisplayI2C).
+ *
+ * Wiring from LCD backpack to photon:
+ *   - SDA to pin D0
+ *   - SCL to pin D1
+ *   - VCC to VIN
+ *   - GND to GND
+ *
+ */
+
+#include "application.h"
+#include <LiquidCrystal_I2C_Spark.h>
+#include "LoggerDisplayI2C.h"
+
+// Which display?
+#define LCD_ADDR  0x27
+#define LCD_COLS  20
+#define LCD_LINES 4
+
+#define REDRAWS   20
+
+SYSTEM_MODE(MANUAL);
+
+LiquidCrystal_I2C library_lcd(LCD_ADDR, LCD_COLS, LCD_LINES);
+LoggerDisplayI2C burst_lcd(LCD_ADDR, LCD_COLS, LCD_LINES);
+
+char rows[LCD_LINES][LCD_COLS + 1];
+
+void fillRows(int redraw) {
+	for (int line = 0; line < LCD_LINES; line++) {
+		for (int col = 0; col < LCD_COLS; col++) rows[line][col] = 'A' + (redraw + line + col) % 26;
+		rows[line][LCD_COLS] = 0;
+	}
+}
+
+void setup(void) {
+
+	// start serial
+	Serial.begin(9600);
+	waitFor(Serial.isConnected, 5000); // give monitor 5 seconds to connect
+	delay(500);
+	Serial.println("Starting LCD benchmark...");
+
+	// library
+	library_lcd.init();
+	library_lcd.backlight();
+	unsigned long start = micros();
+	for (int redraw = 0; redraw < REDRAWS; redraw++) {
+		fillRows(redraw);
+		for (int line = 0; line < LCD_LINES; line++) {
+			library_lcd.setCursor(0, line);
+			library_lcd.print(rows[line]);
+		}
+	}
+	unsigned long library_us = (micros() - start) / REDRAWS;
+	Serial.printlnf("INFO: LiquidCrystal_I2C: %lu us per %dx%d redraw", library_us, LCD_COLS, LCD_LINES);
+
+	// burst driver
+	burst_lcd.init();
+	unsigned long transactions = burst_lcd.getTransactions();
+	unsigned long bytes = burst_lcd.getBytes();
+	start = micros();
+	for (int redraw = 0; redraw < REDRAWS; redraw++) {
+		fillRows(redraw);
+		for (int line = 0; line < LCD_LINES; line++) {
+			burst_lcd.setCursor(0, line);
+			burst_lcd.print(rows[line]);
+		}
+	}
+	unsigned long burst_us = (micros() - start) / REDRAWS;
+	Serial.printlnf("INFO: LoggerDisplayI2C: %lu us per %dx%d redraw (%lu I2C transactions, %lu bytes)", burst_us, LCD_COLS, LCD_LINES,
+		(burst_lcd.getTransactions() - transactions) / REDRAWS, (burst_lcd.getBytes() - bytes) / REDRAWS);
+	Serial.printlnf("INFO: speedup %.1fx", (float) library_us / burst_us);
+
+	// finished
+	Serial.println("Benchmark complete - check that the screen shows the last redraw correctly");
+}
+
+void loop(void) {
+}
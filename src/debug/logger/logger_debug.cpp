@@ -15,7 +15,7 @@ LoggerDisplay LCD_20x4 (20, 4);
 LoggerDisplay* lcd = &LCD_16x2;
 
 // initial state
-LoggerControllerState* state = new LoggerControllerState(
+LoggerControllerState state(
   /* locked */                    false,
   /* state_logging */             true,
   /* data_logging */              false,
@@ -26,24 +26,27 @@ LoggerControllerState* state = new LoggerControllerState(
 );
 
 // controller
-LoggerController* controller = new LoggerController(
+LoggerController controller(
   /* version */           "debug 0.2",
   /* reset pin */         A5,
   /* lcd screen */        lcd,
-  /* pointer to state */  state
+  /* pointer to state */  &state
 );
 
 // components
-LoggerComponent* cp1 = new LoggerComponent(
-  "cp1 test", controller, false, false
+LoggerComponent cp1(
+  "cp1 test", &controller, false, false
 );
 
-ExampleState* cp2_state = new ExampleState();
+ExampleState cp2_state;
 
-ExampleLoggerComponent* cp2 = new ExampleLoggerComponent(
-  "example component", controller, cp2_state
+ExampleLoggerComponent cp2(
+  "example component", &controller, &cp2_state
 );
 
+// local log collector (optional, in addition to the particle cloud)
+//LoggerUDPTransport udp_transport(IPAddress(192, 168, 1, 10), 9101);
+
 // manual wifi management
 SYSTEM_THREAD(ENABLED);
 SYSTEM_MODE(MANUAL);
@@ -59,26 +62,29 @@ void setup() {
   delay(1000);
 
   // debug modes
-  //controller->debugDisplay();
-  //controller->debugData();
-  //controller->debugState();
-  //controller->debugCloud();
-  //controller->debugWebhooks();
+  //controller.debugDisplay();
+  //controller.debugData();
+  //controller.debugState();
+  //controller.debugCloud();
+  //controller.debugWebhooks();
 
   // lcd temporary messages
   lcd->setTempTextShowTime(3); // how many seconds temp time
 
   // add components
-  controller->addComponent(cp1);
-  controller->addComponent(cp2);
+  controller.addComponent(&cp1);
+  controller.addComponent(&cp2);
+
+  // add transports
+  //controller.addTransport(&udp_transport);
 
   // controller
-  controller->init();
+  controller.init();
 
 }
 
 // loop
 void loop() {
-  controller->update();
+  controller.update();
 }
 
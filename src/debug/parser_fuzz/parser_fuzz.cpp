@@ -0,0 +1,100 @@
+/*
+ * Mutation fuzzer for the command and serial parsers. Runs random mutations of the seed corpora
+ * (see parser_fuzz_targets.h) through LoggerCommand tokenization, LoggerController::executeCommand
+ * and the chemglass scale byte parser. Each target reports executions/s on its unmodified corpus first,
+ * so the corpora double as a parsing speed benchmark.
+ * A crash shows up as a hard fault / watchdog reset, the input that was running is kept in retained memory
+ * and printed after the restart.
+ * Note: there is no sanitizer on the device so only gross memory errors crash, small overruns
+ * are found by the host build of the same targets with address sanitizer (tests/fuzz_parser.cpp).
+ */
+#pragma SPARK_NO_PREPROCESSOR // disable spark preprocssor to avoid issues with callbacks
+
+#include "application.h"
+#include "parser_fuzz_targets.h"
+
+// fuzzing parameters
+const int BENCHMARK_REPEATS = 100; // repeats of the whole corpus for the benchmark
+const int FUZZ_ITERATIONS = 10000; // mutated inputs per target and round
+
+// input that is running (retained so it survives the reset after a crash)
+const uint32_t FUZZ_RUNNING_MAGIC = 0x46555A5A;
+retained uint32_t running_magic;
+retained char running_target[12];
+retained uint8_t running_input[FUZZ_MAX_SIZE];
+retained uint16_t running_size;
+
+/*** crash record ***/
+
+void startInput(const char* name, const uint8_t* data, size_t size) {
+  strncpy(running_target, name, sizeof(running_target) - 1);
+  running_target[sizeof(running_target) - 1] = 0;
+  memcpy(running_input, data, size);
+  running_size = size;
+  running_magic = FUZZ_RUNNING_MAGIC;
+}
+
+void finishInputs() {
+  running_magic = 0;
+}
+
+void printCrashedInput() {
+  if (running_magic != FUZZ_RUNNING_MAGIC || running_size > FUZZ_MAX_SIZE) return;
+  running_target[sizeof(running_target) - 1] = 0;
+  Serial.printf("WARNING: the previous run stopped in the %s target on input (hex):", running_target);
+  for (size_t i = 0; i < running_size; i++) Serial.printf(" %02X", running_input[i]);
+  Serial.println();
+  finishInputs();
+}
+
+/*** runner ***/
+
+void benchmark(const char* name, int (*target)(const uint8_t*, size_t), const char** corpus, int corpus_n) {
+  unsigned long start = micros();
+  for (int r = 0; r < BENCHMARK_REPEATS; r++) {
+    for (int i = 0; i < corpus_n; i++) target((const uint8_t*) corpus[i], strlen(corpus[i]));
+  }
+  unsigned long duration = micros() - start;
+  Serial.printlnf("INFO: %s corpus benchmark: %d inputs in %lu us --> %.1f exec/s",
+    name, BENCHMARK_REPEATS * corpus_n, duration, 1e6 * BENCHMARK_REPEATS * corpus_n / duration);
+}
+
+void fuzz(const char* name, int (*target)(const uint8_t*, size_t), const char** corpus, int corpus_n) {
+  size_t size;
+  unsigned long start = millis();
+  for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+    size = mutateFuzzInput(corpus[random(corpus_n)]);
+    startInput(name, fuzz_input, size);
+    target(fuzz_input, size);
+  }
+  finishInputs();
+  Serial.printlnf("INFO: %s survived %d mutated inputs (%lu ms)", name, FUZZ_ITERATIONS, millis() - start);
+}
+
+// manual wifi management
+SYSTEM_THREAD(ENABLED);
+SYSTEM_MODE(MANUAL);
+
+int round_n = 0;
+
+void setup() {
+  Serial.begin(9600);
+  waitFor(Serial.isConnected, 10000);
+  delay(1000);
+  randomSeed(micros());
+  printCrashedInput();
+  setupFuzzTargets();
+
+  // parsing speed on the seed corpora
+  benchmark("tokenizer", fuzzCommandTokenizer, COMMAND_CORPUS, COMMAND_CORPUS_N);
+  benchmark("controller", fuzzReceiveCommand, CONTROLLER_CORPUS, CONTROLLER_CORPUS_N);
+  benchmark("serial", fuzzSerialParser, SERIAL_CORPUS, SERIAL_CORPUS_N);
+}
+
+void loop() {
+  round_n++;
+  Serial.printlnf("INFO: starting fuzz round %d", round_n);
+  fuzz("tokenizer", fuzzCommandTokenizer, COMMAND_CORPUS, COMMAND_CORPUS_N);
+  fuzz("controller", fuzzReceiveCommand, CONTROLLER_CORPUS, CONTROLLER_CORPUS_N);
+  fuzz("serial", fuzzSerialParser, SERIAL_CORPUS, SERIAL_CORPUS_N);
+}
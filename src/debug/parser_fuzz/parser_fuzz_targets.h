@@ -0,0 +1,131 @@
+#pragma once
+/*
+ * Seed corpora, fuzz targets and mutator shared by the on-device fuzzer (parser_fuzz.cpp)
+ * and the host fuzzer with address sanitizer (tests/fuzz_parser.cpp, make -C tests fuzz_parser / fuzz).
+ * The fuzz*() functions have the same signature as libFuzzer's LLVMFuzzerTestOneInput.
+ * Call setupFuzzTargets() once first. The scale is added to the controller (data vector and commands)
+ * but the controller is never initialized (its state store is not started so state changes are never saved)
+ * and never updated (restart/reset commands are parsed but never executed).
+ */
+#include "LoggerController.h"
+#include "ChemglassScaleLoggerComponent.h"
+
+// seed corpus of the tokenizer (only tokenized, never executed)
+const char* COMMAND_CORPUS[] = {
+  "lock on", "lock off some notes", "state-log on", "data-log off",
+  "log-period 3 x", "log-period 20 s", "log-period 8 m notes", "log-period 1 h",
+  "read-period manual", "read-period 200 ms", "read-period 5 s", "read-period 2 m", "read-period scale 5 s",
+  "calc-rate off", "calc-rate m", "reset data", "unknown command with notes",
+  "averyveryverylongvariablenamethatexceedsthevariablebuffer value units notes",
+  "lock", "", " ", "  leading spaces", "log-period -1 s", "read-period 99999999999999 ms", "help; mem;;lock on"
+};
+const int COMMAND_CORPUS_N = sizeof(COMMAND_CORPUS) / sizeof(COMMAND_CORPUS[0]);
+
+// seed corpus of the controller (commands that do not change the state)
+const char* CONTROLLER_CORPUS[] = {
+  "help", "mem", "readers", "reset data", "unknown command with notes",
+  "averyveryverylongvariablenamethatexceedsthevariablebuffer value units notes",
+  "", " ", "  leading spaces", "log-period -1 s", "log-period 0 x", "read-period 99999999999999 ms",
+  "read-period nonexistent 5 s", "calc-rate never", "help; mem;;unknown", ";;;"
+};
+const int CONTROLLER_CORPUS_N = sizeof(CONTROLLER_CORPUS) / sizeof(CONTROLLER_CORPUS[0]);
+
+// seed corpus of the scale serial parser
+const char* SERIAL_CORPUS[] = {
+  "   123.45  GS\r\n", "  -  0.02  G \r\n", "     4.35  OS\r\n", "     1.00  CS\r\n",
+  "   12a.45  GS\r\n", "   123.4", "\r\n", "   123.45  GS\r\n   123.45  GS\r\n"
+};
+const int SERIAL_CORPUS_N = sizeof(SERIAL_CORPUS) / sizeof(SERIAL_CORPUS[0]);
+
+// maximum size of a fuzzed input (longer inputs are truncated)
+const size_t FUZZ_MAX_SIZE = 128;
+
+// controller and scale (no lcd, never initialized)
+LoggerControllerState controller_state(false, false, false, 3600, LOG_BY_TIME, 2000, 5000);
+LoggerDisplay lcd;
+LoggerController controller("fuzz 0.1", A5, &lcd, &controller_state);
+ScaleState scale_state(CALC_RATE_OFF);
+ChemglassScaleLoggerComponent scale("scale", &controller, &scale_state);
+LoggerCommand command;
+
+/*** targets ***/
+
+// adds the scale to the controller (sets up its data vector and registers its commands)
+void setupFuzzTargets() {
+  controller.addComponent(&scale);
+}
+
+// input as null-terminated text
+static void getFuzzText(char* text, const uint8_t* data, size_t size) {
+  if (size > FUZZ_MAX_SIZE) size = FUZZ_MAX_SIZE;
+  memcpy(text, data, size);
+  text[size] = 0;
+}
+
+// command tokenization
+int fuzzCommandTokenizer(const uint8_t* data, size_t size) {
+  char text[FUZZ_MAX_SIZE + 1];
+  getFuzzText(text, data, size);
+  String command_string(text);
+  command.load(command_string);
+  command.extractVariable();
+  command.extractValue();
+  command.extractUnits();
+  command.assignNotes();
+  return(0);
+}
+
+// full command processing in the controller (checks in the cloud handler, then the queued command runs)
+int fuzzReceiveCommand(const uint8_t* data, size_t size) {
+  char text[FUZZ_MAX_SIZE + 1];
+  getFuzzText(text, data, size);
+  String command_string(text);
+  if (controller.receiveCommand(command_string) < 0) {
+    // rejected commands still go through the parser
+    controller.executeCommand(text);
+  }
+  controller.processCommandQueue();
+  return(0);
+}
+
+// serial byte parser
+int fuzzSerialParser(const uint8_t* data, size_t size) {
+  scale.replaySerialData(data, (size > FUZZ_MAX_SIZE) ? FUZZ_MAX_SIZE : size);
+  return(0);
+}
+
+/*** mutations ***/
+
+uint8_t fuzz_input[FUZZ_MAX_SIZE];
+
+// random mutation of a seed into fuzz_input
+// @return the size of the mutated input
+size_t mutateFuzzInput(const char* seed) {
+  size_t size = strlen(seed);
+  if (size > FUZZ_MAX_SIZE) size = FUZZ_MAX_SIZE;
+  memcpy(fuzz_input, seed, size);
+  int n_mutations = 1 + random(4);
+  for (int i = 0; i < n_mutations; i++) {
+    int type = random(4);
+    if (type == 0 && size > 0) {
+      // flip a byte
+      fuzz_input[random(size)] = random(256);
+    } else if (type == 1 && size < FUZZ_MAX_SIZE) {
+      // insert a byte
+      size_t pos = random(size + 1);
+      memmove(fuzz_input + pos + 1, fuzz_input + pos, size - pos);
+      fuzz_input[pos] = random(256);
+      size++;
+    } else if (type == 2 && size > 0) {
+      // delete a byte
+      size_t pos = random(size);
+      memmove(fuzz_input + pos, fuzz_input + pos + 1, size - pos - 1);
+      size--;
+    } else if (type == 3) {
+      // append a repeated byte (long tokens)
+      uint8_t b = random(256);
+      while (size < FUZZ_MAX_SIZE && random(8) > 0) fuzz_input[size++] = b;
+    }
+  }
+  return(size);
+}
@@ -0,0 +1,143 @@
+/*
+ * Replays recorded chemglass scale serial frames through the scale parser (no balance needed).
+ * To record frames from a device in the field, call scale->captureSerial() in its setup
+ * and save its serial output. The CAPTURE lines of that log can be sent to this program over
+ * USB serial as is (e.g. cat capture.log > /dev/ttyACM0): the bytes between two REQUEST lines
+ * (or a REQUEST line and an empty line) are replayed as one frame.
+ * Each frame goes through the component's regular read steps (parsing, data, read statistics, data variable).
+ * The same replay runs on the host in tests/test_replay.cpp.
+ * Frames that should always be part of the replay and the throughput measurement go into REPLAY_FRAMES below.
+ */
+#pragma SPARK_NO_PREPROCESSOR // disable spark preprocssor to avoid issues with callbacks
+
+#include "application.h"
+#include "LoggerController.h"
+#include "ChemglassScaleLoggerComponent.h"
+
+// recorded frames (one entry per read, bytes exactly as received on Serial1)
+const char* REPLAY_FRAMES[] = {
+  "   123.45  GS\r\n",
+  "   123.47  GS\r\n",
+  "  -  0.02  G \r\n",
+  "     4.35  OS\r\n",
+  "   12a.45  GS\r\n", // corrupted value
+  "   123.45  XS\r\n", // unknown units
+  "   123.4",          // truncated frame
+};
+const int REPLAY_FRAMES_N = sizeof(REPLAY_FRAMES) / sizeof(REPLAY_FRAMES[0]);
+
+// how often to repeat all frames for the throughput measurement
+const int REPLAY_REPEATS = 1000;
+
+// frame received over USB serial (CAPTURE lines)
+const int CAPTURE_LINE_SIZE = 60;
+char capture_line[CAPTURE_LINE_SIZE];
+int capture_line_pos = 0;
+byte capture_frame[100];
+int capture_frame_size = 0;
+int capture_frames_n = 0;
+
+// controller (no lcd, never initialized - only provides debug flags to the component)
+LoggerControllerState controller_state(false, false, false, 3600, LOG_BY_TIME, 2000, 5000);
+LoggerDisplay lcd;
+LoggerController controller("replay 0.1", A5, &lcd, &controller_state);
+
+// scale
+ScaleState scale_state(CALC_RATE_OFF);
+ChemglassScaleLoggerComponent scale("scale", &controller, &scale_state);
+
+// manual wifi management
+SYSTEM_THREAD(ENABLED);
+SYSTEM_MODE(MANUAL);
+
+// replay a frame and report the result
+void replayFrame(const char* label, int i, const byte* frame, size_t size) {
+  int errors = scale.replaySerialData(frame, size);
+  if (errors < 0)
+    Serial.printlnf("INFO: %s #%d: incomplete", label, i);
+  else if (errors > 0)
+    Serial.printlnf("INFO: %s #%d: %d read errors", label, i, errors);
+  else
+    Serial.printlnf("INFO: %s #%d: %.4f %s", label, i, scale.data[0].newest_value, scale.data[0].getUnits());
+}
+
+// replay the bytes collected from CAPTURE lines so far (if any)
+void replayCaptureFrame() {
+  if (capture_frame_size > 0) {
+    capture_frames_n++;
+    replayFrame("captured frame", capture_frames_n, capture_frame, capture_frame_size);
+    capture_frame_size = 0;
+  }
+}
+
+// process one line of capture output ("CAPTURE: <ms> <hex bytes>" or "CAPTURE: <ms> REQUEST", other lines are ignored)
+void processCaptureLine(char* line) {
+  if (line[0] == 0) {
+    replayCaptureFrame();
+    return;
+  }
+  if (strncmp(line, "CAPTURE: ", 9) != 0) return;
+  char* value = strchr(line + 9, ' ');
+  if (value == NULL) return;
+  value++;
+  if (strcmp(value, "REQUEST") == 0) {
+    replayCaptureFrame();
+  } else {
+    for (char* hex = value; isxdigit(hex[0]) && isxdigit(hex[1]); hex += 2) {
+      if (capture_frame_size == (int) sizeof(capture_frame)) {
+        Serial.printlnf("WARNING: captured frame longer than %d bytes, discarding it", sizeof(capture_frame));
+        capture_frame_size = 0;
+        return;
+      }
+      char byte_text[3] = {hex[0], hex[1], 0};
+      capture_frame[capture_frame_size++] = (byte) strtol(byte_text, NULL, 16);
+    }
+  }
+}
+
+void setup() {
+
+  // serial
+  Serial.begin(9600);
+  waitFor(Serial.isConnected, 10000);
+  delay(1000);
+
+  // parse each frame once and report the result
+  Serial.println("INFO: replaying recorded frames...");
+  for (int i = 0; i < REPLAY_FRAMES_N; i++) {
+    replayFrame("frame", i + 1, (const byte*) REPLAY_FRAMES[i], strlen(REPLAY_FRAMES[i]));
+  }
+
+  // throughput of the parsing path (all frames)
+  int errors;
+  int n_frames = 0;
+  int n_errors = 0;
+  unsigned long start = micros();
+  for (int r = 0; r < REPLAY_REPEATS; r++) {
+    for (int i = 0; i < REPLAY_FRAMES_N; i++) {
+      errors = scale.replaySerialData((const byte*) REPLAY_FRAMES[i], strlen(REPLAY_FRAMES[i]));
+      if (errors != 0) n_errors++;
+      n_frames++;
+    }
+    scale.clearData(true);
+  }
+  unsigned long duration = micros() - start;
+  Serial.printlnf("INFO: parsed %d frames (%d with errors) in %lu us --> %.1f frames/s",
+    n_frames, n_errors, duration, 1e6 * n_frames / duration);
+  Serial.println("INFO: waiting for CAPTURE lines over serial...");
+}
+
+void loop() {
+  // collect CAPTURE lines from USB serial
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\r') continue;
+    if (c == '\n') {
+      capture_line[capture_line_pos] = 0;
+      processCaptureLine(capture_line);
+      capture_line_pos = 0;
+    } else if (capture_line_pos < CAPTURE_LINE_SIZE - 1) {
+      capture_line[capture_line_pos++] = c;
+    }
+  }
+}
@@ -31,7 +31,8 @@ class ChemglassScaleLoggerComponent : public ScaleLoggerComponent
             /* baud rate */             4800,
             /* serial config */         SERIAL_8N1,
             /* request command */       "#",
-            /* data pattern size */     sizeof(SCALE_DATA_PATTERN) / sizeof(SCALE_DATA_PATTERN[0]) - 1
+            /* data pattern size */     sizeof(SCALE_DATA_PATTERN) / sizeof(SCALE_DATA_PATTERN[0]) - 1,
+            /* weight decimals */       2
         ) {}
 
     /*** manage data ***/
@@ -46,6 +47,12 @@ void ChemglassScaleLoggerComponent::processNewByte() {
     // keep track of all data
     SerialReaderLoggerComponent::processNewByte();
 
+    // safety check (more bytes than the data pattern can hold)
+    if (data_pattern_pos > data_pattern_size) {
+        registerDataReadError();
+        return;
+    }
+
     // pattern interpretation
     char c = (char) new_byte;
     if ( SCALE_DATA_PATTERN[data_pattern_pos] == P_VAL && ( (new_byte >= B_0 && new_byte <= B_9) || c == ' ' || c == '+' || c == '-' || c == '.') ) {
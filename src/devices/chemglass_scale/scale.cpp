@@ -9,10 +9,10 @@
 #include "ChemglassScaleLoggerComponent.h"
 
 // display
-LoggerDisplay* lcd = new LoggerDisplay(20, 4);
+LoggerDisplay lcd(20, 4);
 
 // controller state
-LoggerControllerState* controller_state = new LoggerControllerState(
+LoggerControllerState controller_state(
   /* locked */                    false,
   /* state_logging */             true,
   /* data_logging */              false,
@@ -23,61 +23,61 @@ LoggerControllerState* controller_state = new LoggerControllerState(
 );
 
 // controller
-LoggerController* controller = new LoggerController(
+LoggerController controller(
   /* version */           "scale 0.8.0",
   /* reset pin */         A5,
-  /* lcd screen */        lcd,
-  /* pointer to state */  controller_state
+  /* lcd screen */        &lcd,
+  /* pointer to state */  &controller_state
 );
 
 // scale state
-ScaleState* scale_state = new ScaleState(
+ScaleState scale_state(
   /* calc_rate */         CALC_RATE_MIN
 );
 
 // scale component
-ChemglassScaleLoggerComponent* scale = new ChemglassScaleLoggerComponent(
+ChemglassScaleLoggerComponent scale(
   /* component name */        "scale", 
-  /* pointer to controller */ controller,
-  /* pointer to state */      scale_state
+  /* pointer to controller */ &controller,
+  /* pointer to state */      &scale_state
 );
 
 // data update callback function
 void data_update_callback() {
   // latest data
-  lcd->resetBuffer();
-  if (scale->data[0].newest_value_valid)
-    getDataDoubleText("Last", scale->data[0].newest_value, scale->data[0].units, 
-      lcd->buffer, sizeof(lcd->buffer), PATTERN_KVU_SIMPLE, scale->data[0].decimals - 1);
+  lcd.resetBuffer();
+  if (scale.data[0].newest_value_valid)
+    getDataDoubleText("Last", scale.data[0].newest_value, scale.data[0].getUnits(), 
+      lcd.buffer, sizeof(lcd.buffer), PATTERN_KVU_SIMPLE, scale.data[0].decimals - 1);
   else
-    strcpy(lcd->buffer, "Last: no data yet");
-  lcd->printLineFromBuffer(2);
+    strcpy(lcd.buffer, "Last: no data yet");
+  lcd.printLineFromBuffer(2);
 
   // running data
-  lcd->resetBuffer();
-  if (scale->data[0].getN() > 0)
-    getDataDoubleText("Avg", scale->data[0].getValue(), scale->data[0].units, scale->data[0].getN(), 
-      lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, scale->data[0].getDecimals());
+  lcd.resetBuffer();
+  if (scale.data[0].getN() > 0)
+    getDataDoubleText("Avg", scale.data[0].getValue(), scale.data[0].getUnits(), scale.data[0].getN(), 
+      lcd.buffer, sizeof(lcd.buffer), PATTERN_KVUN_SIMPLE, scale.data[0].getDecimals());
   else
-    strcpy(lcd->buffer, "Avg: no data yet");
-  lcd->printLineFromBuffer(3);
+    strcpy(lcd.buffer, "Avg: no data yet");
+  lcd.printLineFromBuffer(3);
 
   // rate
-  lcd->resetBuffer();
-  if (scale->state->calc_rate == CALC_RATE_OFF) {
-    if (scale->data[0].getN() > 1)
-      getDataDoubleText("SD", scale->data[0].getStdDev(), scale->data[0].units, scale->data[0].getN(),
-        lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, scale->data[0].getDecimals());
+  lcd.resetBuffer();
+  if (scale.state->calc_rate == CALC_RATE_OFF) {
+    if (scale.data[0].getN() > 1)
+      getDataDoubleText("SD", scale.data[0].getStdDev(), scale.data[0].getUnits(), scale.data[0].getN(),
+        lcd.buffer, sizeof(lcd.buffer), PATTERN_KVUN_SIMPLE, scale.data[0].getDecimals());
     else
-      strcpy(lcd->buffer, "SD: not enough data");
-    lcd->printLineFromBuffer(4);
+      strcpy(lcd.buffer, "SD: not enough data");
+    lcd.printLineFromBuffer(4);
   } else {
-    if (scale->data[1].newest_value_valid)
-      getDataDoubleText("Rate", scale->data[1].newest_value, scale->data[1].units, 
-        lcd->buffer, sizeof(lcd->buffer), PATTERN_KVU_SIMPLE, scale->data[1].decimals);
+    if (scale.data[1].newest_value_valid)
+      getDataDoubleText("Rate", scale.data[1].newest_value, scale.data[1].getUnits(), 
+        lcd.buffer, sizeof(lcd.buffer), PATTERN_KVU_SIMPLE, scale.data[1].decimals);
     else
-      strcpy(lcd->buffer, "Rate: not enough data");
-    lcd->printLineFromBuffer(4);
+      strcpy(lcd.buffer, "Rate: not enough data");
+    lcd.printLineFromBuffer(4);
   }
 }
 
@@ -95,27 +95,28 @@ void setup() {
   delay(1000);
 
   // debugging
-  //controller->forceReset();
-  //controller->debugDisplay();
-  controller->debugData();
-  controller->debugState();
-  controller->debugCloud();
-  //controller->debugWebhooks();
-  scale->debug();
+  //controller.forceReset();
+  //controller.debugDisplay();
+  controller.debugData();
+  controller.debugState();
+  controller.debugCloud();
+  //controller.debugWebhooks();
+  scale.debug();
+  //scale.captureSerial();
 
   // lcd temporary messages
-  lcd->setTempTextShowTime(3); // how many seconds temp time
+  lcd.setTempTextShowTime(3); // how many seconds temp time
 
   // callbacks
-  controller->setDataUpdateCallback(data_update_callback);
+  controller.setDataUpdateCallback(data_update_callback);
 
   // add components
-  controller->addComponent(scale);
+  controller.addComponent(&scale);
 
   // controller
-  controller->init();
+  controller.init();
 }
 
 void loop() {
-  controller->update();
+  controller.update();
 }
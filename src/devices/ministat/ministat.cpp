@@ -5,10 +5,10 @@
 #include "StepperLoggerComponent.h"
 
 // display
-LoggerDisplay* lcd = new LoggerDisplay(16, 2);
+LoggerDisplay lcd(16, 2);
 
 // controller state
-LoggerControllerState* controller_state = new LoggerControllerState(
+LoggerControllerState controller_state(
   /* locked */                    false,
   /* state_logging */             true,
   /* data_logging */              false,
@@ -17,15 +17,15 @@ LoggerControllerState* controller_state = new LoggerControllerState(
 );
 
 // controller
-LoggerController* controller = new LoggerController(
+LoggerController controller(
   /* version */           "ms 0.2",
   /* reset pin */         A5,
-  /* lcd screen */        lcd,
-  /* pointer to state */  controller_state
+  /* lcd screen */        &lcd,
+  /* pointer to state */  &controller_state
 );
 
 // board
-StepperBoard* board = new StepperBoard(
+StepperBoard board(
   /* dir */         D2,
   /* step */        D3,
   /* enable */      D7,
@@ -47,7 +47,7 @@ MicrostepMode DRV8834_MICROSTEP_MODES[DRV8834_MICROSTEP_MODES_N] =
   };
 
 // driver (DRV8825 chip)
-StepperDriver* driver = new StepperDriver(
+StepperDriver driver(
   /* dir cw */      HIGH,
   /* step on */     HIGH,
   /* enable on */   HIGH,
@@ -56,13 +56,13 @@ StepperDriver* driver = new StepperDriver(
 );
 
 // motor (STPM35)
-StepperMotor* motor = new StepperMotor(
+StepperMotor motor(
   /* steps */       48,  // 48 steps/rotation, 7.5 degree step angle
   /* gearing */      1
 );
 
 // stepper state
-StepperState* stepper_state = new StepperState(
+StepperState stepper_state(
   /* direction */                 DIR_CW, // start clockwise
   /* status */                    STATUS_OFF, // start off
   /* rpm */                       100 // start speed [rpm]
@@ -70,28 +70,28 @@ StepperState* stepper_state = new StepperState(
 );
 
 // stepper component
-StepperLoggerComponent* stirrer = new StepperLoggerComponent(
+StepperLoggerComponent stirrer(
   /* component name */        "stirrer", 
-  /* pointer to controller */ controller,
-  /* pointer to state */      stepper_state,
-  /* pointer to board */      board,
-  /* pointer to driver */     driver,
-  /* pointer to motor */      motor
+  /* pointer to controller */ &controller,
+  /* pointer to state */      &stepper_state,
+  /* pointer to board */      &board,
+  /* pointer to driver */     &driver,
+  /* pointer to motor */      &motor
 );
 
 // state update callback function
 char state_info[50];
 void state_update_callback() {
-  lcd->resetBuffer();
-  getStepperStateStatusInfo(stepper_state->status, state_info, sizeof(state_info), true); 
-  lcd->addToBuffer(state_info);
-  lcd->addToBuffer(" ");
-  getStepperStateSpeedInfo(stepper_state->rpm, state_info, sizeof(state_info), true);
-  lcd->addToBuffer(state_info);
-  lcd->addToBuffer(" ");
-  getStepperStateDirectionInfo(stepper_state->direction, state_info, sizeof(state_info), true);
-  lcd->addToBuffer(state_info);
-  lcd->printLineFromBuffer(2);
+  lcd.resetBuffer();
+  getStepperStateStatusInfo(stepper_state.status, state_info, sizeof(state_info), true); 
+  lcd.addToBuffer(state_info);
+  lcd.addToBuffer(" ");
+  getStepperStateSpeedInfo(stepper_state.rpm, state_info, sizeof(state_info), true);
+  lcd.addToBuffer(state_info);
+  lcd.addToBuffer(" ");
+  getStepperStateDirectionInfo(stepper_state.direction, state_info, sizeof(state_info), true);
+  lcd.addToBuffer(state_info);
+  lcd.printLineFromBuffer(2);
 
 }
 
@@ -109,27 +109,27 @@ void setup() {
   delay(1000);
 
   // debugging
-  //controller->forceReset();
-  //controller->debugDisplay();
-  controller->debugData();
-  controller->debugState();
-  controller->debugCloud();
-  //controller->debugWebhooks();
-  stirrer->debug();
+  //controller.forceReset();
+  //controller.debugDisplay();
+  controller.debugData();
+  controller.debugState();
+  controller.debugCloud();
+  //controller.debugWebhooks();
+  stirrer.debug();
 
   // lcd temporary messages
-  lcd->setTempTextShowTime(3); // how many seconds temp time
+  lcd.setTempTextShowTime(3); // how many seconds temp time
 
   // callbacks
-  controller->setStateUpdateCallback(state_update_callback);
+  controller.setStateUpdateCallback(state_update_callback);
 
   // add components
-  controller->addComponent(stirrer);
+  controller.addComponent(&stirrer);
 
   // controller
-  controller->init();
+  controller.init();
 }
 
 void loop() {
-  controller->update();
+  controller.update();
 }
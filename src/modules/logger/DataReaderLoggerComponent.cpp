@@ -1,41 +1,332 @@
 #include "application.h"
 #include "DataReaderLoggerComponent.h"
 
+// upper bounds of the latency histogram bins (in ms)
+static const unsigned long latency_bounds[DATA_READ_LATENCY_BINS - 1] = DATA_READ_LATENCY_BOUNDS;
+
+/*** setup ***/
+
+bool DataReaderLoggerComponent::isDataReader() {
+    return(true);
+}
+
+void DataReaderLoggerComponent::init() {
+    LoggerComponent::init();
+    addDisplayPage();
+}
+
+void DataReaderLoggerComponent::setDataReadPeriod(unsigned long period) {
+    reader_state.default_period = false;
+    reader_state.data_reading_period = period;
+}
+
+void DataReaderLoggerComponent::setDataReadPhase(uint8_t slot, uint8_t slots) {
+    read_phase_slot = slot;
+    read_phase_slots = (slots > 0) ? slots : 1;
+}
+
+void DataReaderLoggerComponent::setDataReadPipelineDepth(uint8_t depth) {
+    if (depth < 1 || depth > DATA_READ_PIPELINE_MAX) {
+        Serial.printlnf("ERROR: component '%s' read pipeline depth must be between 1 and %d, keeping %d", id, DATA_READ_PIPELINE_MAX, read_pipeline_depth);
+        return;
+    }
+    read_pipeline_depth = depth;
+}
+
+void DataReaderLoggerComponent::setDataReadTimeout(unsigned long timeout) {
+    read_timeout = timeout;
+}
+
+void DataReaderLoggerComponent::setDataReadRetries(uint8_t retries) {
+    read_retries = retries;
+}
+
+void DataReaderLoggerComponent::setDataReadBackoff(unsigned long backoff_min, unsigned long backoff_max) {
+    read_backoff_min = backoff_min;
+    read_backoff_max = (backoff_max > backoff_min) ? backoff_max : backoff_min;
+}
+
+void DataReaderLoggerComponent::setDataReadCadencePolicy(uint8_t policy) {
+    read_cadence_policy = policy;
+}
+
+/*** state management ***/
+
+void DataReaderLoggerComponent::setStateKey(uint16_t key) {
+    LoggerComponent::setStateKey(key);
+    char reader_id[40];
+    snprintf(reader_id, sizeof(reader_id), "%s %s", id, CMD_DATA_READ_PERIOD);
+    reader_state_key = LoggerStateStore::getKey(reader_id);
+}
+
+size_t DataReaderLoggerComponent::getStateStoreSize() {
+    return(LoggerComponent::getStateStoreSize() + sizeof(reader_state) + STATE_STORE_RECORD_OVERHEAD);
+}
+
+void DataReaderLoggerComponent::loadState(bool reset) {
+    LoggerComponent::loadState(reset);
+    if (!reset) restoreReaderState();
+    else saveReaderState();
+}
+
+void DataReaderLoggerComponent::resetState() {
+    // version 0 = reset request (back to the default on restart)
+    ctrl->state_store.save(reader_state_key, 0, &reader_state, sizeof(reader_state));
+}
+
+size_t DataReaderLoggerComponent::getStateSnapshotSize() {
+    return(LoggerComponent::getStateSnapshotSize() + sizeof(reader_state));
+}
+
+void DataReaderLoggerComponent::snapshotState(uint8_t* target) {
+    LoggerComponent::snapshotState(target);
+    memcpy(target + LoggerComponent::getStateSnapshotSize(), &reader_state, sizeof(reader_state));
+}
+
+bool DataReaderLoggerComponent::rollbackState(const uint8_t* source) {
+    bool changed = LoggerComponent::rollbackState(source);
+    const uint8_t* saved = source + LoggerComponent::getStateSnapshotSize();
+    if (memcmp(&reader_state, saved, sizeof(reader_state)) != 0) {
+        memcpy(&reader_state, saved, sizeof(reader_state));
+        changed = true;
+    }
+    // always saved (also undoes a reset request, the read cadence follows the restored period on the next update)
+    saveReaderState();
+    return(changed);
+}
+
+void DataReaderLoggerComponent::saveReaderState() {
+    bool saved = ctrl->state_store.save(reader_state_key, DATA_READER_STATE_VERSION, &reader_state, sizeof(reader_state));
+    if (ctrl->debug_state && saved) {
+        Serial.printf("DEBUG: component '%s' reader state saved in memory (if any updates were necessary)\n", id);
+    }
+}
+
+bool DataReaderLoggerComponent::restoreReaderState() {
+    uint8_t saved_version;
+    size_t saved_size;
+    const uint8_t* saved = ctrl->state_store.load(reader_state_key, &saved_version, &saved_size);
+    bool recoverable = saved != NULL && saved_version == DATA_READER_STATE_VERSION && saved_size == sizeof(reader_state);
+    if (recoverable) {
+        memcpy(&reader_state, saved, sizeof(reader_state));
+        Serial.printf("INFO: successfully restored component '%s' reader state from memory (%s read period)\n", id, reader_state.default_period ? "default" : "own");
+    } else {
+        saveReaderState();
+    }
+    return(recoverable);
+}
+
+/*** state changes ***/
+
+bool DataReaderLoggerComponent::changeDataReadingPeriod(int period) {
+    bool changed = reader_state.default_period || period != reader_state.data_reading_period;
+
+    if (changed) {
+        reader_state.default_period = false;
+        reader_state.data_reading_period = period;
+    }
+
+    if (ctrl->debug_state) {
+        if (changed) Serial.printf("DEBUG: setting component '%s' data reading period to %d ms\n", id, period);
+        else Serial.printf("DEBUG: component '%s' data reading period unchanged (%d ms)\n", id, period);
+    }
+
+    // rare command --> save right away
+    if (changed) saveReaderState();
+
+    return(changed);
+}
+
+bool DataReaderLoggerComponent::resetDataReadingPeriod() {
+    bool changed = !reader_state.default_period;
+
+    if (changed) {
+        reader_state.default_period = true;
+    }
+
+    if (ctrl->debug_state) {
+        if (changed) Serial.printf("DEBUG: component '%s' back to the controller's data reading period\n", id);
+        else Serial.printf("DEBUG: component '%s' already uses the controller's data reading period\n", id);
+    }
+
+    if (changed) saveReaderState();
+
+    return(changed);
+}
+
+bool DataReaderLoggerComponent::hasOwnDataReadPeriod() {
+    return(!reader_state.default_period);
+}
+
 /*** loop ***/
 
 void DataReaderLoggerComponent::update() {
     
     // only run if the whole controller is set up as data reader
     if (ctrl->state->data_reader) {
-        
-        // process data read status
-        if (data_read_status == DATA_READ_COMPLETE) {
-            // read is complete, finalize data
-            completeDataRead();
-        } else if (data_read_status == DATA_READ_WAITING && (millis() - data_read_start) > ctrl->state->data_reading_period) {
+        // run the state machine to quiescence so e.g. complete -> idle -> next request happen in the same loop
+        for (uint8_t step = 0; step < DATA_READ_MAX_STEPS && stepDataRead(); step++);
+    }
+}
+
+bool DataReaderLoggerComponent::stepDataRead() {
+
+    uint8_t status = data_read_status;
+
+    // send the next request if it is due (even if earlier responses are still outstanding)
+    bool requested = isTimeForDataRequest();
+    if (requested) {
+        requestDataRead();
+    }
+    
+    // process data read status
+    if (data_read_status == DATA_READ_COMPLETE) {
+        // read is complete, finalize data
+        completeDataRead();
+    } else if (data_read_status == DATA_READ_WAITING) {
+        // read data (a response that is already in counts even if this loop pass came after the timeout)
+        readData();
+        if (data_read_status == DATA_READ_WAITING && getDataReadTimeout() > 0 && (millis() - data_read_start) > getDataReadTimeout()) {
             // encountered a timeout
             handleDataReadTimeout();
-        } else if (data_read_status == DATA_READ_WAITING) {
-            // read data
-            readData();
-        } else if (data_read_status == DATA_READ_IDLE && (isManualDataReader() || (millis() - data_read_start) > ctrl->state->data_reading_period)) {
-            // data reader is idle and either manual or it has been since the data read period
-            data_read_status = DATA_READ_REQUEST;
-        } else if (data_read_status == DATA_READ_IDLE) {
-            // idle data read but not yet time for a new request
-            idleDataRead();
-        } else if (data_read_status == DATA_READ_REQUEST) {
-            // new data read request
-            initiateDataRead();
         }
-
+    } else if (data_read_status == DATA_READ_IDLE && (isManualDataReader() || read_requests_n > 0)) {
+        // data reader is idle and either manual or there is an outstanding request
+        data_read_status = DATA_READ_REQUEST;
+    } else if (data_read_status == DATA_READ_IDLE) {
+        // idle data read but not yet time for a new request
+        idleDataRead();
+    } else if (data_read_status == DATA_READ_REQUEST) {
+        // start reading the response
+        initiateDataRead();
     }
+
+    return(requested || data_read_status != status);
 }
 
 /*** read data ***/
 
 bool DataReaderLoggerComponent::isManualDataReader() {
-    return(ctrl->state->data_reading_period == READ_MANUAL);
+    return(getDataReadPeriod() == READ_MANUAL);
+}
+
+unsigned long DataReaderLoggerComponent::getDataReadPeriod() {
+    return((reader_state.default_period) ? ctrl->state->data_reading_period : reader_state.data_reading_period);
+}
+
+bool DataReaderLoggerComponent::isTimeForDataRequest() {
+    if (isManualDataReader() || read_requests_n >= read_pipeline_depth) return(false);
+    if (read_retry_pending) return(true);
+    if (read_cadence_period != getDataReadPeriod()) startDataReadCadence();
+    return((long) (millis() - read_deadline) >= 0);
+}
+
+/*** read cadence ***/
+
+void DataReaderLoggerComponent::startDataReadCadence() {
+    read_cadence_period = getDataReadPeriod();
+    // first deadline at the reader's phase (aligned to the clock so readers with the same period stay staggered when one of them restarts)
+    unsigned long now = millis();
+    read_cadence_start = (read_cadence_period > 0) ?
+        now + (getDataReadPhase() + read_cadence_period - now % read_cadence_period) % read_cadence_period : now;
+    read_deadline = read_cadence_start;
+    read_cadence_requests = 0;
+    read_cadence_skipped = 0;
+    read_start_jitter.clear();
+}
+
+unsigned long DataReaderLoggerComponent::getDataReadPhase() {
+    return(read_cadence_period * read_phase_slot / read_phase_slots);
+}
+
+float DataReaderLoggerComponent::getNominalDataReadRate() {
+    return((isManualDataReader()) ? 0.0 : 1000.0 / getDataReadPeriod());
+}
+
+float DataReaderLoggerComponent::getAchievedDataReadRate() {
+    unsigned long elapsed = millis() - read_cadence_start;
+    return((elapsed > 0 && read_cadence_requests > 0) ? 1000.0 * read_cadence_requests / elapsed : 0.0);
+}
+
+unsigned long DataReaderLoggerComponent::getDataReadTimeout() {
+    if (read_timeout > 0) return(read_timeout);
+    // a request can wait as long as the pipeline takes to cycle through (one read period without pipelining)
+    // manual readers wait for the instrument
+    return(getDataReadPeriod() * read_pipeline_depth);
+}
+
+void DataReaderLoggerComponent::registerDataReadOutcome(bool success) {
+    if (success) {
+        read_retry = 0;
+        // recover gradually (an instrument that keeps flapping stays slowed down)
+        if (read_backoff > 0 && ++read_successes >= DATA_READ_BACKOFF_RECOVERY) {
+            read_successes = 0;
+            read_backoff = (read_backoff / 2 >= read_backoff_min) ? read_backoff / 2 : 0;
+            if (read_backoff == 0) Serial.printlnf("INFO: component '%s' data reads recovered, back to the full read rate", id);
+        }
+        return;
+    }
+    read_successes = 0;
+    // every failed attempt slows down the reads (also the ones that are retried)
+    if (read_backoff_min > 0) {
+        read_backoff = (read_backoff == 0) ? read_backoff_min : read_backoff * 2;
+        if (read_backoff > read_backoff_max) read_backoff = read_backoff_max;
+    }
+    if (read_retry < read_retries && !isManualDataReader()) {
+        // try again right away
+        read_retry++;
+        read_retry_pending = true;
+        Serial.printlnf("INFO: component '%s' retrying data read (retry %d of %d)", id, read_retry, read_retries);
+    } else {
+        read_retry = 0;
+        if (read_backoff > 0) Serial.printlnf("WARNING: component '%s' data read failed, slowing down reads by %lu ms", id, read_backoff);
+    }
+}
+
+DataReadRequest* DataReaderLoggerComponent::getDataReadRequest() {
+    if (read_requests_n == 0) return(NULL);
+    return(&read_requests[read_requests_first]);
+}
+
+void DataReaderLoggerComponent::popDataReadRequest() {
+    if (read_requests_n == 0) return;
+    read_requests_first = (read_requests_first + 1) % DATA_READ_PIPELINE_MAX;
+    read_requests_n--;
+}
+
+void DataReaderLoggerComponent::requestDataRead() {
+    DataReadRequest* request = &read_requests[(read_requests_first + read_requests_n) % DATA_READ_PIPELINE_MAX];
+    read_request_id++;
+    if (read_request_id == 0) read_request_id = 1; // 0 = no request yet
+    request->id = read_request_id;
+    request->start = millis();
+    request->time = millis64();
+    read_requests_n++;
+
+    // cadence (retries are extra requests that do not count towards it)
+    if (!read_retry_pending) {
+        read_start_jitter.add((long) (request->start - read_deadline));
+        read_cadence_requests++;
+        unsigned long period = getDataReadPeriod() + read_backoff;
+        read_deadline += period;
+        if ((long) (request->start - read_deadline) >= 0) {
+            // missed deadlines (loop was busy, instrument slower than the period, etc.)
+            unsigned long missed = (request->start - read_deadline) / period + 1;
+            unsigned long skip = (read_cadence_policy == DATA_READ_CATCH_UP) ?
+                ((missed > DATA_READ_CATCH_UP_MAX) ? missed - DATA_READ_CATCH_UP_MAX : 0) : missed;
+            read_deadline += skip * period;
+            read_cadence_skipped += skip;
+        }
+    }
+    read_retry_pending = false;
+    if (ctrl->debug_data) {
+        Serial.printlnf("DEBUG: sending data read request #%d for component '%s' (%d outstanding)", request->id, id, read_requests_n);
+    }
+    sendDataRequest();
+}
+
+void DataReaderLoggerComponent::sendDataRequest() {
+    // send the instrument specific request in derived classes
 }
 
 void DataReaderLoggerComponent::idleDataRead() {
@@ -44,15 +335,18 @@ void DataReaderLoggerComponent::idleDataRead() {
 }
 
 void DataReaderLoggerComponent::initiateDataRead() {
+    DataReadRequest* request = getDataReadRequest();
     if (ctrl->debug_data) {
-        (isManualDataReader()) ?
+        (request == NULL) ?
             Serial.printf("DEBUG: starting data read for component '%s' (manual mode)", id) :
-            Serial.printf("DEBUG: starting data read for component '%s' ", id);
-        Serial.println(Time.format(Time.now(), "at %Y-%m-%d %H:%M:%S %Z"));
+            Serial.printf("DEBUG: starting data read for request #%d of component '%s' ", request->id, id);
+        Serial.println(getLocalTimeText("at %Y-%m-%d %H:%M:%S %z"));
     }
-    data_read_start = millis();
+    // timeout counts from the request (the response might already be on its way)
+    data_read_start = (request != NULL) ? request->start : millis();
     data_read_status = DATA_READ_WAITING;
     error_counter = 0;
+    read_stats.reads++;
 }
 
 void DataReaderLoggerComponent::readData() {
@@ -63,32 +357,120 @@ void DataReaderLoggerComponent::readData() {
 void DataReaderLoggerComponent::completeDataRead() {
     if (ctrl->debug_data) {
         Serial.printf("DEBUG: finished data read with %d errors for component '%s' at ", error_counter, id);
-        Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+        Serial.println(getLocalTimeText());
     }
     data_read_status = DATA_READ_IDLE;
     finishData();
+    popDataReadRequest();
+    read_stats.completes++;
+    read_stats.errors += error_counter;
+    registerDataReadLatency(millis() - data_read_start);
+    registerDataReadOutcome(error_counter == 0);
     ctrl->updateDataVariable();
+    markDisplayPageDirty();
 }
 
 void DataReaderLoggerComponent::registerDataReadError() {
     error_counter++;
     Serial.printf("ERROR: component '%s' encountered an error (#%d) trying to read data at ", id, error_counter);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(getLocalTimeText());
     ctrl->lcd->printLineTemp(1, "ERR: data read error");
 }
 
 void DataReaderLoggerComponent::handleDataReadTimeout() {
     Serial.printf("WARNING: data reading period exceeded with %d errors for component '%s' at ", error_counter, id);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(getLocalTimeText());
     ctrl->lcd->printLineTemp(1, "ERR: timeout read");
-    // go back to idle
+    // go back to idle (and give up on the request, the next response is matched to the next request)
     data_read_status = DATA_READ_IDLE;
+    popDataReadRequest();
+    read_stats.timeouts++;
+    read_stats.errors += error_counter;
+    registerDataReadOutcome(false);
+}
+
+/*** read statistics ***/
+
+void DataReaderLoggerComponent::registerDataReadLatency(unsigned long latency) {
+    uint8_t bin = 0;
+    while (bin < DATA_READ_LATENCY_BINS - 1 && latency > latency_bounds[bin]) bin++;
+    read_stats.latency[bin]++;
+}
+
+const DataReadStats* DataReaderLoggerComponent::getDataReadStats() {
+    return(&read_stats);
+}
+
+// latency that the fraction of completed reads did not exceed (bin upper bound)
+static void getDataReadLatencyPercentileText(const DataReadStats* stats, float fraction, char* target, int size) {
+    unsigned long count = 0;
+    for (uint8_t bin = 0; bin < DATA_READ_LATENCY_BINS; bin++) {
+        count += stats->latency[bin];
+        if (count > 0 && count >= fraction * stats->completes) {
+            (bin < DATA_READ_LATENCY_BINS - 1) ?
+                snprintf(target, size, "<=%lums", latency_bounds[bin]) :
+                snprintf(target, size, ">%lums", latency_bounds[DATA_READ_LATENCY_BINS - 2]);
+            return;
+        }
+    }
+    snprintf(target, size, "-");
+}
+
+void DataReaderLoggerComponent::getDataReadStatsText(char* target, int size) {
+    int i = snprintf(target, size, "{\"k\":\"%s reads\",\"v\":[%lu,%lu,%lu,%lu]},{\"k\":\"%s latency\",\"v\":[",
+        id, read_stats.reads, read_stats.completes, read_stats.timeouts, read_stats.errors, id);
+    for (uint8_t bin = 0; bin < DATA_READ_LATENCY_BINS && i >= 0 && i < size; bin++) {
+        i += snprintf(target + i, size - i, (bin == 0) ? "%lu" : ",%lu", read_stats.latency[bin]);
+    }
+    if (i >= 0 && i < size) snprintf(target + i, size - i, "]}");
+}
+
+void DataReaderLoggerComponent::getDataReadSummaryText(char* target, int size) {
+    char p50[12];
+    char p95[12];
+    getDataReadLatencyPercentileText(&read_stats, 0.50, p50, sizeof(p50));
+    getDataReadLatencyPercentileText(&read_stats, 0.95, p95, sizeof(p95));
+    snprintf(target, size, "%s %lu/%lu p50%s p95%s", id, read_stats.completes, read_stats.reads, p50, p95);
+}
+
+void DataReaderLoggerComponent::getDataReadLatencyBoundsText(char* target, int size) {
+    int i = 0;
+    for (uint8_t bin = 0; bin < DATA_READ_LATENCY_BINS - 1 && i >= 0 && i < size; bin++) {
+        i += snprintf(target + i, size - i, (bin == 0) ? "%lu" : ",%lu", latency_bounds[bin]);
+    }
+    if (i >= 0 && i < size) snprintf(target + i, size - i, ",>%lu ms", latency_bounds[DATA_READ_LATENCY_BINS - 2]);
+}
+
+/*** logger state variable ***/
+
+void DataReaderLoggerComponent::assembleStateVariable() {
+    char pair[80];
+    char key[30];
+    char value[40];
+    if (hasOwnDataReadPeriod()) {
+        snprintf(key, sizeof(key), "%s %s", id, CMD_DATA_READ_PERIOD);
+        getStateDataReadingPeriodText(key, getDataReadPeriod(), pair, sizeof(pair));
+        ctrl->addToStateVariableBuffer(pair);
+    }
+    snprintf(key, sizeof(key), "%s reads", id);
+    snprintf(value, sizeof(value), "[%lu,%lu,%lu,%lu]", read_stats.reads, read_stats.completes, read_stats.timeouts, read_stats.errors);
+    getStateStringText(key, value, pair, sizeof(pair), PATTERN_KV_JSON, true);
+    ctrl->addToStateVariableBuffer(pair);
+    if (!isManualDataReader()) {
+        snprintf(key, sizeof(key), "%s cadence", id);
+        snprintf(value, sizeof(value), "[%.3f,%.3f,%.1f,%.1f,%lu]", getAchievedDataReadRate(), getNominalDataReadRate(),
+            read_start_jitter.getMean(), read_start_jitter.getStdDev(), (unsigned long) read_start_jitter.max);
+        getStateStringText(key, value, pair, sizeof(pair), PATTERN_KV_JSON, true);
+        ctrl->addToStateVariableBuffer(pair);
+    }
 }
 
 /*** manage data ***/
 
 void DataReaderLoggerComponent::startData() {
-    unsigned long start_time = millis();
+    // data time: when the matching request was sent (manual reads: when the data started coming in)
+    DataReadRequest* request = getDataReadRequest();
+    uint64_t start_time = (request != NULL) ? request->time : millis64();
     for (int i=0; i < data.size(); i++) data[i].setNewestDataTime(start_time);
 }
 
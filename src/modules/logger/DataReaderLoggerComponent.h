@@ -10,6 +10,83 @@
 #define DATA_READ_TIMEOUT   4 // read timed out
 #define DATA_READ_ERROR     5 // encountered an error
 
+// state machine steps (the read state machine runs until nothing changes anymore, at most this many steps per update)
+#define DATA_READ_MAX_STEPS 8
+
+// read cadence policies (requests are due at fixed deadlines, what to do if deadlines were missed)
+#define DATA_READ_SKIP         0 // skip the missed reads (the next read is at the next deadline)
+#define DATA_READ_CATCH_UP     1 // make up for the missed reads right away (skips any beyond DATA_READ_CATCH_UP_MAX)
+#define DATA_READ_CATCH_UP_MAX 3 // maximum number of missed reads that are made up for
+
+// read backoff recovery (the backoff halves after this many successful reads in a row)
+#define DATA_READ_BACKOFF_RECOVERY 2
+
+// request pipelining (requests sent before the responses to earlier requests are in)
+#ifndef DATA_READ_PIPELINE_MAX
+#define DATA_READ_PIPELINE_MAX 4 // maximum number of outstanding requests
+#endif
+
+// data reader state (own state store record, independent of the state of the derived component)
+#define DATA_READER_STATE_VERSION 1
+struct DataReaderState {
+  bool default_period = true; // whether the reader uses the controller's read period
+  uint data_reading_period = READ_MANUAL; // the reader's own read period (in ms) [only relevant if not default_period]
+};
+
+// read latency histogram (request to DATA_READ_COMPLETE, bin upper bounds in ms, the last bin holds anything slower)
+#define DATA_READ_LATENCY_BINS 10
+#define DATA_READ_LATENCY_BOUNDS {10, 20, 50, 100, 200, 500, 1000, 2000, 5000}
+
+// cumulative read statistics (since startup)
+struct DataReadStats {
+  unsigned long reads = 0; // reads started
+  unsigned long completes = 0; // reads completed (with or without errors)
+  unsigned long timeouts = 0; // reads that timed out
+  unsigned long errors = 0; // errors encountered (a read can have several)
+  unsigned long latency[DATA_READ_LATENCY_BINS] = {}; // completed reads by latency
+};
+
+// how late the scheduled requests went out (in ms after their deadline), integer sums so a read costs no floating point
+// math (mean and standard deviation are only calculated when reported)
+struct DataReadJitter {
+  uint32_t n = 0; // requests
+  int64_t sum = 0; // in ms
+  int64_t sum_sq = 0; // in ms^2
+  uint32_t max = 0; // in ms
+
+  void clear() {
+    n = 0;
+    sum = 0;
+    sum_sq = 0;
+    max = 0;
+  }
+
+  void add(long late) {
+    if (late < 0) late = 0; // ahead of the deadline (e.g. a manual read) counts as on time
+    n++;
+    sum += late;
+    sum_sq += (int64_t) late * late;
+    if ((uint32_t) late > max) max = late;
+  }
+
+  float getMean() {
+    return((n > 0) ? (float) sum / n : 0.0);
+  }
+
+  float getStdDev() {
+    if (n < 2) return(0.0);
+    double variance = ((double) sum_sq - (double) sum * sum / n) / (n - 1);
+    return((variance > 0) ? sqrt(variance) : 0.0);
+  }
+};
+
+// outstanding data read request
+struct DataReadRequest {
+  uint8_t id; // request id (counts up, wraps around)
+  unsigned long start; // millis() when the request was sent
+  uint64_t time; // millis64() when the request was sent (data time of the response)
+};
+
 
 /* component */
 class DataReaderLoggerComponent : public LoggerComponent
@@ -22,24 +99,111 @@ class DataReaderLoggerComponent : public LoggerComponent
     unsigned long data_read_start = 0; // time the read started
     unsigned int error_counter = 0; // number of errors encountered during the read
 
+    // request pipeline (responses are matched to the requests in order, the oldest request is the one being read)
+    uint8_t read_pipeline_depth = 1; // how many requests can be outstanding
+    DataReadRequest read_requests[DATA_READ_PIPELINE_MAX];
+    uint8_t read_requests_first = 0; // oldest outstanding request
+    uint8_t read_requests_n = 0; // number of outstanding requests
+    uint8_t read_request_id = 0; // id of the latest request
+    DataReadRequest* getDataReadRequest(); // oldest outstanding request (NULL if none)
+    void popDataReadRequest();
+
+    // data reader state
+    DataReaderState reader_state;
+    uint16_t reader_state_key; // key of the reader state record in the controller's state store
+    void saveReaderState();
+    bool restoreReaderState();
+
+    // read phase (readers are staggered evenly across their read periods so their requests don't pile up in the same loop)
+    uint8_t read_phase_slot = 0; // position among the controller's data readers
+    uint8_t read_phase_slots = 1; // number of data readers
+    unsigned long getDataReadPhase(); // offset of the deadlines into the read period (in ms)
+
+    // read cadence (next deadline = previous deadline + period, independent of when the request actually went out)
+    uint8_t read_cadence_policy = DATA_READ_SKIP;
+    unsigned long read_deadline = 0; // when the next request is due
+    unsigned long read_cadence_period = 0; // read period the cadence was started with (restarts if the period changes)
+    unsigned long read_cadence_start = 0; // when the cadence was started
+    unsigned long read_cadence_requests = 0; // scheduled requests since the cadence started (without retries)
+    unsigned long read_cadence_skipped = 0; // deadlines skipped since the cadence started
+    DataReadJitter read_start_jitter; // how late the requests went out (since the cadence started)
+    void startDataReadCadence();
+
+    // read policy
+    unsigned long read_timeout = 0; // how long a request can wait for its response (in ms, 0 = read period x pipeline depth)
+    uint8_t read_retries = 0; // how often a failed read is retried right away (before it counts as failed)
+    unsigned long read_backoff_min = 0; // delay added to the read period after a failed read (in ms, 0 = no backoff)
+    unsigned long read_backoff_max = 0; // maximum delay (doubles with each failed read, halves after DATA_READ_BACKOFF_RECOVERY successful reads in a row)
+    uint8_t read_retry = 0; // retries of the current read so far
+    bool read_retry_pending = false; // retry request due right away
+    unsigned long read_backoff = 0; // current backoff (in ms)
+    uint8_t read_successes = 0; // successful reads in a row (towards backoff recovery)
+
+    // read outcomes
+    DataReadStats read_stats;
+    void registerDataReadLatency(unsigned long latency);
+    void registerDataReadOutcome(bool success); // retry / backoff bookkeeping
+
   public:
 
     /*** constructors ***/
     // data clearing usually managed automatically -> set to true
     DataReaderLoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset) : LoggerComponent(id, ctrl, data_have_same_time_offset, true) {}
 
+    /*** setup ***/
+    virtual bool isDataReader();
+    virtual void init();
+    void setDataReadPeriod(unsigned long period); // the reader's own read period (in ms, READ_MANUAL = manual), default is the controller's read period, restored state takes precedence
+    void setDataReadPhase(uint8_t slot, uint8_t slots); // set by the controller for each data reader
+    void setDataReadPipelineDepth(uint8_t depth); // up to DATA_READ_PIPELINE_MAX requests outstanding (default 1 = wait for each response before the next request)
+    void setDataReadTimeout(unsigned long timeout); // in ms (default 0 = read period x pipeline depth, manual readers never time out unless set)
+    void setDataReadRetries(uint8_t retries); // how often a timed out or erroneous read is re-requested right away (default 0)
+    void setDataReadBackoff(unsigned long backoff_min, unsigned long backoff_max); // slow down reads of a failing instrument (in ms, default 0 = off)
+    void setDataReadCadencePolicy(uint8_t policy); // DATA_READ_SKIP (default) or DATA_READ_CATCH_UP
+
+    /*** state management ***/
+    virtual void setStateKey(uint16_t key);
+    virtual size_t getStateStoreSize();
+    virtual void loadState(bool reset = false);
+    virtual void resetState();
+    virtual size_t getStateSnapshotSize(); // component state + reader state
+    virtual void snapshotState(uint8_t* target);
+    virtual bool rollbackState(const uint8_t* source);
+
+    /*** state changes ***/
+    bool changeDataReadingPeriod(int period); // own read period (in ms, READ_MANUAL = manual)
+    bool resetDataReadingPeriod(); // back to the controller's read period
+    bool hasOwnDataReadPeriod();
+
     /*** loop ***/
     virtual void update();
+    bool stepDataRead(); // one step of the read state machine, @return whether anything changed (new request or status)
 
     /*** read data ***/
     virtual bool isManualDataReader();
+    virtual unsigned long getDataReadPeriod(); // in ms (own read period or the controller's)
+    float getNominalDataReadRate(); // reads per second
+    float getAchievedDataReadRate(); // scheduled requests per second since the cadence started
+    virtual bool isTimeForDataRequest(); // whether the next request is due (and the pipeline has room for it)
+    virtual unsigned long getDataReadTimeout(); // how long a request can wait for its response (in ms)
+    virtual void requestDataRead(); // sends a request (see sendDataRequest) and adds it to the pipeline
+    virtual void sendDataRequest(); // instrument specific request (override in derived classes)
     virtual void idleDataRead();
-    virtual void initiateDataRead();
+    virtual void initiateDataRead(); // start reading the response to the oldest request (or the manual read)
     virtual void readData();
     virtual void completeDataRead();
     virtual void registerDataReadError();
     virtual void handleDataReadTimeout();
 
+    /*** read statistics ***/
+    const DataReadStats* getDataReadStats();
+    void getDataReadStatsText(char* target, int size); // reads [reads, completes, timeouts, errors] and latency [histogram] json pairs
+    void getDataReadSummaryText(char* target, int size); // short version (completes/reads, latency p50 and p95)
+    static void getDataReadLatencyBoundsText(char* target, int size); // bin upper bounds of the latency histogram
+
+    /*** logger state variable ***/
+    virtual void assembleStateVariable(); // own read period (if any), reads [reads, completes, timeouts, errors] and cadence [achieved rate, nominal rate, jitter mean, jitter sd, jitter max]
+
     /*** manage data ***/
     virtual void startData();
     virtual void finishData();
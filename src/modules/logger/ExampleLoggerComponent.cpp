@@ -20,34 +20,30 @@ size_t ExampleLoggerComponent::getStateSize() {
     return(sizeof(*state));
 }
 
+void* ExampleLoggerComponent::getStateData() {
+    return(state);
+}
+
 void ExampleLoggerComponent::saveState() { 
-    EEPROM.put(eeprom_start, *state);
-    if (ctrl->debug_state) {
-        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
-    }
+    saveStateRecord(state, sizeof(*state), state->version);
 } 
 
 bool ExampleLoggerComponent::restoreState() {
-    ExampleState *saved_state = new ExampleState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState();
-    }
-    return(recoverable);
+    return(restoreStateRecord(state, sizeof(*state), &state->version));
 }
 
 void ExampleLoggerComponent::resetState() {
+    DataReaderLoggerComponent::resetState();
     state->version = 0; // force reset of state on restart
     saveState();
 }
 
 /*** command parsing ***/
 
+void ExampleLoggerComponent::registerCommands() {
+    registerCommand(CMD_SETTING, "setting yay/nay");
+}
+
 bool ExampleLoggerComponent::parseCommand(LoggerCommand *command) {
     return(parseSetting(command));
 }
@@ -80,7 +76,7 @@ bool ExampleLoggerComponent::changeStateSetting (bool on) {
             on ? Serial.println("DEBUG: setting already yay") : Serial.println("DEBUG: setting already nay");
     }
 
-    if (changed) saveState();
+    if (changed) markStateDirty();
 
     return(changed);
 }
@@ -96,6 +92,7 @@ void ExampleLoggerComponent::updateDisplayStateInformation() {
 /*** logger state variable ***/
 
 void ExampleLoggerComponent::assembleStateVariable() {
+    DataReaderLoggerComponent::assembleStateVariable();
     char pair[60];
     getStateSettingText(state->setting, pair, sizeof(pair)); ctrl->addToStateVariableBuffer(pair);
 }
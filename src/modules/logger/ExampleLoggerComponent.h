@@ -44,11 +44,13 @@ class ExampleLoggerComponent : public DataReaderLoggerComponent
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual void* getStateData();
     virtual void saveState();
     virtual bool restoreState();
     virtual void resetState();
 
     /*** command parsing ***/
+    virtual void registerCommands();
     virtual bool parseCommand(LoggerCommand *command);
     bool parseSetting(LoggerCommand *command);
 
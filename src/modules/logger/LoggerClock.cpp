@@ -0,0 +1,165 @@
+#include "application.h"
+#include "LoggerClock.h"
+#include <time.h>
+
+/*** monotonic clock ***/
+
+static uint32_t millis_last = 0;
+static uint32_t millis_overflows = 0;
+
+uint64_t millis64() {
+  uint32_t ms = millis();
+  if (ms < millis_last) millis_overflows++;
+  millis_last = ms;
+  return(((uint64_t) millis_overflows << 32) | ms);
+}
+
+uint64_t toMillis64(unsigned long ms) {
+  uint64_t now = millis64();
+  return(now - (uint32_t) ((uint32_t) now - ms));
+}
+
+/*** epoch mapping ***/
+
+static bool synced = false;
+static uint64_t anchor_local = 0; // millis64() time of the anchor
+static uint64_t anchor_epoch = 0; // epoch time (ms) of the anchor
+static int32_t slew = 0; // correction (ms) still being worked in since the anchor
+static int32_t drift = 0; // drift compensation (ppm)
+static unsigned long drift_estimates = 0; // number of drift estimates so far
+
+// last cloud time sync (for detecting new syncs and estimating the drift)
+static system_tick_t sync_millis = 0;
+static uint64_t sync_local = 0;
+static uint64_t sync_epoch = 0;
+static unsigned long syncs = 0;
+
+uint64_t getEpochMillis(uint64_t local_ms) {
+  if (!synced) return(0);
+  int64_t dt = (int64_t) (local_ms - anchor_local);
+  int64_t correction = dt * drift / 1000000;
+  if (dt > 0 && slew != 0) {
+    // work in the correction at CLOCK_SLEW_RATE
+    int64_t slewed = dt * CLOCK_SLEW_RATE / 1000000;
+    correction += (slewed < abs(slew)) ? ((slew > 0) ? slewed : -slewed) : slew;
+  }
+  return(anchor_epoch + dt + correction);
+}
+
+uint64_t getEpochMillis() {
+  return(getEpochMillis(millis64()));
+}
+
+void syncClock(uint64_t local_ms, uint64_t epoch_ms) {
+
+  // first sync
+  if (!synced) {
+    anchor_local = local_ms;
+    anchor_epoch = epoch_ms;
+    slew = 0;
+    synced = true;
+    return;
+  }
+
+  // error of the current mapping
+  uint64_t mapped = getEpochMillis(local_ms);
+  int64_t error = (int64_t) (epoch_ms - mapped);
+
+  // re-anchor where the current mapping is (continuous) and work in the error from there
+  anchor_local = local_ms;
+  if (error > CLOCK_STEP_THRESHOLD || error < -CLOCK_STEP_THRESHOLD) {
+    Serial.printlnf("WARNING: clock off by %ld ms, setting it directly", (long) error);
+    anchor_epoch = epoch_ms;
+    slew = 0;
+  } else {
+    anchor_epoch = mapped;
+    slew = error;
+  }
+}
+
+bool isClockSynced() {
+  return(synced);
+}
+
+long getClockDrift() {
+  return(drift);
+}
+
+unsigned long getClockSyncs() {
+  return(syncs);
+}
+
+void updateClock() {
+
+  // catch millis() overflows
+  uint64_t now = millis64();
+
+  // new cloud time sync?
+  time_t sync_time;
+  system_tick_t last_sync = Particle.timeSyncedLast(sync_time);
+  if (last_sync != 0 && last_sync != sync_millis && sync_time > 0) {
+    sync_millis = last_sync;
+    uint64_t local = toMillis64(last_sync);
+    uint64_t epoch = (uint64_t) sync_time * 1000 + 500; // sync has seconds resolution --> middle of the second
+
+    // new anchor (with the current drift compensation)
+    syncClock(local, epoch);
+
+    // drift since the last sync (millis() vs. UTC), compensated from this sync on
+    if (syncs > 0 && local - sync_local >= CLOCK_DRIFT_MIN_INTERVAL) {
+      int64_t interval = (int64_t) (local - sync_local);
+      int64_t measured = ((int64_t) (epoch - sync_epoch) - interval) * 1000000 / interval;
+      if (measured > CLOCK_DRIFT_MAX) measured = CLOCK_DRIFT_MAX;
+      else if (measured < -CLOCK_DRIFT_MAX) measured = -CLOCK_DRIFT_MAX;
+      // low-pass filter (single estimates are noisy because of the seconds resolution of the syncs)
+      drift = (drift_estimates == 0) ? measured : drift + (measured - drift) / CLOCK_DRIFT_FILTER;
+      drift_estimates++;
+      Serial.printlnf("INFO: clock drift %ld ppm since last time sync, compensating %ld ppm", (long) measured, (long) drift);
+    }
+    if (syncs == 0 || local - sync_local >= CLOCK_DRIFT_MIN_INTERVAL) {
+      sync_local = local;
+      sync_epoch = epoch;
+    }
+    syncs++;
+    return;
+  }
+
+  // no cloud sync yet but a valid RTC time (e.g. kept through a reset) --> provisional mapping
+  if (!synced && Time.isValid()) {
+    syncClock(now, (uint64_t) Time.now() * 1000 + 500);
+  }
+}
+
+/*** time formatting ***/
+
+void formatLocalTime(char* target, int size, const char* format) {
+  time_t now = Time.now();
+  time_t local = Time.local();
+  struct tm calendar_time;
+  gmtime_r(&local, &calendar_time);
+
+  // the calendar time has no time zone (strftime would print GMT / +0000) --> %z and %Z are the UTC offset
+  long offset = (long) (local - now);
+  offset = (offset >= 0) ? (offset + 30) / 60 : (offset - 30) / 60; // in minutes (now and local may be a second apart)
+  char local_format[CLOCK_TIME_TEXT_SIZE];
+  int n = 0;
+  for (const char* c = format; *c != 0 && n < (int) sizeof(local_format) - 1; c++) {
+    if (c[0] == '%' && (c[1] == 'z' || c[1] == 'Z')) {
+      n += snprintf(local_format + n, sizeof(local_format) - n, "%c%02ld:%02ld", (offset < 0) ? '-' : '+', labs(offset) / 60, labs(offset) % 60);
+      if (n > (int) sizeof(local_format) - 1) n = sizeof(local_format) - 1;
+      c++;
+    } else {
+      local_format[n++] = c[0];
+      if (c[0] == '%' && c[1] != 0 && n < (int) sizeof(local_format) - 1) local_format[n++] = *++c; // e.g. %%
+    }
+  }
+  local_format[n] = 0;
+  if (strftime(target, size, local_format, &calendar_time) == 0 && size > 0) target[0] = 0;
+}
+
+static char time_text[CLOCK_TIME_TEXT_SIZE];
+
+const char* getLocalTimeText(const char* format) {
+  formatLocalTime(time_text, sizeof(time_text), format);
+  return(time_text);
+}
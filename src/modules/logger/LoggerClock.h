@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+
+/*** clock parameters ***/
+#define CLOCK_SLEW_RATE          500 // rate (in ppm = ms per 1000 s) at which small sync corrections are worked in (keeps the clock monotonic)
+#define CLOCK_STEP_THRESHOLD     10000 // sync corrections larger than this (in ms) are applied at once instead (~50 ppm over a day is still slewed)
+#define CLOCK_DRIFT_MAX          500 // maximum drift compensation (in ppm)
+// syncs only have seconds resolution: a drift estimate from syncs 1 h apart is +/- 280 ppm noise, 23 h apart +/- 12 ppm
+// (the controller syncs once a day) and the estimates are low-pass filtered on top of that
+#ifndef CLOCK_DRIFT_MIN_INTERVAL
+#define CLOCK_DRIFT_MIN_INTERVAL 82800000UL // minimum time between syncs (in ms) for a drift estimate
+#endif
+#ifndef CLOCK_DRIFT_FILTER
+#define CLOCK_DRIFT_FILTER       4 // each new drift estimate moves the compensation 1/CLOCK_DRIFT_FILTER of the way (the first is used directly)
+#endif
+#define CLOCK_DATE_TIME_FORMAT   "%Y-%m-%d %H:%M:%S %z" // default date time format (local time and its UTC offset)
+#define CLOCK_TIME_TEXT_SIZE     50 // size of the shared time text buffer (see getLocalTimeText)
+
+/*** monotonic clock ***/
+
+// milliseconds since startup as 64 bit value (does not overflow after 49 days like millis())
+// @note must be called at least once every 49 days to catch the millis() overflow (the controller calls it in every update)
+uint64_t millis64();
+
+// converts a recent millis() value (less than 49 days ago) to the millis64() time line
+uint64_t toMillis64(unsigned long ms);
+
+/*** epoch mapping ***/
+
+// millis64() --> UTC mapping, anchored at each time sync with the cloud:
+//  - the first sync (or a valid RTC time before that) sets the mapping, later syncs are worked in gradually
+//    at CLOCK_SLEW_RATE so the epoch time never jumps backwards (unless off by more than CLOCK_STEP_THRESHOLD)
+//  - the difference between the millis() and the UTC time passed between two syncs is compensated as clock drift
+
+// checks for a completed time sync and updates the mapping (call in loop, the controller does this in every update)
+void updateClock();
+
+// anchors the mapping at a local time with known epoch time (both in ms)
+void syncClock(uint64_t local_ms, uint64_t epoch_ms);
+
+// whether the mapping is set
+bool isClockSynced();
+
+// @return the UTC epoch time (in ms) of a millis64() time (0 if the clock is not yet synced)
+uint64_t getEpochMillis(uint64_t local_ms);
+
+// @return the current UTC epoch time (in ms, 0 if the clock is not yet synced)
+uint64_t getEpochMillis();
+
+// @return the current drift compensation (in ppm)
+long getClockDrift();
+
+// @return the number of cloud time syncs so far
+unsigned long getClockSyncs();
+
+/*** time formatting ***/
+
+// formats the current local time (Time.zone) with strftime, %z (and %Z) are the UTC offset of the local time (+hh:mm)
+// @note use instead of Time.format in the loop, Time.format returns a String that is allocated on the heap
+void formatLocalTime(char* target, int size, const char* format = CLOCK_DATE_TIME_FORMAT);
+
+// @return the current local time as text (shared buffer, only valid until the next call)
+const char* getLocalTimeText(const char* format = CLOCK_DATE_TIME_FORMAT);
@@ -7,6 +7,15 @@ void LoggerCommand::load(String& command_string) {
   reset();
   command_string.toCharArray(command, sizeof(command));
   strcpy(buffer, command);
+  tokenize();
+}
+
+void LoggerCommand::load(const char* command_text) {
+  reset();
+  strncpy(command, command_text, sizeof(command) - 1);
+  command[sizeof(command) - 1] = 0;
+  strcpy(buffer, command);
+  tokenize();
 }
 
 void LoggerCommand::reset() {
@@ -15,6 +24,9 @@ void LoggerCommand::reset() {
   value[0] = 0;
   units[0] = 0;
   notes[0] = 0;
+  token_n = 0;
+  token_next = 0;
+  variable_hash = 0;
 
   strcpy(type, CMD_LOG_TYPE_UNDEFINED);
   strcpy(type_short, CMD_LOG_TYPE_UNDEFINED_SHORT);
@@ -23,32 +35,36 @@ void LoggerCommand::reset() {
   ret_val = CMD_RET_UNDEFINED;
 }
 
-// capture command excerpt (until next space) in param
+// split the buffer into tokens at every space (single pass, in place)
+void LoggerCommand::tokenize() {
+  token_n = 0;
+  token_next = 0;
+  token_start[token_n++] = 0;
+  for (uint8_t i = 0; buffer[i] != 0; i++) {
+    if (buffer[i] == ' ') {
+      buffer[i] = 0;
+      token_start[token_n++] = i + 1;
+    }
+  }
+}
+
+// capture the next token in param (empty if there are no more tokens)
 // using char array pointers instead of String to make sure we don't get memory leaks here
 // providing size to be sure to be on the safe side
 void LoggerCommand::extractParam(char* param, uint size) {
-  uint space = strcspn(buffer, " ");
-  // size safety check
-  if (space < size) {
-    strncpy (param, buffer, space);
-    param[space] = 0;
+  if (token_next < token_n) {
+    strncpy(param, buffer + token_start[token_next], size - 1);
+    param[size - 1] = 0;
+    token_next++;
   } else {
-    strncpy (param, buffer, size);
-    param[size] = 0;
-  }
-  // clean up buffer
-  if (space == strlen(buffer)) {
-    buffer[0] = 0;
-  } else {
-    for(uint i = space+1; i <= strlen(buffer); i+=1) {
-      buffer[i-space-1] = buffer[i];
-    }
+    param[0] = 0;
   }
 }
 
 // assigns the next extractable parameter to variable
 void LoggerCommand::extractVariable() {
   extractParam(variable, sizeof(variable));
+  variable_hash = getHash(variable);
 }
 
 // assigns the next extractable paramter to value
@@ -61,9 +77,27 @@ void LoggerCommand::extractUnits() {
   extractParam(units, sizeof(units));
 }
 
-// takes the remainder of the command buffer and assigns it to the message
+// checks whether the next parameters are the component id (an id with spaces spans several tokens)
+// and moves past them if they are, @return whether the id was found
+bool LoggerCommand::extractComponent(const char* id) {
+  if (token_next >= token_n) return(false);
+  const char* next = command + token_start[token_next];
+  size_t length = strlen(id);
+  if (length == 0 || strncmp(next, id, length) != 0 || (next[length] != ' ' && next[length] != 0)) return(false);
+  for (const char* c = id; *c != 0; c++) {
+    if (*c == ' ') token_next++;
+  }
+  token_next++;
+  return(true);
+}
+
+// takes the remainder of the command (after the extracted tokens) and assigns it to the message
 void LoggerCommand::assignNotes() {
-  strncpy(notes, buffer, sizeof(notes));
+  if (token_next < token_n) {
+    strncpy(notes, command + token_start[token_next], sizeof(notes));
+  } else {
+    notes[0] = 0;
+  }
 }
 
 // check if variable has the specific value
@@ -93,6 +127,15 @@ bool LoggerCommand::parseUnits(char* cmd) {
   }
 }
 
+uint32_t LoggerCommand::getHash(const char* text) {
+  uint32_t hash = 2166136261UL;
+  for (const char* c = text; *c != 0; c++) {
+    hash ^= (uint8_t) *c;
+    hash *= 16777619UL;
+  }
+  return(hash);
+}
+
 /****** COMMAND STATUS *******/
 
 bool LoggerCommand::isTypeDefined() {
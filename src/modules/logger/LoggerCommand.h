@@ -5,12 +5,29 @@
 // important constants
 #define CMD_MAX_CHAR          63  // spark.functions are limited to 63 char long call
 
+// forward declarations for command registry
+class LoggerController;
+class LoggerComponent;
+
+// registered command verb
+struct LoggerCommandVerb {
+    const char* verb;
+    const char* help; // short description for the help command
+    uint32_t hash; // hash of the verb (see LoggerCommand::getHash)
+    LoggerComponent* component; // component parsing the command (NULL if the controller parses it)
+    bool (LoggerController::*parse)(); // controller parser for the command (if component is NULL)
+};
+
 struct LoggerCommand {
 
     // command message
     char command[CMD_MAX_CHAR];
-    char buffer[CMD_MAX_CHAR];
+    char buffer[CMD_MAX_CHAR]; // command split into tokens (spaces replaced with null bytes)
+    uint8_t token_start[CMD_MAX_CHAR]; // where each token starts in the buffer
+    uint8_t token_n; // number of tokens
+    uint8_t token_next; // next token to extract
     char variable[25];
+    uint32_t variable_hash; // hash of the variable (for command registry lookup)
     char value[20];
     char units[20];
     char notes[CMD_MAX_CHAR];
@@ -28,16 +45,20 @@ struct LoggerCommand {
     // command extraction
     void reset();
     void load(String& command_string);
+    void load(const char* command_text);
+    void tokenize();
     void extractParam(char* param, uint size);
     void extractVariable();
     void extractValue();
     void extractUnits();
+    bool extractComponent(const char* id); // skips past the component id if the command continues with it (ids can contain spaces)
     void assignNotes();
 
     // command parsing
     bool parseVariable(char* cmd);
     bool parseValue(char* cmd);
     bool parseUnits(char* cmd);
+    static uint32_t getHash(const char* text); // 32 bit FNV-1a
 
     // command status
     bool isTypeDefined(); // whether the command type was found
@@ -0,0 +1,62 @@
+#pragma once
+
+/*** command queue ***/
+
+// single-producer single-consumer ring buffer of command texts in fixed storage (no heap allocation)
+// the cloud function handler pushes, the controller's update pops (head and tail only ever change on one side)
+template<size_t SIZE, size_t LENGTH>
+class LoggerCommandQueue
+{
+
+  private:
+
+    char commands[SIZE][LENGTH];
+    volatile size_t head = 0; // number of commands popped (consumer)
+    volatile size_t tail = 0; // number of commands pushed (producer)
+    size_t max_n = 0; // high-water mark of the number of queued commands
+
+  public:
+
+    bool empty() {
+      return(head == tail);
+    }
+
+    bool full() {
+      return(tail - head >= SIZE);
+    }
+
+    size_t size() {
+      return(tail - head);
+    }
+
+    size_t capacity() {
+      return(SIZE);
+    }
+
+    size_t maxSize() {
+      return(max_n);
+    }
+
+    // @return whether the command fit into the queue (texts longer than LENGTH - 1 are truncated)
+    bool push(const char* text) {
+      if (full()) return(false);
+      char* slot = commands[tail % SIZE];
+      strncpy(slot, text, LENGTH - 1);
+      slot[LENGTH - 1] = 0;
+      tail = tail + 1; // publish after the text is in place
+      if (tail - head > max_n) max_n = tail - head;
+      return(true);
+    }
+
+    // oldest command text (only valid until the next pop)
+    const char* front() {
+      if (empty()) return("");
+      return(commands[head % SIZE]);
+    }
+
+    void pop() {
+      if (empty()) return;
+      head = head + 1;
+    }
+
+};
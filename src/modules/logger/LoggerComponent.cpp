@@ -9,6 +9,10 @@ void LoggerComponent::debug() {
 
 /*** setup ***/
 
+bool LoggerComponent::isDataReader() {
+    return(false);
+}
+
 // setup data vector - override in derived clases, has to return the new index
 uint8_t LoggerComponent::setupDataVector(uint8_t start_idx) { 
     Serial.printf("INFO: constructing data vector for component '%s' starting at index %d\n", id, start_idx);
@@ -30,14 +34,30 @@ void LoggerComponent::update() {
 
 /*** state management ***/
 
-void LoggerComponent::setEEPROMStart(size_t start) { 
-    eeprom_start = start; 
+void LoggerComponent::setStateKey(uint16_t key) { 
+    state_key = key; 
+}
+
+uint16_t LoggerComponent::getStateKey() {
+    return(state_key);
+}
+
+void LoggerComponent::setLegacyStateAddress(size_t address) {
+    legacy_state_address = address;
 }
 
 size_t LoggerComponent::getStateSize() { 
     return(0); 
 }
 
+void* LoggerComponent::getStateData() {
+    return(NULL);
+}
+
+size_t LoggerComponent::getStateStoreSize() {
+    return((getStateSize() > 0) ? getStateSize() + STATE_STORE_RECORD_OVERHEAD : 0);
+}
+
 void LoggerComponent::loadState(bool reset) {
   if (getStateSize() > 0) {
     if (!reset){
@@ -62,12 +82,103 @@ void LoggerComponent::resetState() {
 
 };
 
+void LoggerComponent::markStateDirty() {
+    state_dirty = true;
+    ctrl->markComponentsStateDirty();
+    if (ctrl->debug_state) {
+        Serial.printf("DEBUG: component '%s' state changed, saving after %d ms without further changes\n", id, STATE_SAVE_DELAY);
+    }
+}
+
+void LoggerComponent::commitState() {
+    if (state_dirty) {
+        state_dirty = false;
+        saveState();
+    }
+}
+
+bool LoggerComponent::migrateState(uint8_t from_version, const uint8_t* data, size_t size) {
+    return(false);
+}
+
+size_t LoggerComponent::getStateSnapshotSize() {
+    return((getStateData() != NULL) ? getStateSize() : 0);
+}
+
+void LoggerComponent::snapshotState(uint8_t* target) {
+    if (getStateData() != NULL) memcpy(target, getStateData(), getStateSize());
+}
+
+bool LoggerComponent::rollbackState(const uint8_t* source) {
+    if (getStateData() == NULL || memcmp(getStateData(), source, getStateSize()) == 0) return(false);
+    memcpy(getStateData(), source, getStateSize());
+    state_dirty = false;
+    saveState();
+    Serial.printf("INFO: component '%s' state rolled back\n", id);
+    return(true);
+}
+
+bool LoggerComponent::saveStateRecord(const void* state, size_t size, uint8_t version) {
+    bool saved = ctrl->state_store.save(state_key, version, state, size);
+    if (ctrl->debug_state && saved) {
+        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
+    }
+    return(saved);
+}
+
+bool LoggerComponent::restoreStateRecord(void* state, size_t size, const uint8_t* version_field) {
+    uint8_t version = *version_field;
+    uint8_t saved_version;
+    size_t saved_size;
+    const uint8_t* saved = ctrl->state_store.load(state_key, &saved_version, &saved_size);
+    bool recoverable = saved != NULL && saved_version == version && saved_size == size;
+    if (recoverable) {
+        memcpy(state, saved, size);
+        Serial.printf("INFO: successfully restored component '%s' state from memory (state version %d)\n", id, version);
+    } else if (saved != NULL && saved_version != 0 && migrateState(saved_version, saved, saved_size)) {
+        // version 0 = reset request, never migrated
+        Serial.printf("INFO: migrated component '%s' state from version %d to %d\n", id, saved_version, version);
+        saveStateRecord(state, size, version);
+        recoverable = true;
+    } else if (saved == NULL && ctrl->importLegacyState(state, size, version_field, legacy_state_address)) {
+        // first start after the upgrade from the old memory layout
+        Serial.printf("INFO: imported component '%s' state from the old memory layout (state version %d)\n", id, version);
+        saveStateRecord(state, size, version);
+        recoverable = true;
+    } else {
+        (saved != NULL) ?
+            Serial.printf("INFO: could not restore component '%s' state from memory (found state version %d instead of %d), sticking with initial default\n", id, saved_version, version) :
+            Serial.printf("INFO: no component '%s' state in memory, sticking with initial default\n", id);
+        saveStateRecord(state, size, version);
+    }
+    return(recoverable);
+}
+
 /*** command parsing ***/
 
+void LoggerComponent::registerCommands() {
+};
+
+bool LoggerComponent::registerCommand(const char* verb, const char* help) {
+    return(ctrl->registerCommand(verb, help, this));
+};
+
 bool LoggerComponent::parseCommand(LoggerCommand *command) {
     return(false);
 };
 
+/*** retained data ***/
+
+size_t LoggerComponent::getRetainedSize() {
+    return(0);
+}
+
+void LoggerComponent::retain(uint8_t* target) {
+}
+
+void LoggerComponent::restoreRetained(const uint8_t* source, int64_t time_shift) {
+}
+
 /*** state changes ***/
 
 void LoggerComponent::activateDataLogging() {
@@ -80,6 +191,36 @@ void LoggerComponent::updateDisplayStateInformation() {
     
 };
 
+/*** lcd page ***/
+
+void LoggerComponent::addDisplayPage() {
+    display_page = ctrl->lcd->addPage(id, &LoggerComponent::renderDisplayPageCallback, this);
+}
+
+void LoggerComponent::markDisplayPageDirty() {
+    ctrl->lcd->markPageDirty(display_page);
+}
+
+void LoggerComponent::renderDisplayPageCallback(LoggerDisplay* lcd, void* component) {
+    ((LoggerComponent*) component)->renderDisplayPage();
+}
+
+void LoggerComponent::renderDisplayPage() {
+    LoggerDisplay* lcd = ctrl->lcd;
+    for (int i = 0; i < data.size() && LCD_PAGE_LINE + i <= lcd->getLines(); i++) {
+        lcd->resetBuffer();
+        if (data[i].getN() > 0)
+            getDataDoubleText(data[i].variable, data[i].getValue(), data[i].getUnits(), data[i].getN(),
+                lcd->buffer, sizeof(lcd->buffer), PATTERN_KVUN_SIMPLE, data[i].getDecimals());
+        else if (data[i].newest_value_valid)
+            getDataDoubleText(data[i].variable, data[i].newest_value, data[i].getUnits(),
+                lcd->buffer, sizeof(lcd->buffer), PATTERN_KVU_SIMPLE, data[i].getDecimals());
+        else
+            snprintf(lcd->buffer, sizeof(lcd->buffer), "%s: no data yet", data[i].variable);
+        lcd->printLineFromBuffer(LCD_PAGE_LINE + i);
+    }
+}
+
 /*** logger state variable ***/
 
 void LoggerComponent::assembleStateVariable() {
@@ -103,66 +244,19 @@ void LoggerComponent::clearData(bool clear_persistent) {
             (clear_persistent) ?
                 Serial.printf("DEBUG: clearing all component '%s' data at ", id):
                 Serial.printf("DEBUG: clearing only non-persistant component '%s' data at ", id);
-            Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+            Serial.println(getLocalTimeText());
         }
         for (int i=0; i<data.size(); i++) data[i].clear(clear_persistent);
+        markDisplayPageDirty();
     }
 };
 
 void LoggerComponent::logData() {
-    last_data_log_index = -1;
-    // chunked data logging
-    while (assembleDataLog()) {
-        if (ctrl->debug_cloud) {
-            Serial.printf("DEBUG: assembled data log for component '%s' from index %d to %d\n", id, first_data_log_index, last_data_log_index);
+    for (int i = 0; i < data.size(); i++) {
+        if (ctrl->addToDataLog(&data[i]) && ctrl->debug_cloud) {
+            Serial.printf("DEBUG: added data #%d of component '%s' to the data log\n", data[i].idx, id);
         }
-        ctrl->queueDataLog();
     }
-};
-
-bool LoggerComponent::assembleDataLog() {
-
-    // first reporting index
-    first_data_log_index = last_data_log_index + 1;
-    
-    // check if we're already done with all data
-    if (first_data_log_index >= data.size()) return(false);
-
-    // check first next data (is there at least one with data?)
-    bool something_to_report = false;
-    int i = first_data_log_index;
-    for (; i < data.size(); i++) {
-        if(data[i].getN() > 0) {
-            // found data that has something to report
-            something_to_report = true;
-            break;
-        }
-    }
-
-    // nothing to report
-    if (!something_to_report) return(false);
-
-    // reset the log & buffers
-    ctrl->resetDataLog();
-
-    // all data that fits
-    i = first_data_log_index;
-    for(; i < data.size(); i++) {
-        if(data[i].assembleLog(!data_have_same_time_offset)) {
-            if (!ctrl->addToDataLogBuffer(data[i].json)) {
-                // no more space - stop here for this log
-                break;
-            }
-        }
-        last_data_log_index = i;
-    }
-
-    // finalize data log
-    if (data_have_same_time_offset) {
-        unsigned long common_time = millis() - (unsigned long) data[first_data_log_index].getDataTime();
-        return(ctrl->finalizeDataLog(true, common_time));
-    } else {
-        return(ctrl->finalizeDataLog(false));
-    }
-    return(true);
+    // queue right away unless part of the controller's data log pass (e.g. event triggered logs)
+    ctrl->completeDataLog();
 }
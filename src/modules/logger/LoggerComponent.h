@@ -2,6 +2,7 @@
 #include <vector>
 #include "LoggerCommand.h"
 #include "LoggerData.h"
+#include "LoggerDisplay.h"
 
 // forward declaration for controller
 class LoggerController;
@@ -19,17 +20,24 @@ class LoggerComponent
     LoggerController *ctrl;
 
     // state
-    size_t eeprom_start;
+    uint16_t state_key; // key of the state record in the controller's state store
+    size_t legacy_state_address = 0; // where older firmware saved the state (EEPROM.put at fixed offsets, see LoggerStateStore::loadLegacy)
+    bool state_dirty = false; // pending state changes
+
+    // state record helpers (for saveState/restoreState implementations)
+    bool saveStateRecord(const void* state, size_t size, uint8_t version);
+    // @param version the state's version field (also used to check a state saved by older firmware)
+    bool restoreStateRecord(void* state, size_t size, const uint8_t* version);
 
     // time offset - whether all data have the same
+    // (informational, data logs include a data time for any data whose time differs from the log's)
     bool data_have_same_time_offset;
 
     // auto clear data - whether data should be cleared after data log and on data reset 
     bool auto_clear_data;
 
-    // keep track of which data has been logged
-    int first_data_log_index;
-    int last_data_log_index;
+    // lcd page of the component (if any)
+    uint8_t display_page = LCD_NO_PAGE;
 
   public:
 
@@ -40,12 +48,13 @@ class LoggerComponent
     std::vector<LoggerData> data;
 
     /*** constructors ***/
-    LoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset, bool auto_clear_data) : id(id), ctrl(ctrl), data_have_same_time_offset(data_have_same_time_offset), auto_clear_data(auto_clear_data) {}
+    LoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset, bool auto_clear_data) : ctrl(ctrl), data_have_same_time_offset(data_have_same_time_offset), auto_clear_data(auto_clear_data), id(id) {}
 
     /*** debug ***/
     void debug();
 
     /*** setup ***/
+    virtual bool isDataReader(); // whether the component reads data on its own schedule (see DataReaderLoggerComponent)
     virtual uint8_t setupDataVector(uint8_t start_idx); // setup data vector - override in derived clases, has to return the new index
     virtual void init();
     virtual void completeStartup();
@@ -54,22 +63,47 @@ class LoggerComponent
     virtual void update();
 
     /*** state management ***/
-    virtual void setEEPROMStart(size_t start);
+    virtual void setStateKey(uint16_t key);
+    uint16_t getStateKey();
+    void setLegacyStateAddress(size_t address);
     virtual size_t getStateSize();
+    virtual void* getStateData(); // the state struct (getStateSize() bytes, NULL if the component has no state)
+    virtual size_t getStateStoreSize(); // bytes needed in the state store (all records of the component incl. overhead)
     virtual void loadState(bool reset = false);
     virtual void saveState();
     virtual bool restoreState();
     virtual void resetState();
+    void markStateDirty(); // save the state after a quiet period (use saveState() for changes that must be saved right away)
+    void commitState(); // save pending state changes now
+    // override to carry settings over from an older state version (copy into the state and return true)
+    virtual bool migrateState(uint8_t from_version, const uint8_t* data, size_t size);
+    // snapshot of the state to roll back a command batch that fails part way (see LoggerController::executeCommandBatch)
+    virtual size_t getStateSnapshotSize();
+    virtual void snapshotState(uint8_t* target);
+    virtual bool rollbackState(const uint8_t* source); // @return whether the state had changed (restored state is saved right away)
 
     /*** command parsing ***/
+    virtual void registerCommands(); // register the commands handled in parseCommand (see registerCommand)
+    bool registerCommand(const char* verb, const char* help); // cloud commands with unregistered verbs are rejected (see LoggerController::checkCommand), serial/fuzzed ones still reach parseCommand via a linear search
     virtual bool parseCommand(LoggerCommand *command);
 
+    /*** retained data (in-progress statistics kept across warm resets, see LoggerRetained.h) ***/
+    virtual size_t getRetainedSize(); // bytes of component specific retained data (the controller retains the data accumulators)
+    virtual void retain(uint8_t* target);
+    virtual void restoreRetained(const uint8_t* source, int64_t time_shift); // time shift from the old to the current millis64() time line
+
     /*** state changes ***/
     virtual void activateDataLogging();
 
     /*** state info to LCD display ***/
     virtual void updateDisplayStateInformation();
 
+    /*** lcd page ***/
+    void addDisplayPage(); // adds a page for the component to the controller's lcd (call in init)
+    void markDisplayPageDirty(); // re-render the page (only happens if/once it is visible)
+    static void renderDisplayPageCallback(LoggerDisplay* lcd, void* component);
+    virtual void renderDisplayPage(); // default: the component's data (one per line)
+
     /*** logger state variable ***/
     virtual void assembleStateVariable();
 
@@ -78,7 +112,6 @@ class LoggerComponent
 
     /*** particle webhook data log ***/
     virtual void clearData(bool clear_persistent = false);
-    virtual void logData();
-    virtual bool assembleDataLog();
+    virtual void logData(); // adds the data to the controller's data log
 
 };
@@ -1,11 +1,12 @@
 #include "application.h"
 #include "LoggerController.h"
 #include "LoggerComponent.h"
+#include "DataReaderLoggerComponent.h"
+#include <new>
+#include <limits.h>
 
-// EEPROM variables
-#define STATE_ADDRESS    0 // EEPROM storage location
-#define EEPROM_START    0  // EEPROM storage start
-const size_t EEPROM_MAX = EEPROM.length();
+// default display (no screen)
+LoggerDisplay LoggerController::no_lcd;
 
 /*** debugs ***/
 
@@ -19,6 +20,7 @@ void LoggerController::debugWebhooks(){
 
 void LoggerController::debugState(){
   debug_state = true;
+  state_store.debug_store = true;
 }
 
 void LoggerController::debugData(){
@@ -51,28 +53,73 @@ void LoggerController::setDataUpdateCallback(void (*cb)()) {
   data_update_callback = cb;
 }
 
+/*** lcd pages ***/
+
+void LoggerController::setPageButton(int pin) {
+  page_button_pin = pin;
+}
+
+uint8_t LoggerController::getMainPage() {
+  return(main_page);
+}
+
 /*** setup ***/
 
 void LoggerController::addComponent(LoggerComponent* component) {
-    component->setEEPROMStart(eeprom_location);
-    eeprom_location = eeprom_location + component->getStateSize();
+    component->setStateKey(LoggerStateStore::getKey(component->id));
+    component->setLegacyStateAddress(legacy_state_address);
+    legacy_state_address += component->getStateSize();
     data_idx = component->setupDataVector(data_idx);
     if (debug_data) {
       for(int i = 0; i < component->data.size(); i++) {
         component->data[i].debug();
       }
     }
-    if (eeprom_location >= EEPROM_MAX) {
-      Serial.printf("ERROR: component '%s' state would exceed EEPROM size, cannot add component.\n", component->id);
+    // state store checks
+    const char* collision = NULL;
+    if (component->getStateSize() > 0) {
+      if (component->getStateKey() == state_key) collision = state_id;
+      for(int i = 0; i < components.size(); i++) {
+        if (components[i]->getStateSize() > 0 && components[i]->getStateKey() == component->getStateKey()) collision = components[i]->id;
+      }
+    }
+    size_t needed = component->getStateStoreSize();
+    if (collision != NULL) {
+      Serial.printf("ERROR: component '%s' state key collides with '%s', cannot add component (rename the component).\n", component->id, collision);
+    } else if (component->getStateSize() > STATE_STORE_RECORD_MAX) {
+      Serial.printf("ERROR: component '%s' state is larger than %d bytes, cannot add component.\n", component->id, STATE_STORE_RECORD_MAX);
+    } else if (state_store_needed + needed > state_store.getCapacity()) {
+      Serial.printf("ERROR: component '%s' state would exceed state store capacity, cannot add component.\n", component->id);
     } else {
+      state_store_needed += needed;
       Serial.printf("INFO: adding component '%s' to the controller.\n", component->id);
       components.push_back(component);
+      component->registerCommands();
+      if (component->isDataReader()) {
+        // stagger the readers evenly across their read periods
+        readers.push_back((DataReaderLoggerComponent*) component);
+        for(int i = 0; i < readers.size(); i++) readers[i]->setDataReadPhase(i, readers.size());
+      }
+    }
+}
+
+bool LoggerController::addTransport(LoggerTransport* transport) {
+    if (transports_n >= TRANSPORTS_MAX) {
+      Serial.printlnf("ERROR: transport '%s' exceeds the maximum number of transports (%d), cannot add transport.", transport->name, TRANSPORTS_MAX);
+      return(false);
     }
+    Serial.printlnf("INFO: adding transport '%s' to the controller.", transport->name);
+    transports[transports_n++] = transport;
+    return(true);
 }
 
 void LoggerController::init() {
   // define pins
   pinMode(reset_pin, INPUT_PULLDOWN);
+  if (page_button_pin >= 0) pinMode(page_button_pin, INPUT_PULLDOWN);
+
+  // stack reference
+  noteStackUsage();
 
   // initialize
   Serial.printlnf("INFO: initializing controller '%s'...", version);
@@ -93,11 +140,13 @@ void LoggerController::init() {
   // starting application watchdog
   System.enableFeature(FEATURE_RESET_INFO);
   Serial.println("INFO: starting application watchdog");
-  wd = new ApplicationWatchdog(60s, watchdogHandler, 1536);
+  wd = new (wd_storage) ApplicationWatchdog(60s, watchdogHandler, 1536);
 
   // lcd
   lcd->init();
   lcd->printLine(1, version);
+  main_page = lcd->addPage("main", &LoggerController::renderMainPageCallback, this);
+  system_page = lcd->addPage("system", &LoggerController::renderSystemPageCallback, this);
 
   //  check for reset
   if(digitalRead(reset_pin) == HIGH || reset) {
@@ -129,14 +178,19 @@ void LoggerController::init() {
   }
 
   // controller state
+  state_store.begin();
   loadState(reset);
   loadComponentsState(reset);
 
   // components' init
   initComponents();
+
+  // in-progress statistics from before a warm reset
+  setupRetained();
+  restoreRetained();
   
   // startup time info
-  Serial.println(Time.format(Time.now(), "INFO: startup time: %Y-%m-%d %H:%M:%S %Z"));
+  Serial.println(getLocalTimeText("INFO: startup time: %Y-%m-%d %H:%M:%S %z"));
   Serial.printlnf("INFO: available memory: %lu", System.freeMemory());
 
 }
@@ -176,6 +230,26 @@ void LoggerController::completeStartup() {
 
 void LoggerController::update() {
 
+    // stack usage
+    noteStackUsage();
+
+    // clock (64 bit time line and UTC mapping)
+    updateClock();
+
+    // heap check: the logger only allocates during setup, any later allocation can fragment the heap over time
+    if (!heap_check_started) {
+      heap_check_started = true;
+      heap_allocations = getHeapAllocations();
+      Serial.printlnf("INFO: heap use after setup: %lu bytes in %lu allocations", getHeapBytesInUse(), heap_allocations);
+    } else if (getHeapAllocations() != heap_allocations) {
+      Serial.printlnf("WARNING: heap allocated after setup (%lu new allocations, %lu bytes in use)", 
+        getHeapAllocations() - heap_allocations, getHeapBytesInUse());
+      heap_allocations = getHeapAllocations();
+    }
+
+    // queued commands
+    processCommandQueue();
+
     // cloud connection
     if (Particle.connected()) {
         if (!cloud_connected) {
@@ -183,15 +257,12 @@ void LoggerController::update() {
             WiFi.macAddress(mac_address);
             Serial.printf("INFO: MAC address: %02x:%02x:%02x:%02x:%02x:%02x\n", 
             mac_address[0], mac_address[1], mac_address[2], mac_address[3], mac_address[4], mac_address[5]);
-            Serial.println(Time.format(Time.now(), "INFO: cloud connection established at %H:%M:%S"));
+            Serial.println(getLocalTimeText("INFO: cloud connection established at %H:%M:%S"));
             Serial.printlnf("INFO: available memory: %lu", System.freeMemory());
             cloud_connected = true;
-            lcd->printLine(2, ""); // clear "connect wifi" message
-
-            // update display
+            // update display (rendering the main page clears the "connect wifi" message)
             updateDisplayStateInformation();
-            updateDisplayComponentsStateInformation();
-            if (state_update_callback) state_update_callback();
+            lcd->markPageDirty(main_page);
 
             // name capture
             if (!name_handler_registered){
@@ -202,30 +273,26 @@ void LoggerController::update() {
         Particle.process();
     } else if (cloud_connected) {
         // should be connected but isn't --> reconnect
-        Serial.println(Time.format(Time.now(), "INFO: lost cloud connection at %H:%M:%S"));
+        Serial.println(getLocalTimeText("INFO: lost cloud connection at %H:%M:%S"));
         cloud_connection_started = false;
         cloud_connected = false;
     } else if (!cloud_connection_started) {
         // start cloud connection
-        Serial.println(Time.format(Time.now(), "INFO: initiate cloud connection at %H:%M:%S"));
-        lcd->printLine(2, "Connect WiFi...");
-        updateDisplayStateInformation(); // not components, preserve connect wifi message
+        Serial.println(getLocalTimeText("INFO: initiate cloud connection at %H:%M:%S"));
+        if (lcd->isPageVisible(main_page)) lcd->printLine(2, "Connect WiFi...");
+        updateDisplayStateInformation(); // not the main page, preserve connect wifi message
         Particle.connect();
         cloud_connection_started = true;
     }
 
-    // startup complete once name handler succeeds and the time is valid (could be some time after initial particle connect)
-    if (!startup_complete && Particle.connected() && name_handler_succeeded && Time.isValid()) {
+    // startup complete once name handler succeeds and the clock is synced (could be some time after initial particle connect)
+    if (!startup_complete && Particle.connected() && name_handler_succeeded && isClockSynced()) {
       startup_complete = true;
       completeStartup();
     }
 
     // time to generate data logs?
-    if (startup_complete && isTimeForDataLogAndClear()) {
-        last_data_log = millis();
-        logData();
-        clearData(false);
-    }
+    if (startup_complete) updateDataLogs();
 
     // out of memory?
     if (missed_data > 0 && !out_of_memory) {
@@ -235,15 +302,27 @@ void LoggerController::update() {
       missed_data = 0;
     }
     
-    // time to process logs?
-    if (startup_complete && Particle.connected() && millis() - last_log_published > publish_interval) {
-      if (!state_log_stack.empty()) {
-        // process state logs first
-        publishStateLog();
-      } else if (!data_log_stack.empty()) {
-        publishDataLog();
+    // time for the data reader statistics?
+    if (startup_complete && state->state_logging && READERS_LOG_PERIOD > 0 && !readers.empty() && millis() - last_readers_log > READERS_LOG_PERIOD) {
+      last_readers_log = millis();
+      assembleReadersLog();
+      queueStateLog();
+    }
+
+    // time to process logs? (each transport at its own pace)
+    if (startup_complete) {
+      for (uint8_t i = 0; i < transports_n; i++) {
+        LoggerTransport* transport = transports[i];
+        if (transport->isTimeToSend() && transport->hasLogs() && transport->isConnected()) {
+          if (!transport->state_logs->empty()) {
+            // process state logs first
+            publishStateLog(transport);
+          } else {
+            publishDataLog(transport);
+          }
+          transport->markSendAttempt();
+        }
       }
-      last_log_published = millis();
     }
 
     // time for time sync?
@@ -253,9 +332,15 @@ void LoggerController::update() {
       last_sync = millis();
     }
 
+    // pending state changes
+    if ((state_dirty || components_state_dirty) && millis() - last_state_change > STATE_SAVE_DELAY) {
+      commitState();
+    }
+
     // restart
     if (trigger_reset != RESET_UNDEF) {
       if (millis() - reset_timer_start > reset_delay) {
+        commitState();
         System.reset(trigger_reset, RESET_NO_WAIT);
       }
       float countdown = ((float) (reset_delay - (millis() - reset_timer_start))) / 1000;
@@ -269,6 +354,19 @@ void LoggerController::update() {
         (*components_iter)->update();
     }
 
+    // retained snapshot (whenever the statistics or the waiting logs changed)
+    if (retained_size > 0 && (isRetainedDirty() ||
+        particle_transport.state_logs->size() != retained_state_logs || particle_transport.data_logs->size() != retained_data_logs)) {
+      retainSnapshot();
+    }
+
+    // lcd pages
+    updatePageButton();
+    if (millis() - last_page_refresh > PAGE_REFRESH) {
+      lcd->markPageDirty(system_page);
+      last_page_refresh = millis();
+    }
+
     // lcd update
     lcd->update();
 
@@ -312,30 +410,86 @@ void LoggerController::loadComponentsState(bool reset)
 
 void LoggerController::saveState()
 {
-  EEPROM.put(eeprom_start, *state);
-  if (debug_state) {
+  state_dirty = false;
+  bool saved = state_store.save(state_key, state->version, state, sizeof(*state));
+  if (debug_state && saved) {
     Serial.printf("DEBUG: controller '%s' state saved in memory (if any updates were necessary)\n", version);
   }
 };
 
 bool LoggerController::restoreState()
 {
-  LoggerControllerState *saved_state = new LoggerControllerState();
-  EEPROM.get(eeprom_start, *saved_state);
-  bool recoverable = saved_state->version == state->version;
+  uint8_t saved_version;
+  size_t saved_size;
+  const uint8_t* saved = state_store.load(state_key, &saved_version, &saved_size);
+  bool recoverable = saved != NULL && saved_version == state->version && saved_size == sizeof(*state);
   if (recoverable)
   {
-    EEPROM.get(eeprom_start, *state);
+    memcpy(state, saved, sizeof(*state));
     Serial.printf("INFO: successfully restored controller state from memory (state version %d)\n", state->version);
   }
+  else if (saved != NULL && saved_version != 0 && migrateState(saved_version, saved, saved_size))
+  {
+    // version 0 = reset request, never migrated
+    Serial.printf("INFO: migrated controller state from version %d to %d\n", saved_version, state->version);
+    saveState();
+    recoverable = true;
+  }
+  else if (saved == NULL && importLegacyState(state, sizeof(*state), &state->version, 0))
+  {
+    // first start after the upgrade from the old memory layout
+    Serial.printf("INFO: imported controller state from the old memory layout (state version %d)\n", state->version);
+    saveState();
+    recoverable = true;
+  }
   else
   {
-    Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
+    (saved != NULL) ?
+      Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_version, state->version) :
+      Serial.println("INFO: no controller state in memory, sticking with initial default");
     saveState();
   }
   return (recoverable);
 };
 
+void LoggerController::markStateDirty() {
+  state_dirty = true;
+  last_state_change = millis();
+  if (debug_state) {
+    Serial.printf("DEBUG: controller '%s' state changed, saving after %d ms without further changes\n", version, STATE_SAVE_DELAY);
+  }
+}
+
+void LoggerController::markComponentsStateDirty() {
+  components_state_dirty = true;
+  last_state_change = millis();
+}
+
+void LoggerController::commitState() {
+  if (state_dirty) saveState();
+  if (components_state_dirty) {
+    components_state_dirty = false;
+    std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+    for(; components_iter != components.end(); components_iter++)
+    {
+      (*components_iter)->commitState();
+    }
+  }
+}
+
+bool LoggerController::migrateState(uint8_t from_version, const uint8_t* data, size_t size)
+{
+  return(false);
+}
+
+bool LoggerController::importLegacyState(void* target, size_t size, const uint8_t* version, size_t address)
+{
+  const uint8_t* legacy = state_store.loadLegacy(address, size);
+  if (legacy == NULL || legacy[version - (const uint8_t*) target] != *version) return(false);
+  memcpy(target, legacy, size);
+  return(true);
+}
+
 void LoggerController::resetState() {
   state->version = 0; // force reset of state on restart
   saveState();
@@ -346,14 +500,263 @@ void LoggerController::resetState() {
   }
 }
 
+/*** retained snapshot ***/
+
+void LoggerController::setupRetained() {
+  // payload: controller snapshot, then the accumulators of each data and the component specific data of each component
+  retained_layout = RETAINED_LAYOUT_SEED;
+  size_t size = sizeof(LoggerControllerSnapshot);
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    LoggerComponent* component = *components_iter;
+    retained_layout = hashRetainedLayout(retained_layout, component->id);
+    for(int i = 0; i < component->data.size(); i++) {
+      // the accumulators depend on the statistics mode and the scaling of the values
+      retained_layout = hashRetainedLayout(retained_layout, component->data[i].variable);
+      retained_layout = hashRetainedLayout(retained_layout, (uint32_t) (uint8_t) component->data[i].decimals);
+      retained_layout = hashRetainedLayout(retained_layout, component->data[i].scaled_stats ? 1 + component->data[i].stats_decimals : 0);
+      size += LOGGER_DATA_RETAINED_SIZE;
+    }
+    retained_layout = hashRetainedLayout(retained_layout, component->getRetainedSize());
+    size += component->getRetainedSize();
+  }
+  retained_layout = hashRetainedLayout(retained_layout, size);
+  if (size > RETAINED_SIZE) {
+    Serial.printlnf("WARNING: in-progress statistics need %d bytes of retained memory but only %d are available (increase RETAINED_SIZE), they will not survive resets", size, RETAINED_SIZE);
+    retained_size = 0;
+  } else {
+    retained_size = size;
+  }
+}
+
+void LoggerController::restoreRetained() {
+  if (retained_size == 0) return;
+
+  if (reset) {
+    // reset pin --> start from scratch
+    Serial.println("INFO: discarding in-progress statistics from before the reset");
+    clearRetained();
+    return;
+  }
+
+  if (checkRetained(retained_layout) != retained_size) {
+    Serial.println("INFO: no in-progress statistics from before the reset to restore");
+    return;
+  }
+
+  const uint8_t* payload = getRetainedSnapshot();
+  LoggerControllerSnapshot snapshot;
+  memcpy(&snapshot, payload, sizeof(snapshot));
+
+  // time since the snapshot (only known if the clock was synced and the RTC kept running)
+  int64_t downtime = 0;
+  if (snapshot.epoch_ms > 0 && Time.isValid()) {
+    downtime = (int64_t) ((uint64_t) Time.now() * 1000 + 500 - snapshot.epoch_ms);
+    if (downtime < 0) downtime = 0;
+  }
+
+  // millis64() started over --> move the data times from the old time line to the new one
+  int64_t time_shift = (int64_t) (millis64() - snapshot.local_ms) - downtime;
+
+  // continue the data log period where it was
+  last_data_log = millis() - (unsigned long) (snapshot.since_data_log + downtime);
+
+  // logs that were still waiting are gone
+  lost_logs = snapshot.state_logs + snapshot.data_logs;
+
+  size_t pos = sizeof(snapshot);
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    LoggerComponent* component = *components_iter;
+    for(int i = 0; i < component->data.size(); i++) {
+      component->data[i].restoreRetained(payload + pos, time_shift);
+      pos += LOGGER_DATA_RETAINED_SIZE;
+    }
+    component->restoreRetained(payload + pos, time_shift);
+    pos += component->getRetainedSize();
+  }
+
+  Serial.printlnf("INFO: restored in-progress statistics from before the reset (%lu s since the last data log, %lu s down, %u waiting logs lost)",
+    (unsigned long) (millis() - last_data_log) / 1000, (unsigned long) (downtime / 1000), lost_logs);
+}
+
+void LoggerController::retainSnapshot() {
+  uint8_t* payload = getRetainedBuffer();
+  LoggerControllerSnapshot snapshot;
+  snapshot.local_ms = millis64();
+  snapshot.epoch_ms = getEpochMillis(snapshot.local_ms);
+  snapshot.since_data_log = millis() - last_data_log;
+  snapshot.state_logs = retained_state_logs = particle_transport.state_logs->size();
+  snapshot.data_logs = retained_data_logs = particle_transport.data_logs->size();
+  memcpy(payload, &snapshot, sizeof(snapshot));
+
+  size_t pos = sizeof(snapshot);
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    LoggerComponent* component = *components_iter;
+    for(int i = 0; i < component->data.size(); i++) {
+      component->data[i].retain(payload + pos);
+      pos += LOGGER_DATA_RETAINED_SIZE;
+    }
+    component->retain(payload + pos);
+    pos += component->getRetainedSize();
+  }
+  commitRetained(retained_layout, pos);
+}
+
+/*** command registry ***/
+
+void LoggerController::registerCommands() {
+  addCommandVerb(CMD_LOCK, "lock on/off", NULL, &LoggerController::parseLocked);
+  addCommandVerb(CMD_STATE_LOG, "state-log on/off", NULL, &LoggerController::parseStateLogging);
+  addCommandVerb(CMD_DATA_LOG, "data-log on/off", NULL, &LoggerController::parseDataLogging);
+  addCommandVerb(CMD_DATA_LOG_PERIOD, "log-period number x/s/m/h", NULL, &LoggerController::parseDataLoggingPeriod);
+  addCommandVerb(CMD_DATA_READ_PERIOD, "read-period [component] manual/default/number ms/s/m", NULL, &LoggerController::parseDataReadingPeriod);
+  addCommandVerb(CMD_RESET, "reset data/state", NULL, &LoggerController::parseReset);
+  addCommandVerb(CMD_RESTART, "restart", NULL, &LoggerController::parseRestart);
+  addCommandVerb(CMD_MEM, "mem", NULL, &LoggerController::parseMemory);
+  addCommandVerb(CMD_HELP, "help", NULL, &LoggerController::parseHelp);
+  addCommandVerb(CMD_PAGE, "page [number]", NULL, &LoggerController::parsePage);
+  addCommandVerb(CMD_STREAM, "stream on/off", NULL, &LoggerController::parseStream);
+  addCommandVerb(CMD_READERS, "readers", NULL, &LoggerController::parseReaders);
+}
+
+bool LoggerController::registerCommand(const char* verb, const char* help, LoggerComponent* component) {
+  return(addCommandVerb(verb, help, component, NULL));
+}
+
+bool LoggerController::addCommandVerb(const char* verb, const char* help, LoggerComponent* component, bool (LoggerController::*parse)()) {
+  uint32_t hash = LoggerCommand::getHash(verb);
+  if (findCommand(hash, verb) != NULL) {
+    Serial.printlnf("WARNING: command '%s' is already registered, keeping the first registration", verb);
+    return(false);
+  }
+  if (command_verbs_n >= CMD_VERBS_MAX) {
+    Serial.printlnf("ERROR: cannot register command '%s', registry is full (increase CMD_VERBS_MAX)", verb);
+    return(false);
+  }
+  LoggerCommandVerb* entry = &command_verbs[command_verbs_n];
+  entry->verb = verb;
+  entry->help = help;
+  entry->hash = hash;
+  entry->component = component;
+  entry->parse = parse;
+  command_verbs_n++;
+  // open addressing with linear probing (the table is never full)
+  uint8_t slot = hash & (CMD_REGISTRY_SLOTS - 1);
+  while (command_slots[slot] != 0) slot = (slot + 1) & (CMD_REGISTRY_SLOTS - 1);
+  command_slots[slot] = command_verbs_n;
+  return(true);
+}
+
+LoggerCommandVerb* LoggerController::findCommand(uint32_t hash, const char* verb) {
+  uint8_t slot = hash & (CMD_REGISTRY_SLOTS - 1);
+  while (command_slots[slot] != 0) {
+    LoggerCommandVerb* entry = &command_verbs[command_slots[slot] - 1];
+    if (entry->hash == hash && strcmp(entry->verb, verb) == 0) return(entry);
+    slot = (slot + 1) & (CMD_REGISTRY_SLOTS - 1);
+  }
+  return(NULL);
+}
+
 /*** command parsing ***/
 
+// cloud function handler: only checks and queues the command (the cloud call returns right away)
+// unknown and locked commands are rejected here (returned to the caller), all other outcomes are reported in the state log
 int LoggerController::receiveCommand(String command_string) {
+  char text[CMD_MAX_CHAR];
+  command_string.toCharArray(text, sizeof(text));
+  // lock state as it will be once the commands that are already queued have run (e.g. a queued "lock off")
+  bool locked = command_queue.empty() ? state->locked : queued_locked;
+  int ret_val = checkCommand(text, &locked);
+  if (ret_val < 0) {
+    Serial.printlnf("WARNING: command '%s' NOT queued because it is %s", text, (ret_val == CMD_RET_ERR_LOCKED) ? CMD_RET_ERR_LOCKED_TEXT : CMD_RET_ERR_CMD_TEXT);
+    return(ret_val);
+  }
+  if (!command_queue.push(text)) {
+    Serial.printlnf("WARNING: command '%s' NOT queued because the command queue is full (%d commands)", text, CMD_QUEUE_SIZE);
+    return(CMD_RET_ERR_QUEUE_FULL);
+  }
+  queued_locked = locked;
+  if (debug_cloud) {
+    Serial.printlnf("DEBUG: command '%s' queued (%d waiting)", text, command_queue.size());
+  }
+  return(CMD_RET_QUEUED);
+}
+
+int LoggerController::checkCommand(const char* command_text) {
+  bool locked = command_queue.empty() ? state->locked : queued_locked;
+  return(checkCommand(command_text, &locked));
+}
+
+// only looks at the verbs (same tokens as executeCommand/executeCommandBatch), values are checked when the command runs
+// (except for the lock command: its value sets the lock state for the commands that follow)
+// the lock is checked again when the command runs (e.g. a queued "lock off" that fails leaves the logger locked)
+int LoggerController::checkCommand(const char* command_text, bool* locked_state) {
+  bool batch = strchr(command_text, CMD_BATCH_SEP) != NULL;
+  bool locked = *locked_state;
+  int commands_n = 0;
+  const char* text = command_text;
+  while (text != NULL) {
+
+    // next command (batch commands are trimmed)
+    const char* end = strchr(text, CMD_BATCH_SEP);
+    size_t length = (end != NULL) ? end - text : strlen(text);
+    if (batch) {
+      while (length > 0 && *text == ' ') { text++; length--; }
+    }
+
+    if (!batch || length > 0) {
+      // verb = first token (truncated like LoggerCommand::extractVariable)
+      char verb[sizeof(command->variable)];
+      size_t verb_length = 0;
+      while (verb_length < length && text[verb_length] != ' ') verb_length++;
+      if (verb_length > sizeof(verb) - 1) verb_length = sizeof(verb) - 1;
+      memcpy(verb, text, verb_length);
+      verb[verb_length] = 0;
+      if (verb_length == 0 || findCommand(LoggerCommand::getHash(verb), verb) == NULL) return(CMD_RET_ERR_CMD);
+      // only the lock command is allowed while locked (a batch may unlock first)
+      if (strcmp(verb, CMD_LOCK) == 0) {
+        // value = second token
+        const char* value = text + verb_length;
+        size_t value_length = length - verb_length;
+        while (value_length > 0 && *value == ' ') { value++; value_length--; }
+        size_t token_length = 0;
+        while (token_length < value_length && value[token_length] != ' ') token_length++;
+        if (token_length == strlen(CMD_LOCK_ON) && strncmp(value, CMD_LOCK_ON, token_length) == 0) locked = true;
+        else if (token_length == strlen(CMD_LOCK_OFF) && strncmp(value, CMD_LOCK_OFF, token_length) == 0) locked = false;
+      } else if (locked) {
+        return(CMD_RET_ERR_LOCKED);
+      }
+      commands_n++;
+    }
+
+    text = (end != NULL) ? end + 1 : NULL;
+  }
+  if (commands_n == 0) return(CMD_RET_ERR_CMD);
+  *locked_state = locked;
+  return(CMD_RET_SUCCESS);
+}
+
+void LoggerController::processCommandQueue() {
+  unsigned long start = millis();
+  while (!command_queue.empty()) {
+    executeCommand(command_queue.front());
+    command_queue.pop();
+    if (millis() - start >= CMD_QUEUE_BUDGET) break;
+  }
+}
+
+int LoggerController::executeCommand(const char* command_text) {
+
+  // several commands?
+  if (strchr(command_text, CMD_BATCH_SEP) != NULL) return(executeCommandBatch(command_text));
 
   // load, parse and finalize command
-  command->load(command_string);
+  command->load(command_text);
   command->extractVariable();
   parseCommand();
+  noteStackUsage();
 
   // mark error if type still undefined
   if (!command->isTypeDefined()) command->errorCommand();
@@ -384,24 +787,198 @@ int LoggerController::receiveCommand(String command_string) {
   return(command->ret_val);
 }
 
+// runs the commands back to back (no loop activity in between) and stops at the first command that fails,
+// the commands that already ran are then rolled back (controller and component states, stream, lcd page, pending restart)
+// the batch produces a single state log, state variable update and return value
+int LoggerController::executeCommandBatch(const char* command_text) {
+
+  char batch[CMD_MAX_CHAR];
+  strncpy(batch, command_text, sizeof(batch) - 1);
+  batch[sizeof(batch) - 1] = 0;
+  batch_data[0] = 0;
+  batch_msg[0] = 0;
+  batch_notes[0] = 0;
+  int ret_val = CMD_RET_UNDEFINED;
+  bool state_changed = false;
+  bool truncated = false;
+
+  // snapshot for the rollback
+  bool snapshot = snapshotBatchState();
+  bool was_streaming = isStreaming();
+  uint8_t page = lcd->getPage();
+  uint32_t reset = trigger_reset;
+  unsigned long reset_start = reset_timer_start;
+  running_batch = true;
+  batch_reset_data = false;
+  int commands_n = 0;
+
+  // run each command
+  char* next = batch;
+  while (next != NULL) {
+
+    // split off the next command and trim spaces
+    char* text = next;
+    next = strchr(text, CMD_BATCH_SEP);
+    if (next != NULL) *next++ = 0;
+    while (*text == ' ') text++;
+    for (int i = strlen(text) - 1; i >= 0 && text[i] == ' '; i--) text[i] = 0;
+    if (text[0] == 0) continue;
+
+    // load, parse and finalize command
+    command->load(text);
+    command->extractVariable();
+    parseCommand();
+    if (!command->isTypeDefined()) command->errorCommand();
+    commands_n++;
+    if (debug_state) {
+      Serial.printlnf("DEBUG: batch command '%s' returned %d", command->command, command->ret_val);
+    }
+
+    // combine outcome (first error > success > no change)
+    if (command->hasStateChanged()) state_changed = true;
+    if (command->ret_val < 0 || ret_val == CMD_RET_UNDEFINED || (ret_val == CMD_RET_WARN_NO_CHANGE && command->ret_val == CMD_RET_SUCCESS))
+      ret_val = command->ret_val;
+    if (command->data[0] != 0 && strcmp(command->data, "{}") != 0)
+      truncated |= !addToBatchText(batch_data, sizeof(batch_data), command->data, ",");
+    truncated |= !addToBatchText(batch_msg, sizeof(batch_msg), command->msg, "; ");
+    truncated |= !addToBatchText(batch_notes, sizeof(batch_notes), command->notes, "; ");
+
+    // stop at the first error
+    if (command->ret_val < 0) {
+      if (next != NULL) addToBatchText(batch_msg, sizeof(batch_msg), "remaining commands skipped", "; ");
+      break;
+    }
+  }
+  running_batch = false;
+  noteStackUsage();
+
+  // roll back the commands that already ran or finish the batch
+  if (ret_val < 0) {
+    bool rolled_back = snapshot && rollbackBatchState();
+    if (was_streaming && !isStreaming()) startStream();
+    else if (!was_streaming && isStreaming()) stopStream();
+    if (lcd->getPage() != page) lcd->setPage(page);
+    trigger_reset = reset;
+    reset_timer_start = reset_start;
+    if (rolled_back) updateStateVariable();
+    if (snapshot && commands_n > 1) addToBatchText(batch_msg, sizeof(batch_msg), "earlier commands rolled back", "; ");
+    state_changed = false;
+  } else if (batch_reset_data) {
+    resetData();
+  }
+  if (truncated) Serial.println("WARNING: command batch outcome too long, state log is truncated");
+
+  // combined command outcome
+  if (ret_val == CMD_RET_UNDEFINED) {
+    // no commands in the batch
+    command->load("");
+    command->errorCommand();
+    addToBatchText(batch_msg, sizeof(batch_msg), command->msg, "; ");
+  } else if (ret_val < 0) {
+    command->ret_val = ret_val;
+    strcpy(command->type, CMD_LOG_TYPE_ERROR);
+    strcpy(command->type_short, CMD_LOG_TYPE_ERROR_SHORT);
+  } else {
+    command->ret_val = ret_val;
+    strcpy(command->type, state_changed ? CMD_LOG_TYPE_STATE_CHANGED : CMD_LOG_TYPE_STATE_UNCHANGED);
+    strcpy(command->type_short, state_changed ? CMD_LOG_TYPE_STATE_CHANGED_SHORT : CMD_LOG_TYPE_STATE_UNCHANGED_SHORT);
+  }
+  strncpy(command->command, command_text, sizeof(command->command) - 1);
+  command->command[sizeof(command->command) - 1] = 0;
+  if (batch_data[0] == 0) strcpy(batch_data, "{}"); // empty data entry
+
+  // lcd info
+  updateDisplayCommandInformation();
+
+  // assemble and publish log
+  if (debug_webhooks) {
+    Serial.printlnf("DEBUG: webhook debugging is on --> always assemble state log and publish to variable '%s'\n", STATE_LOG_WEBHOOK);
+    override_state_log = true;
+  }
+  if (state->state_logging | override_state_log) {
+    assembleStateLog(command->type, batch_data, batch_msg, batch_notes);
+    queueStateLog();
+  }
+  override_state_log = false;
+
+  // state information
+  if (state_changed) {
+    updateStateVariable();
+  }
+
+  // command reporting callback
+  if (command_callback) command_callback();
+
+  // return value
+  return(command->ret_val);
+}
+
+// controller state followed by each component's state snapshot
+bool LoggerController::snapshotBatchState() {
+  size_t size = sizeof(*state);
+  for (int i = 0; i < components.size(); i++) size += components[i]->getStateSnapshotSize();
+  if (size > sizeof(batch_snapshot)) {
+    Serial.printlnf("WARNING: command batch states need %u bytes (CMD_BATCH_SNAPSHOT_SIZE is %u), a failing batch cannot be rolled back", size, sizeof(batch_snapshot));
+    return(false);
+  }
+  memcpy(batch_snapshot, state, sizeof(*state));
+  uint8_t* target = batch_snapshot + sizeof(*state);
+  for (int i = 0; i < components.size(); i++) {
+    components[i]->snapshotState(target);
+    target += components[i]->getStateSnapshotSize();
+  }
+  return(true);
+}
+
+bool LoggerController::rollbackBatchState() {
+  bool changed = false;
+  if (memcmp(state, batch_snapshot, sizeof(*state)) != 0) {
+    memcpy(state, batch_snapshot, sizeof(*state));
+    saveState();
+    Serial.println("INFO: controller state rolled back");
+    changed = true;
+  }
+  const uint8_t* source = batch_snapshot + sizeof(*state);
+  for (int i = 0; i < components.size(); i++) {
+    if (components[i]->rollbackState(source)) changed = true;
+    source += components[i]->getStateSnapshotSize();
+  }
+  return(changed);
+}
+
+void LoggerController::resetData() {
+  last_data_log = millis(); // reset last log
+  clearData(true); // clear all data
+  updateDataVariable(); // update data variable
+}
+
+// @return whether the text fit
+bool LoggerController::addToBatchText(char* target, size_t size, const char* text, const char* sep) {
+  if (text[0] == 0) return(true);
+  size_t length = strlen(target);
+  size_t needed = ((length > 0) ? strlen(sep) : 0) + strlen(text);
+  if (length + needed >= size) return(false);
+  if (length > 0) strcat(target, sep);
+  strcat(target, text);
+  return(true);
+}
+
 void LoggerController::parseCommand() {
 
+  // registered command?
+  LoggerCommandVerb* verb = findCommand(command->variable_hash, command->variable);
+
   // decision tree
   if (parseLocked()) {
     // locked is getting parsed
-  } else if (parseStateLogging()) {
-    // state logging getting parsed
-  } else if (parseDataLogging()) {
-    // data logging getting parsed
-  } else if (parseDataLoggingPeriod()) {
-    // parsing logging period
-  } else if (parseDataReadingPeriod()) {
-    // parsing reading period
-  } else if (parseReset()) {
-    // reset getting parsed
-  } else if (parseRestart()) {
-    // restart getting parsed
+  } else if (verb != NULL && verb->component != NULL) {
+    // registered component command
+    verb->component->parseCommand(command);
+  } else if (verb != NULL) {
+    // registered controller command
+    (this->*(verb->parse))();
   } else {
+    // commands that were not registered by their component
     parseComponentsCommand();
   }
 
@@ -467,15 +1044,15 @@ bool LoggerController::parseReset() {
   if (command->parseVariable(CMD_RESET)) {
     command->extractValue();
     if (command->parseValue(CMD_RESET_DATA)) {
-      last_data_log = millis(); // reset last log
-      clearData(true); // clear all data
-      updateDataVariable(); // update data variable
+      // in a batch: once all its commands succeeded
+      if (running_batch) batch_reset_data = true;
+      else resetData();
       command->success(true);
-      getStateStringText(CMD_RESET, CMD_RESET_DATA, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED, false);
+      getStateStringText(CMD_RESET, CMD_RESET_DATA, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
     } else  if (command->parseValue(CMD_RESET_STATE)) {
       resetState();
       command->success(true);
-      getStateStringText(CMD_RESET, CMD_RESET_STATE, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED, false);
+      getStateStringText(CMD_RESET, CMD_RESET_STATE, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
       command->setLogMsg("restarting system...");
       trigger_reset = RESET_STATE;
       reset_timer_start = millis();
@@ -496,6 +1073,102 @@ bool LoggerController::parseRestart() {
   return(command->isTypeDefined());
 }
 
+bool LoggerController::parseHelp() {
+  if (command->parseVariable(CMD_HELP)) {
+    command->success(true);
+    getStateIntText(CMD_HELP, command_verbs_n, "cmds", command->data, sizeof(command->data), PATTERN_KVU_JSON);
+    // all verbs in the log message (as many as fit), details on serial
+    int msg_length = 0;
+    for (int i = 0; i < command_verbs_n; i++) {
+      addToList(command->msg, sizeof(command->msg), &msg_length, command_verbs[i].verb, " ");
+      Serial.printlnf("INFO: command '%s' (%s): %s", command_verbs[i].verb,
+        (command_verbs[i].component != NULL) ? command_verbs[i].component->id : "controller", command_verbs[i].help);
+    }
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseReaders() {
+  if (command->parseVariable(CMD_READERS)) {
+    command->success(true);
+    getStateIntText(CMD_READERS, readers.size(), "readers", command->data, sizeof(command->data), PATTERN_KVU_JSON);
+    // summary of each reader in the log message (as many as fit), details on serial and in a separate state log
+    char text[200];
+    int msg_length = 0;
+    for (int i = 0; i < readers.size(); i++) {
+      readers[i]->getDataReadSummaryText(text, sizeof(text));
+      addToList(command->msg, sizeof(command->msg), &msg_length, text, "; ");
+      readers[i]->getDataReadStatsText(text, sizeof(text));
+      Serial.printlnf("INFO: reader '%s': %s", readers[i]->id, text);
+    }
+    DataReaderLoggerComponent::getDataReadLatencyBoundsText(text, sizeof(text));
+    Serial.printlnf("INFO: reader latency bins: %s", text);
+    if (state->state_logging && !readers.empty()) {
+      last_readers_log = millis();
+      assembleReadersLog();
+      queueStateLog();
+    }
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parsePage() {
+  if (command->parseVariable(CMD_PAGE)) {
+    command->extractValue();
+    if (command->value[0] == 0) {
+      // next page
+      lcd->nextPage();
+      command->success(true);
+    } else if (atoi(command->value) >= 1 && atoi(command->value) <= lcd->getPagesN()) {
+      // specific page
+      command->success(atoi(command->value) - 1 != lcd->getPage());
+      lcd->setPage(atoi(command->value) - 1);
+    } else {
+      command->errorValue();
+    }
+    getStateStringText(CMD_PAGE, lcd->getPageName(lcd->getPage()), command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+    snprintf(command->msg, sizeof(command->msg), "page %d of %d", lcd->getPage() + 1, lcd->getPagesN());
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseStream() {
+  if (command->parseVariable(CMD_STREAM)) {
+    command->extractValue();
+    if (command->parseValue(CMD_STREAM_ON)) {
+      command->success(!isStreaming());
+      if (!isStreaming()) {
+        // channel map for the stream reader (text between the frames)
+        for (int i = 0; i < components.size(); i++) {
+          for (int j = 0; j < components[i]->data.size(); j++) {
+            LoggerData* data = &components[i]->data[j];
+            Serial.printlnf("STREAM: #%d %s [%s] (%s)", data->idx, data->variable, data->getUnits(), components[i]->id);
+          }
+        }
+        startStream();
+      }
+    } else if (command->parseValue(CMD_STREAM_OFF)) {
+      command->success(isStreaming());
+      stopStream();
+    }
+    getStateBooleanText(CMD_STREAM, isStreaming(), CMD_STREAM_ON, CMD_STREAM_OFF, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED, true);
+    snprintf(command->msg, sizeof(command->msg), "%lu records streamed, %lu dropped", getStreamedRecords(), getStreamDropped());
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseMemory() {
+  if (command->parseVariable(CMD_MEM)) {
+    command->success(true);
+    getStateIntText(CMD_MEM, System.freeMemory(), "B", command->data, sizeof(command->data), PATTERN_KVU_JSON);
+    snprintf(command->msg, sizeof(command->msg), "lfb %luB, new %lu (%luB), stack %luB, hw sls %u dls %u (%uB)",
+      getLargestFreeHeapBlock(), getHeapAllocations(), getHeapBytesAllocated(), getStackHighWater(),
+      particle_transport.state_logs->maxSize(), particle_transport.data_logs->maxSize(), particle_transport.data_logs->maxBytesUsed());
+    Serial.printlnf("INFO: memory: free %luB, %s", System.freeMemory(), command->msg);
+  }
+  return(command->isTypeDefined());
+}
+
 bool LoggerController::parseDataLoggingPeriod() {
   if (command->parseVariable(CMD_DATA_LOG_PERIOD)) {
     // parse read period
@@ -504,25 +1177,33 @@ bool LoggerController::parseDataLoggingPeriod() {
     if (log_period > 0) {
       command->extractUnits();
       uint8_t log_type = LOG_BY_TIME;
+      int factor = 0; // to seconds
       if (command->parseUnits(CMD_DATA_LOG_PERIOD_NUMBER)) {
         // events
         log_type = LOG_BY_EVENT;
+        factor = 1;
       } else if (command->parseUnits(CMD_DATA_LOG_PERIOD_SEC)) {
         // seconds (the base unit)
-        log_period = log_period;
+        factor = 1;
       } else if (command->parseUnits(CMD_DATA_LOG_PERIOD_MIN)) {
         // minutes
-        log_period = 60 * log_period;
+        factor = 60;
       } else if (command->parseUnits(CMD_DATA_LOG_PERIOD_HR)) {
-        // minutes
-        log_period = 60 * 60 * log_period;
+        // hours
+        factor = 60 * 60;
       } else {
         // unrecognized units
         command->errorUnits();
       }
+      // log periods must be representable in ms
+      if (factor > 0 && log_period > INT_MAX / 1000 / factor) {
+        command->errorValue();
+      } else {
+        log_period = factor * log_period;
+      }
       // assign read period
       if (!command->isTypeDefined()) {
-        if (log_type == LOG_BY_EVENT || (log_type == LOG_BY_TIME && (log_period * 1000) > state->data_reading_period))
+        if (log_type == LOG_BY_EVENT || (log_type == LOG_BY_TIME && (uint) (log_period * 1000) > getDataReadingPeriodMax()))
           command->success(changeDataLoggingPeriod(log_period, log_type));
         else
           // make sure smaller than log period
@@ -540,58 +1221,84 @@ bool LoggerController::parseDataLoggingPeriod() {
 bool LoggerController::parseDataReadingPeriod() {
   if (command->parseVariable(CMD_DATA_READ_PERIOD)) {
 
+    // component specific read period?
+    DataReaderLoggerComponent* reader = NULL;
+    for(int i = 0; i < readers.size() && reader == NULL; i++) {
+      if (command->extractComponent(readers[i]->id)) reader = readers[i];
+    }
+
     // parse read period
     command->extractValue();
+    int read_period;
 
     if(!state->data_reader) {
       // not actually a data reader
       command->error(CMD_RET_ERR_NOT_A_READER, CMD_RET_ERR_NOT_A_READER_TEXT);
-    } else if (command->parseValue(CMD_DATA_READ_PERIOD_MANUAL)){
-      // manual reads
-      command->success(changeDataReadingPeriod(READ_MANUAL));
-    } else {
-      // specific read period
-      int read_period = atoi(command->value);
-      if (read_period > 0) {
-        command->extractUnits();
-        if (command->parseUnits(CMD_DATA_READ_PERIOD_MS)) {
-          // milli seconds (the base unit)
-          read_period = read_period;
-        } else if (command->parseUnits(CMD_DATA_READ_PERIOD_SEC)) {
-          // seconds
-          read_period = 1000 * read_period;
-        } else if (command->parseUnits(CMD_DATA_READ_PERIOD_MIN)) {
-          // minutes
-          read_period = 1000 * 60 * read_period;
-        } else {
-          // unrecognized units
-          command->errorUnits();
-        }
-        // assign read period
-        if (!command->isTypeDefined()) {
-          if (read_period < state->data_reading_period_min)
-            // make sure bigger than minimum
-            command->error(CMD_RET_ERR_READ_LARGER_MIN, CMD_RET_ERR_READ_LARGER_MIN_TEXT);
-          else if (state->data_logging_type == LOG_BY_TIME && state->data_logging_period * 1000 <= read_period)
-            // make sure smaller than log period
-            command->error(CMD_RET_ERR_LOG_SMALLER_READ, CMD_RET_ERR_LOG_SMALLER_READ_TEXT);
-          else
-            command->success(changeDataReadingPeriod(read_period));
-        }
-      } else {
-        // invalid value
-        command->errorValue();
-      }
+    } else if (reader != NULL && command->parseValue(CMD_DATA_READ_PERIOD_DEFAULT)) {
+      // back to the controller's read period
+      command->success(reader->resetDataReadingPeriod());
+    } else if (parseDataReadingPeriodValue(&read_period)) {
+      // assign read period
+      (reader != NULL) ?
+        command->success(reader->changeDataReadingPeriod(read_period)) :
+        command->success(changeDataReadingPeriod(read_period));
     }
 
     // include current read period in data
     if(state->data_reader) {
-      getStateDataReadingPeriodText(state->data_reading_period, command->data, sizeof(command->data));
+      (reader != NULL) ?
+        getStateDataReadingPeriodText(reader->getDataReadPeriod(), command->data, sizeof(command->data)) :
+        getStateDataReadingPeriodText(state->data_reading_period, command->data, sizeof(command->data));
     }
   }
   return(command->isTypeDefined());
 }
 
+bool LoggerController::parseDataReadingPeriodValue(int* read_period) {
+  if (command->parseValue(CMD_DATA_READ_PERIOD_MANUAL)){
+    // manual reads
+    *read_period = READ_MANUAL;
+    return(true);
+  }
+  // specific read period
+  *read_period = atoi(command->value);
+  if (*read_period <= 0) {
+    // invalid value
+    command->errorValue();
+    return(false);
+  }
+  command->extractUnits();
+  int factor = 0; // to ms
+  if (command->parseUnits(CMD_DATA_READ_PERIOD_MS)) {
+    // milli seconds (the base unit)
+    factor = 1;
+  } else if (command->parseUnits(CMD_DATA_READ_PERIOD_SEC)) {
+    // seconds
+    factor = 1000;
+  } else if (command->parseUnits(CMD_DATA_READ_PERIOD_MIN)) {
+    // minutes
+    factor = 1000 * 60;
+  } else {
+    // unrecognized units
+    command->errorUnits();
+  }
+  if (factor > 0 && *read_period > INT_MAX / factor) {
+    // too large
+    command->errorValue();
+  } else {
+    *read_period = factor * *read_period;
+  }
+  if (!command->isTypeDefined()) {
+    if (*read_period < state->data_reading_period_min)
+      // make sure bigger than minimum
+      command->error(CMD_RET_ERR_READ_LARGER_MIN, CMD_RET_ERR_READ_LARGER_MIN_TEXT);
+    else if (state->data_logging_type == LOG_BY_TIME && (uint64_t) state->data_logging_period * 1000 <= (uint64_t) *read_period)
+      // make sure smaller than log period
+      command->error(CMD_RET_ERR_LOG_SMALLER_READ, CMD_RET_ERR_LOG_SMALLER_READ_TEXT);
+  }
+  return(!command->isTypeDefined());
+}
+
 /*** state changes ***/
 
 // locking
@@ -609,7 +1316,7 @@ bool LoggerController::changeLocked(bool on) {
       on ? Serial.println("DEBUG: Logger already locked") : Serial.println("DEBUG: Logger already unlocked");
   }
 
-  if (changed) saveState();
+  if (changed) saveState(); // lock saved right away (safety)
 
   return(changed);
 }
@@ -630,7 +1337,7 @@ bool LoggerController::changeStateLogging (bool on) {
       on ? Serial.println("DEBUG: state logging already on") : Serial.println("DEBUG: state logging already off");
   }
 
-  if (changed) saveState();
+  if (changed) markStateDirty();
 
   return(changed);
 }
@@ -657,7 +1364,7 @@ bool LoggerController::changeDataLogging (bool on) {
       on ? Serial.println("DEBUG: data logging already on") : Serial.println("DEBUG: data logging already off");
   }
 
-  if (changed) saveState();
+  if (changed) markStateDirty();
 
   // make sure all data is cleared
   if (changed && on) clearData(true);
@@ -679,7 +1386,7 @@ bool LoggerController::changeDataLoggingPeriod(int period, int type) {
     else Serial.printf("DEBUG: data logging period unchanged (%d)\n", type == LOG_BY_TIME ? "seconds" : "reads");
   }
 
-  if (changed) saveState();
+  if (changed) markStateDirty();
 
   return(changed);
 }
@@ -704,11 +1411,19 @@ bool LoggerController::changeDataReadingPeriod(int period) {
     else Serial.printf("DEBUG: data reading period unchanged (%d ms)\n", period);
   }
 
-  if (changed) saveState();
+  if (changed) markStateDirty();
 
   return(changed);
 }
 
+uint LoggerController::getDataReadingPeriodMax() {
+  uint period = state->data_reading_period;
+  for(int i = 0; i < readers.size(); i++) {
+    if (readers[i]->getDataReadPeriod() > period) period = readers[i]->getDataReadPeriod();
+  }
+  return(period);
+}
+
 /*** command info to display ***/
 
 void LoggerController::updateDisplayCommandInformation() {
@@ -793,12 +1508,54 @@ void LoggerController::updateDisplayComponentsStateInformation() {
   }
 }
 
+/*** lcd pages ***/
+
+void LoggerController::renderMainPageCallback(LoggerDisplay* lcd, void* ctrl) {
+  ((LoggerController*) ctrl)->renderMainPage();
+}
+
+void LoggerController::renderSystemPageCallback(LoggerDisplay* lcd, void* ctrl) {
+  ((LoggerController*) ctrl)->renderSystemPage();
+}
+
+void LoggerController::renderMainPage() {
+  updateDisplayComponentsStateInformation();
+  if (state_update_callback) state_update_callback();
+  if (data_update_callback) data_update_callback();
+}
+
+void LoggerController::renderSystemPage() {
+  snprintf(lcd_buffer, sizeof(lcd_buffer), "Mem: %luB free", System.freeMemory());
+  lcd->printLine(2, lcd_buffer);
+  if (lcd->getLines() < 3) return;
+  snprintf(lcd_buffer, sizeof(lcd_buffer), "Logs: S%u D%u %uB", particle_transport.state_logs->size(), particle_transport.data_logs->size(), particle_transport.data_logs->bytesUsed());
+  lcd->printLine(3, lcd_buffer);
+  if (lcd->getLines() < 4) return;
+  snprintf(lcd_buffer, sizeof(lcd_buffer), "Store: %u/%uB g%u", state_store.getUsed(), state_store.getCapacity(), state_store.getGeneration());
+  lcd->printLine(4, lcd_buffer);
+}
+
+// switches to the next page on a (debounced) button press
+void LoggerController::updatePageButton() {
+  if (page_button_pin < 0) return;
+  bool pressed = (digitalRead(page_button_pin) == HIGH);
+  if (pressed == page_button_pressed) {
+    page_button_change = millis();
+  } else if (millis() - page_button_change > PAGE_BUTTON_DEBOUNCE) {
+    page_button_pressed = pressed;
+    if (pressed) {
+      lcd->nextPage();
+      snprintf(lcd_buffer, sizeof(lcd_buffer), "Page %d: %s", lcd->getPage() + 1, lcd->getPageName(lcd->getPage()));
+      lcd->printLineTemp(1, lcd_buffer);
+    }
+  }
+}
+
 /*** logger state variable ***/
 
 void LoggerController::updateStateVariable() {
   updateDisplayStateInformation();
-  updateDisplayComponentsStateInformation();
-  if (state_update_callback) state_update_callback();
+  lcd->markPageDirty(main_page);
   state_variable_buffer[0] = 0; // reset buffer
   assembleStateVariable();
   assembleComponentsStateVariable();
@@ -834,13 +1591,18 @@ void LoggerController::addToStateVariableBuffer(char* info) {
 }
 
 void LoggerController::postStateVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
-  // dt = datetime, s = state information
+  formatLocalTime(date_time_buffer, sizeof(date_time_buffer));
+  // dt = datetime, mem = free memory, lfb = largest free memory block, new = heap allocations [count, bytes], 
+  // sls/dls = state/data log stack size, hw = high-water marks [state log stack, data log stack, data log stack bytes, stack bytes], 
+  // s = state information
+  noteStackUsage();
   snprintf(state_variable, sizeof(state_variable), 
-    "{\"dt\":\"%s\",\"version\":\"%s\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"mem\":%lu,\"sls\":%d,\"dls\":%d,\"s\":[%s]}",
+    "{\"dt\":\"%s\",\"version\":\"%s\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"mem\":%lu,\"lfb\":%lu,\"new\":[%lu,%lu],\"sls\":%d,\"dls\":%d,\"hw\":[%u,%u,%u,%lu],\"s\":[%s]}",
     date_time_buffer, version, 
     mac_address[0], mac_address[1], mac_address[2], mac_address[3], mac_address[4], mac_address[5],
-    System.freeMemory(), state_log_stack.size(), data_log_stack.size(),
+    System.freeMemory(), getLargestFreeHeapBlock(), getHeapAllocations(), getHeapBytesAllocated(),
+    particle_transport.state_logs->size(), particle_transport.data_logs->size(),
+    particle_transport.state_logs->maxSize(), particle_transport.data_logs->maxSize(), particle_transport.data_logs->maxBytesUsed(), getStackHighWater(),
     state_variable_buffer);
   if (debug_cloud) {
     Serial.printf("DEBUG: updated state variable: %s\n", state_variable);
@@ -865,6 +1627,11 @@ void LoggerController::assembleStartupLog() {
   } else if (past_reset == RESET_WATCHDOG) {
     strcpy(command->msg, "triggered by application watchdog");
   }
+  if (lost_logs > 0) {
+    // waiting logs did not survive the reset (the in-progress statistics did)
+    size_t msg_length = strlen(command->msg);
+    snprintf(command->msg + msg_length, sizeof(command->msg) - msg_length, (msg_length > 0) ? ", %u waiting logs lost" : "%u waiting logs lost", lost_logs);
+  }
   assembleStateLog();
 }
 
@@ -878,14 +1645,36 @@ void LoggerController::assembleMissedDataLog() {
   assembleStateLog();
 }
 
+void LoggerController::assembleReadersLog() {
+  char data[STATE_LOG_MAX_CHAR - 200]; // leave room for the rest of the state log
+  char text[200];
+  char msg[80];
+  int data_length = 0;
+  int omitted = 0;
+  data[0] = 0;
+  for (int i = 0; i < readers.size(); i++) {
+    readers[i]->getDataReadStatsText(text, sizeof(text));
+    if (!addToList(data, sizeof(data), &data_length, text, ",")) omitted++;
+  }
+  DataReaderLoggerComponent::getDataReadLatencyBoundsText(text, sizeof(text));
+  (omitted > 0) ?
+    snprintf(msg, sizeof(msg), "latency bins %s (%d readers omitted)", text, omitted) :
+    snprintf(msg, sizeof(msg), "latency bins %s", text);
+  assembleStateLog(CMD_LOG_TYPE_READERS, data, msg, "");
+}
+
 void LoggerController::assembleStateLog() {
-  state_log[0] = 0;
   if (command->data[0] == 0) strcpy(command->data, "{}"); // empty data entry
+  assembleStateLog(command->type, command->data, command->msg, command->notes);
+}
+
+void LoggerController::assembleStateLog(const char* type, const char* data, const char* msg, const char* notes) {
+  state_log[0] = 0;
   // id = Logger name, dt = log datetime, t = state log type, s = state change, m = message, n = notes
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+  formatLocalTime(date_time_buffer, sizeof(date_time_buffer));
   int buffer_size = snprintf(state_log, sizeof(state_log),
      "{\"id\":\"%s\",\"dt\":\"%s\",\"t\":\"%s\",\"s\":[%s],\"m\":\"%s\",\"n\":\"%s\"}",
-     name, date_time_buffer, command->type, command->data, command->msg, command->notes);
+     name, date_time_buffer, type, data, msg, notes);
   if (buffer_size < 0 || buffer_size >= sizeof(state_log)) {
     Serial.println("ERROR: state log buffer not large enough for state log");
     lcd->printLineTemp(1, "ERR: statelog too big");
@@ -899,33 +1688,39 @@ void LoggerController::queueStateLog() {
   } else if (debug_webhooks) {
     Serial.printlnf("WARNING: state log '%s' NOT queued because in WEBHOOKS_DEBUG_ON mode.", state_log);
   } else {
-    state_log_stack.push_back(state_log);
-    if (debug_cloud) {
-      Serial.printlnf("DEBUG: added log #%d to state log stack: '%s'", state_log_stack.size(), state_log_stack.back().c_str());
+    for (uint8_t i = 0; i < transports_n; i++) {
+      LoggerTransport* transport = transports[i];
+      if (!transport->queueLog(TRANSPORT_STATE_LOG, state_log)) {
+        Serial.printlnf("ERROR: state log '%s' NOT queued for transport '%s' because its state log stack is full (%d bytes).", 
+          state_log, transport->name, transport->state_logs->bytesCapacity());
+      } else if (debug_cloud) {
+        Serial.printlnf("DEBUG: added log #%d to '%s' state log stack: '%s'", transport->state_logs->size(), transport->name, transport->state_logs->back());
+      }
     }
   }
   postStateVariable(); // update state variable stack info
 }
 
-void LoggerController::publishStateLog() {
+void LoggerController::publishStateLog(LoggerTransport* transport) {
   
-  if (!state_log_stack.empty()) {
+  LoggerLogStackBase* logs = transport->state_logs;
+  if (!logs->empty()) {
 
     // process from back to front (i.e. always latest log first) for speed and to avoid memory fragmentation
     if (debug_cloud) {
-      Serial.printf("DEBUG: publishing last state log (#%d) to event '%s': '%s'... ", 
-        state_log_stack.size(), STATE_LOG_WEBHOOK, state_log_stack.back().c_str());
+      Serial.printf("DEBUG: publishing last state log (#%d) via '%s': '%s'... ", 
+        logs->size(), transport->name, logs->back());
     }
     
-    bool success = Particle.publish(STATE_LOG_WEBHOOK, state_log_stack.back().c_str(), WITH_ACK);
+    bool success = transport->send(TRANSPORT_STATE_LOG, logs->back());
     if (debug_cloud) {
       if (success) Serial.println("successful.");
       else Serial.println("failed!");
     }
 
     if (success) {
-      state_log_stack.pop_back();
-      postStateVariable(); // update state variable stack info
+      logs->pop();
+      if (transport == &particle_transport) postStateVariable(); // update state variable stack info
     }
 
   }
@@ -935,7 +1730,7 @@ void LoggerController::publishStateLog() {
 /*** logger data variable ***/
 
 void LoggerController::updateDataVariable() {
-  if (data_update_callback) data_update_callback();
+  lcd->markPageDirty(main_page);
   data_variable_buffer[0] = 0; // reset buffer
   assembleComponentsDataVariable();
   postDataVariable();
@@ -959,7 +1754,7 @@ void LoggerController::addToDataVariableBuffer(char* info) {
 }
 
 void LoggerController::postDataVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+  formatLocalTime(date_time_buffer, sizeof(date_time_buffer));
   // dt = datetime, d = structured data
   snprintf(data_variable, sizeof(data_variable), "{\"dt\":\"%s\",\"d\":[%s]}",
     date_time_buffer, data_variable_buffer);
@@ -973,6 +1768,27 @@ void LoggerController::postDataVariable() {
 
 /*** particle webhook data log ***/
 
+void LoggerController::updateDataLogs() {
+  // latest samples for the transports with their own data log period
+  for (uint8_t i = 0; i < transports_n; i++) {
+    if (transports[i]->isTimeForDataLog()) {
+      transports[i]->markDataLog();
+      logSamples(transports[i]);
+    }
+  }
+
+  // averaged data logs
+  if (isTimeForDataLogAndClear()) {
+    last_data_log = millis();
+    // samples that were not logged yet would be cleared
+    for (uint8_t i = 0; i < transports_n; i++) {
+      if (transports[i]->hasDataLogPeriod()) logSamples(transports[i]);
+    }
+    logData();
+    clearData(false);
+  }
+}
+
 bool LoggerController::isTimeForDataLogAndClear() {
 
   if (state->data_logging_type == LOG_BY_TIME) {
@@ -980,7 +1796,7 @@ bool LoggerController::isTimeForDataLogAndClear() {
     unsigned long log_period = state->data_logging_period * 1000;
     if ((millis() - last_data_log) > log_period) {
       if (debug_data) {
-        Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+        formatLocalTime(date_time_buffer, sizeof(date_time_buffer));
         Serial.printf("DEBUG: triggering data log at %s (after %d seconds)\n", date_time_buffer, state->data_logging_period);
       }
       return(true);
@@ -991,7 +1807,7 @@ bool LoggerController::isTimeForDataLogAndClear() {
     // go by read number
     if (data[0].getN() >= state->data_logging_period) {
       if (debug_data) {
-      Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+      formatLocalTime(date_time_buffer, sizeof(date_time_buffer));
       Serial.printf("INFO: triggering data log at %s (after %d reads)\n", date_time_buffer, state->data_logging_period);
       }
       return(true);
@@ -1020,11 +1836,15 @@ void LoggerController::logData() {
     override_data_log = true;
   }
   if (state->data_logging | override_data_log) {
-      // log data for components
+      // log data for components (packed together into shared data logs)
+      resetDataLog();
+      packing_data_logs = true;
       std::vector<LoggerComponent*>::iterator components_iter = components.begin();
       for(; components_iter != components.end(); components_iter++) {
         (*components_iter)->logData();
       }
+      packing_data_logs = false;
+      completeDataLog();
   } else {
     if (debug_cloud) {
       Serial.println("DEBUG: data log is turned off --> continue without logging");
@@ -1032,9 +1852,61 @@ void LoggerController::logData() {
   }
 }
 
+void LoggerController::logSamples(LoggerTransport* transport) {
+  if (!state->data_logging) return;
+  // newest values that arrived since the last samples (packed into the same data logs as the averages, queued for this transport only)
+  resetDataLog();
+  packing_data_logs = true;
+  sample_transport = transport;
+  uint64_t newest_time = transport->last_sample_time;
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++) {
+    LoggerComponent* component = *components_iter;
+    for(int i = 0; i < component->data.size(); i++) {
+      LoggerData* data = &component->data[i];
+      if (!data->newest_value_valid || data->getNewestDataTime() <= transport->last_sample_time) continue;
+      if (data->getNewestDataTime() > newest_time) newest_time = data->getNewestDataTime();
+      addToDataLog(data);
+    }
+  }
+  packing_data_logs = false;
+  completeDataLog();
+  sample_transport = NULL;
+  transport->last_sample_time = newest_time;
+}
+
 void LoggerController::resetDataLog() {
   data_log[0] = 0;
   data_log_buffer[0] = 0;
+  data_log_time = 0;
+}
+
+bool LoggerController::addToDataLog(LoggerData* data) {
+  // latest sample (see logSamples) or averages
+  bool sample = (sample_transport != NULL);
+  if (sample ? !data->newest_value_valid : data->getN() == 0) return(false); // nothing to log
+  uint64_t time = getEpochMillis(sample ? data->getNewestDataTime() : data->getDataTime());
+
+  // add to the current data log (with its own time if it differs from the log's)
+  if (data_log_buffer[0] != 0) {
+    sample ? data->assembleSampleLog(time != data_log_time) : data->assembleLog(time != data_log_time);
+    if (addToDataLogBuffer(data->json)) return(true);
+    // full --> queue it and start a new one
+    if (debug_cloud) Serial.println("DEBUG: data log is full, queueing it and starting a new one");
+    if (finalizeDataLog(true, data_log_time)) queueDataLog();
+    resetDataLog();
+  }
+
+  // first data of a new data log (sets the log's time)
+  data_log_time = time;
+  sample ? data->assembleSampleLog(false) : data->assembleLog(false);
+  return(addToDataLogBuffer(data->json));
+}
+
+void LoggerController::completeDataLog() {
+  if (packing_data_logs || data_log_buffer[0] == 0) return;
+  if (finalizeDataLog(true, data_log_time)) queueDataLog();
+  resetDataLog();
 }
 
 bool LoggerController::addToDataLogBuffer(char* info) {
@@ -1042,8 +1914,8 @@ bool LoggerController::addToDataLogBuffer(char* info) {
   // debug
   if (debug_data) Serial.printf("DEBUG: trying to add '%s' to data log... ", info);
 
-  // characters reserved for rest of data log
-  const uid_t reserve = 50;
+  // characters reserved for rest of data log (id, dt, t and brackets, see finalizeDataLog)
+  const uid_t reserve = 90;
   if (strlen(data_log_buffer) + strlen(info) + reserve >= sizeof(data_log)) {
     // not enough space in the data log to add more to the buffer
     if (debug_data) Serial.println("but log is at the size limit.");
@@ -1064,14 +1936,17 @@ bool LoggerController::addToDataLogBuffer(char* info) {
   return(true);
 }
 
-bool LoggerController::finalizeDataLog(bool use_common_time, unsigned long common_time) {
+bool LoggerController::finalizeDataLog(bool use_common_time, uint64_t common_time) {
+  noteStackUsage();
   // data
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+  formatLocalTime(date_time_buffer, sizeof(date_time_buffer));
   int buffer_size;
   if (use_common_time) {
-    // id = Logger name, dt = log datetime, to = time offset from log datetime (global), d = structured data
-    buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"to\":%lu,\"d\":[%s]}", 
-      name, date_time_buffer, common_time, data_log_buffer);
+    // id = Logger name, dt = log datetime, t = data time (UTC epoch in ms, global, null if the clock is not synced), d = structured data
+    char time_text[EPOCH_TEXT_SIZE];
+    getEpochMillisText(common_time, time_text, sizeof(time_text));
+    buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"t\":%s,\"d\":[%s]}", 
+      name, date_time_buffer, time_text, data_log_buffer);
   } else {
     // indivudal time
     buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"d\":[%s]}", 
@@ -1092,47 +1967,62 @@ void LoggerController::queueDataLog() {
     Serial.printlnf("WARNING: data log '%s' NOT queued because startup is not yet complete.", data_log);
   } else if (debug_webhooks) {
     Serial.printlnf("WARNING: data log '%s' NOT queued because in WEBHOOKS_DEBUG_ON mode.", data_log);
-  } else if (System.freeMemory() < memory_reserve) {
-    out_of_memory = true;
-    missed_data++;
-    Serial.printlnf("WARNING: data log '%s' NOT queued because free memory < memory reserve (%d bytes), total %d data logs missed.", 
-      data_log, memory_reserve, missed_data);
   } else {
-    out_of_memory = false;
-    data_log_stack.push_back(data_log);
-    if (debug_cloud) {
-      Serial.printlnf("DEBUG: added log #%d to data log stack: '%s'", data_log_stack.size(), data_log_stack.back().c_str());
+    for (uint8_t i = 0; i < transports_n; i++) {
+      LoggerTransport* transport = transports[i];
+      // samples only go to their transport, averages only to the transports without a data log period
+      if (sample_transport != NULL ? transport != sample_transport : transport->hasDataLogPeriod()) continue;
+      if (!transport->queueLog(TRANSPORT_DATA_LOG, data_log)) {
+        if (transport == &particle_transport) {
+          out_of_memory = true;
+          missed_data++;
+          Serial.printlnf("WARNING: data log '%s' NOT queued because the data log stack is full (%d bytes), total %d data logs missed.", 
+            data_log, transport->data_logs->bytesCapacity(), missed_data);
+        } else {
+          Serial.printlnf("WARNING: data log NOT queued for transport '%s' because its data log stack is full (%d bytes), total %lu logs dropped.", 
+            transport->name, transport->data_logs->bytesCapacity(), transport->dropped);
+        }
+      } else {
+        if (transport == &particle_transport) out_of_memory = false;
+        if (debug_cloud) {
+          Serial.printlnf("DEBUG: added log #%d to '%s' data log stack: '%s'", transport->data_logs->size(), transport->name, transport->data_logs->back());
+        }
+      }
     }
   }
-  postStateVariable(); // update state variable stack info
+  if (sample_transport == NULL) postStateVariable(); // update state variable stack info (particle data log stack)
 }
 
-void LoggerController::publishDataLog() {
+void LoggerController::publishDataLog(LoggerTransport* transport) {
   
-  if (!data_log_stack.empty()) {
+  LoggerLogStackBase* logs = transport->data_logs;
+  if (!logs->empty()) {
 
-    size_t log_n = data_log_stack.size();
+    size_t log_n = logs->size();
 
     // process from back to front (i.e. always latest log first) for speed and to avoid memory fragmentation
     if (debug_cloud) {
-      Serial.printf("DEBUG: publishing last data log (#%d) to event '%s': '%s'... ", 
-        log_n, DATA_LOG_WEBHOOK, data_log_stack.back().c_str());
+      Serial.printf("DEBUG: publishing last data log (#%d) via '%s': '%s'... ", 
+        log_n, transport->name, logs->back());
     }
 
-    // particle is connected, try to publish the latest log
-    bool success = Particle.publish(DATA_LOG_WEBHOOK, data_log_stack.back().c_str(), WITH_ACK);
+    // transport is connected, try to send the latest log
+    bool success = transport->send(TRANSPORT_DATA_LOG, logs->back());
     
     if (debug_cloud) {
       if (success) Serial.println("successful.");
       else Serial.println("failed!");
     }
 
-    if (success) {
+    if (transport != &particle_transport) {
+      // local transports: no lcd messages (too frequent)
+      if (success) logs->pop();
+    } else if (success) {
       (log_n > 1) ?
         snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log %d sent", log_n) :
         snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log sent");
       lcd->printLineTemp(1, lcd_buffer);
-      data_log_stack.pop_back();
+      logs->pop();
       postStateVariable(); // update state variable stack info
     } else {
       snprintf(lcd_buffer, sizeof(lcd_buffer), "ERR: data log %d error", log_n);
@@ -2,7 +2,15 @@
 #include <vector>
 #include "LoggerUtils.h"
 #include "LoggerCommand.h"
+#include "LoggerData.h"
 #include "LoggerDisplay.h"
+#include "LoggerTransport.h"
+#include "LoggerMemory.h"
+#include "LoggerStateStore.h"
+#include "LoggerCommandQueue.h"
+#include "LoggerClock.h"
+#include "LoggerStream.h"
+#include "LoggerRetained.h"
 
 /*** time sync ***/
 #define ONE_DAY_MILLIS (24 * 60 * 60 * 1000)
@@ -18,6 +26,21 @@
 #define DATA_LOG_WEBHOOK      "data_log"  // name of the webhook to Logger data log
 #define DATA_LOG_MAX_CHAR     621  // spark.publish is limited to 622 bytes of device OS 0.8.0 (previously just 255)
 
+/*** state saving ***/
+#ifndef READERS_LOG_PERIOD
+#define READERS_LOG_PERIOD    3600000 // how often (in ms) the read statistics of the data readers are added to the state log (0 = only with the readers command)
+#endif
+#ifndef STATE_SAVE_DELAY
+#define STATE_SAVE_DELAY      3000 // quiet time (in ms) after the last state change before pending changes are saved
+#endif
+
+/*** lcd pages ***/
+#define PAGE_REFRESH          1000 // how often (in ms) the controller's system page is refreshed while visible
+#define PAGE_BUTTON_DEBOUNCE  50 // how long (in ms) the page button has to be stable to count as pressed
+
+/*** log transports ***/
+#define TRANSPORTS_MAX        4 // particle cloud + up to 3 local collectors
+
 /*** commands ***/
 // return codes:
 //  -  0 : success without warning
@@ -41,8 +64,11 @@
 #define CMD_RET_ERR_LOG_SMALLER_READ_TEXT   "log period must be larger than read period"
 #define CMD_RET_ERR_READ_LARGER_MIN         -12 // read period cannot be smaller than its minimum
 #define CMD_RET_ERR_READ_LARGER_MIN_TEXT    "read period must be larger than minimum"
+#define CMD_RET_ERR_QUEUE_FULL              -13 // command queue is full
+#define CMD_RET_ERR_QUEUE_FULL_TEXT         "too many commands waiting, try again"
 #define CMD_RET_WARN_NO_CHANGE              1 // state unchaged because it was already the same
 #define CMD_RET_WARN_NO_CHANGE_TEXT         "state already as requested"
+#define CMD_RET_QUEUED                      2 // command accepted, runs in the next update (outcome reported in the state log)
 
 // command log types
 #define CMD_LOG_TYPE_UNDEFINED              "undefined"
@@ -54,6 +80,7 @@
 #define CMD_LOG_TYPE_STATE_UNCHANGED        "state unchanged"
 #define CMD_LOG_TYPE_STATE_UNCHANGED_SHORT  "SAME"
 #define CMD_LOG_TYPE_STARTUP                "startup"
+#define CMD_LOG_TYPE_READERS                "readers"
 
 
 // locking
@@ -84,11 +111,12 @@
   #define CMD_DATA_LOG_PERIOD_HR       CMD_TIME_HR  // device log-period 1h : every hour
 
 // reading rate
-#define CMD_DATA_READ_PERIOD          "read-period" // device read-period number unit [notes] : timing between each data read, may not be smaller than device defined minimum and may not be smaller than log period (if a time)
+#define CMD_DATA_READ_PERIOD          "read-period" // device read-period [component] number unit [notes] : timing between each data read, may not be smaller than device defined minimum and may not be smaller than log period (if a time), with a component id only for that data reader (otherwise the default for all readers)
   #define CMD_DATA_READ_PERIOD_MS     CMD_TIME_MS   // device read-period 200ms : read every 200 milli seconds
   #define CMD_DATA_READ_PERIOD_SEC    CMD_TIME_SEC  // device read-period 5s : read every 5 seconds
   #define CMD_DATA_READ_PERIOD_MIN    CMD_TIME_MIN  // device read-period 5s : read every 5 seconds
   #define CMD_DATA_READ_PERIOD_MANUAL "manual"      // read only upon manual trigger from the device (may not be available on all devices), typically most useful with 'log-period 1x'
+  #define CMD_DATA_READ_PERIOD_DEFAULT "default"    // device read-period scale default : data reader component uses the controller's read period again
 
 // reset
 #define CMD_RESET      "reset" 
@@ -98,6 +126,41 @@
 // restart
 #define CMD_RESTART    "restart" // device "restart" : restarts the device
 
+// memory
+#define CMD_MEM        "mem" // device "mem" : reports memory use (free memory, largest free block, heap allocations, high-water marks of the log stacks and the stack)
+
+// help
+#define CMD_HELP       "help" // device "help" : lists the available commands
+
+// lcd pages
+#define CMD_PAGE       "page" // device "page [number]" : switches to the next (or the numbered) page on the LCD screen
+
+// raw data stream
+#define CMD_STREAM     "stream" // device "stream on/off" : streams every saved data value as binary records over USB serial (see LoggerStream.h)
+  #define CMD_STREAM_ON    "on"
+  #define CMD_STREAM_OFF   "off"
+
+// data reader statistics
+#define CMD_READERS    "readers" // device "readers" : reports the cumulative read statistics of the data readers (reads, completes, timeouts, errors, latency)
+
+/*** command queue ***/
+#ifndef CMD_QUEUE_SIZE
+#define CMD_QUEUE_SIZE     4 // how many cloud commands can wait for execution
+#endif
+#define CMD_QUEUE_BUDGET   20 // time budget (in ms) for running queued commands in each update (at least one command always runs)
+
+/*** command batches ***/
+#define CMD_BATCH_SEP      ';' // device "speed 5 rpm; direction cw; start" : runs several commands in one call
+#ifndef CMD_BATCH_SNAPSHOT_SIZE
+#define CMD_BATCH_SNAPSHOT_SIZE 256 // bytes for the controller and component states taken before a batch (rolled back if a command fails)
+#endif
+
+/*** command registry ***/
+#ifndef CMD_VERBS_MAX
+#define CMD_VERBS_MAX      32 // maximum number of registered commands (controller + components)
+#endif
+#define CMD_REGISTRY_SLOTS 64 // hash table slots (power of 2, at least twice CMD_VERBS_MAX)
+
 /*** reset codes ***/
 #define RESET_UNDEF    1
 #define RESET_RESTART  2
@@ -134,6 +197,15 @@ struct LoggerControllerState {
 
 };
 
+// controller part of the retained snapshot (start of the payload, see LoggerRetained.h)
+struct LoggerControllerSnapshot {
+  uint64_t local_ms; // millis64() when the snapshot was taken
+  uint64_t epoch_ms; // UTC epoch time (in ms) of local_ms (0 if the clock was not synced)
+  uint32_t since_data_log; // time since the last data log (in ms)
+  uint16_t state_logs; // state logs waiting to be published
+  uint16_t data_logs; // data logs waiting to be published
+};
+
 /*** state variable formatting ***/
 
 // locked text
@@ -212,10 +284,10 @@ static void getStateDataLoggingPeriodText(int logging_period, uint8_t logging_ty
 }
 
 // logging_period (any pattern)
-static void getStateDataReadingPeriodText(int reading_period, char* target, int size, char* pattern, bool include_key = true) {
+static void getStateDataReadingPeriodText(const char* key, int reading_period, char* target, int size, char* pattern, bool include_key = true) {
   if (reading_period == 0) {
     // manual mode
-    getStateStringText(CMD_DATA_READ_PERIOD, CMD_DATA_READ_PERIOD_MANUAL, target, size, pattern, include_key);
+    getStateStringText(key, CMD_DATA_READ_PERIOD_MANUAL, target, size, pattern, include_key);
   } else {
     // specific reading period
     char units[] = "ms";
@@ -228,23 +300,27 @@ static void getStateDataReadingPeriodText(int reading_period, char* target, int
       strcpy(units, "s");
       reading_period = reading_period/1000;
     }
-    getStateIntText(CMD_DATA_READ_PERIOD, reading_period, units, target, size, pattern, include_key);
+    getStateIntText(key, reading_period, units, target, size, pattern, include_key);
   }
 }
 
 // read period (standard patterns)
-static void getStateDataReadingPeriodText(int reading_period, char* target, int size, bool value_only = false) {
+static void getStateDataReadingPeriodText(const char* key, int reading_period, char* target, int size, bool value_only = false) {
   if (value_only) {
     (reading_period == 0) ?
-      getStateDataReadingPeriodText(reading_period, target, size, PATTERN_V_SIMPLE, false) : // manual
-      getStateDataReadingPeriodText(reading_period, target, size, PATTERN_VU_SIMPLE, false); // number
+      getStateDataReadingPeriodText(key, reading_period, target, size, PATTERN_V_SIMPLE, false) : // manual
+      getStateDataReadingPeriodText(key, reading_period, target, size, PATTERN_VU_SIMPLE, false); // number
   } else {
     (reading_period == 0) ?
-      getStateDataReadingPeriodText(reading_period, target, size, PATTERN_KV_JSON_QUOTED, true) : // manual
-      getStateDataReadingPeriodText(reading_period, target, size, PATTERN_KVU_JSON, true); // number
+      getStateDataReadingPeriodText(key, reading_period, target, size, PATTERN_KV_JSON_QUOTED, true) : // manual
+      getStateDataReadingPeriodText(key, reading_period, target, size, PATTERN_KVU_JSON, true); // number
   }
 }
 
+static void getStateDataReadingPeriodText(int reading_period, char* target, int size, bool value_only = false) {
+  getStateDataReadingPeriodText(CMD_DATA_READ_PERIOD, reading_period, target, size, value_only);
+}
+
 /*** watchdog ***/
 
 static void watchdogHandler() {
@@ -253,8 +329,9 @@ static void watchdogHandler() {
 
 /*** class definition ***/
 
-// forward declaration for component
+// forward declaration for components
 class LoggerComponent;
+class DataReaderLoggerComponent;
 
 // controller class
 class LoggerController {
@@ -267,6 +344,7 @@ class LoggerController {
     uint32_t trigger_reset = RESET_UNDEF; // what kind of reset to trigger
     uint32_t past_reset = RESET_UNDEF; // what kind of reset was triggered
     ApplicationWatchdog *wd;
+    alignas(ApplicationWatchdog) uint8_t wd_storage[sizeof(ApplicationWatchdog)]; // constructed in init
 
     // reset
     const int reset_pin;
@@ -290,20 +368,30 @@ class LoggerController {
     byte mac_address[6];
 
     // state info
-    const size_t eeprom_start = 0;
-    size_t eeprom_location = 0;
-
-    // startup
-    bool startup_complete = false;
+    const char* state_id = "controller"; // state store key id of the controller state
+    uint16_t state_key = LoggerStateStore::getKey(state_id);
+    size_t state_store_needed = 0; // bytes needed in the state store for the controller and all components
+    size_t legacy_state_address = 0; // next state address in the old memory layout (controller state first, then the components in order)
 
     // data indices
     uint8_t data_idx = 0;
 
+    // lcd pages
+    uint8_t main_page = LCD_NO_PAGE; // name, state and data information (components and state/data update callbacks)
+    uint8_t system_page = LCD_NO_PAGE; // memory and log stack information
+    unsigned long last_page_refresh = 0;
+    int page_button_pin = -1; // optional button that switches pages (HIGH = pressed)
+    bool page_button_pressed = false;
+    unsigned long page_button_change = 0;
+
   protected:
 
     // lcd buffer (for cross-method msg assembly that might not be safe to do with lcd->buffer)
     char lcd_buffer[21];
 
+    // startup (logs are only queued once startup is complete)
+    bool startup_complete = false;
+
     // call backs
     void (*name_callback)() = 0;
     void (*command_callback)() = 0;
@@ -311,7 +399,7 @@ class LoggerController {
     void (*data_update_callback)() = 0;
 
     // buffer for date time
-    char date_time_buffer[25];
+    char date_time_buffer[27]; // CLOCK_DATE_TIME_FORMAT
 
     // buffer and information variables
     char state_variable[STATE_INFO_MAX_CHAR];
@@ -324,21 +412,70 @@ class LoggerController {
     char data_log[DATA_LOG_MAX_CHAR];
     char data_log_buffer[DATA_LOG_MAX_CHAR-10];
 
+    // data log packing (data of all components share data logs until they are full)
+    bool packing_data_logs = false; // whether the controller's data log pass is running (logs are completed at the end of the pass)
+    uint64_t data_log_time = 0; // data time of the data log (UTC epoch ms of its first data, data with other times carry their own)
+    LoggerTransport* sample_transport = NULL; // transport the latest samples are logged for (see logSamples, NULL = averaged data logs)
+
     // data logging tracker
     unsigned long last_data_log = 0;
 
-    // log stacks
-    std::vector<std::string> state_log_stack;
-    std::vector<std::string> data_log_stack;
-
-    // log stack processing
-    unsigned long last_log_published = 0;
-    const int publish_interval = 1000; // 1/s is the max frequency for particle cloud publishing
-
-    // memory reserve
-    uint memory_reserve = 5000; // memory reserve in bytes
-    bool out_of_memory = false; // whether out of memory
-    uint missed_data = 0; // how many data points missed b/c no internet and out of memory
+    // retained snapshot of the in-progress statistics (kept across warm resets, see LoggerRetained.h)
+    uint32_t retained_layout = RETAINED_LAYOUT_SEED;
+    size_t retained_size = 0; // payload size (0 = nothing is retained)
+    uint16_t retained_state_logs = 0; // log queue counts in the latest snapshot
+    uint16_t retained_data_logs = 0;
+    uint lost_logs = 0; // logs that were waiting to be published when the device reset (from the snapshot)
+
+    // data reader statistics tracker
+    unsigned long last_readers_log = 0;
+
+    // pending state changes (saved once there were no changes for STATE_SAVE_DELAY)
+    bool state_dirty = false;
+    bool components_state_dirty = false;
+    unsigned long last_state_change = 0;
+
+    // cloud commands waiting for execution
+    LoggerCommandQueue<CMD_QUEUE_SIZE, CMD_MAX_CHAR> command_queue;
+    bool queued_locked = false; // lock state once the queued commands have run (only meaningful while the queue is not empty)
+
+    // command batch outcome (combined from all commands in the batch)
+    char batch_data[STATE_LOG_MAX_CHAR / 2];
+    char batch_msg[100];
+    char batch_notes[CMD_MAX_CHAR];
+    bool addToBatchText(char* target, size_t size, const char* text, const char* sep);
+
+    // command batch rollback (states before the batch, restored if one of its commands fails)
+    uint8_t batch_snapshot[CMD_BATCH_SNAPSHOT_SIZE];
+    bool running_batch = false;
+    bool batch_reset_data = false; // "reset data" in a batch waits until all commands succeeded (cleared data cannot be rolled back)
+    bool snapshotBatchState(); // @return false if the states do not fit into the snapshot
+    bool rollbackBatchState(); // @return whether any state had changed
+    void resetData();
+
+    // command registry (verbs in registration order + hash table of verb index + 1, 0 = empty slot)
+    LoggerCommandVerb command_verbs[CMD_VERBS_MAX];
+    uint8_t command_verbs_n = 0;
+    uint8_t command_slots[CMD_REGISTRY_SLOTS] = {};
+    bool addCommandVerb(const char* verb, const char* help, LoggerComponent* component, bool (LoggerController::*parse)());
+
+    // log transports (the particle cloud is always the first, its log stacks are the ones reported in the state)
+    LoggerParticleTransport particle_transport;
+    LoggerTransport* transports[TRANSPORTS_MAX];
+    uint8_t transports_n = 0;
+
+    // log stack capacity
+    bool out_of_memory = false; // whether the particle data log stack is full
+    uint missed_data = 0; // how many data points missed b/c no internet and full data log stack
+
+    // heap check (no heap allocations after setup)
+    bool heap_check_started = false;
+    unsigned long heap_allocations = 0; // allocations at the last check
+
+    // defaults (if not provided in the constructor)
+    static LoggerDisplay no_lcd;
+    LoggerControllerState default_state;
+    LoggerCommand default_command;
 
   public:
 
@@ -355,15 +492,20 @@ class LoggerController {
     char name[20] = "";
     LoggerDisplay* lcd;
     LoggerControllerState* state;
-    LoggerCommand* command = new LoggerCommand();
+    LoggerCommand* command = &default_command;
     std::vector<LoggerComponent*> components;
+    std::vector<DataReaderLoggerComponent*> readers; // the components that are data readers (in the order they were added)
+    LoggerStateStore state_store;
 
     /*** constructors ***/
-    LoggerController (const char *version, int reset_pin) : LoggerController(version, reset_pin, new LoggerDisplay()) {}
-    LoggerController (const char *version, int reset_pin, LoggerDisplay* lcd) : LoggerController(version, reset_pin, lcd, new LoggerControllerState()) {}
-    LoggerController (const char *version, int reset_pin, LoggerControllerState *state) : LoggerController(version, reset_pin, new LoggerDisplay(), state) {}
-    LoggerController (const char *version, int reset_pin, LoggerDisplay* lcd, LoggerControllerState *state) : version(version), reset_pin(reset_pin), lcd(lcd), state(state) {
-      eeprom_location = eeprom_start + sizeof(*state);
+    LoggerController (const char *version, int reset_pin) : LoggerController(version, reset_pin, &no_lcd) {}
+    LoggerController (const char *version, int reset_pin, LoggerDisplay* lcd) : LoggerController(version, reset_pin, lcd, &default_state) {}
+    LoggerController (const char *version, int reset_pin, LoggerControllerState *state) : LoggerController(version, reset_pin, &no_lcd, state) {}
+    LoggerController (const char *version, int reset_pin, LoggerDisplay* lcd, LoggerControllerState *state) : reset_pin(reset_pin), particle_transport(STATE_LOG_WEBHOOK, DATA_LOG_WEBHOOK), version(version), lcd(lcd), state(state) {
+      transports[transports_n++] = &particle_transport;
+      state_store_needed = sizeof(*state) + STATE_STORE_RECORD_OVERHEAD;
+      legacy_state_address = sizeof(*state);
+      registerCommands();
     }
 
     /*** debugs ***/
@@ -377,11 +519,16 @@ class LoggerController {
     /*** callbacks ***/
     void setNameCallback(void (*cb)()); // callback executed after name retrieved from cloud
     void setCommandCallback(void (*cb)()); // callback executed after a command is received and processed
-    void setStateUpdateCallback(void (*cb)()); // callback executed when state variable is updated
-    void setDataUpdateCallback(void (*cb)()); // callback executed when data variable is updated
+    void setStateUpdateCallback(void (*cb)()); // callback executed when the main LCD page is rendered (after state or data variable updates, only while the page is visible)
+    void setDataUpdateCallback(void (*cb)()); // callback executed when the main LCD page is rendered (after state or data variable updates, only while the page is visible)
+
+    /*** lcd pages ***/
+    void setPageButton(int pin); // button that switches to the next LCD page when pressed
+    uint8_t getMainPage();
 
     /*** setup ***/
     void addComponent(LoggerComponent* component);
+    bool addTransport(LoggerTransport* transport); // send the state and data logs to a local collector as well (see LoggerTransport.h)
     void init(); 
     virtual void initComponents();
     virtual void completeStartup();
@@ -399,9 +546,32 @@ class LoggerController {
     virtual void saveState();
     virtual bool restoreState();
     virtual void resetState();
+    void markStateDirty(); // save the controller state after a quiet period (use saveState() for changes that must be saved right away)
+    void markComponentsStateDirty(); // a component has pending state changes (see LoggerComponent::markStateDirty)
+    void commitState(); // save all pending state changes now
+    // override to carry settings over from an older controller state version (copy into the state and return true)
+    virtual bool migrateState(uint8_t from_version, const uint8_t* data, size_t size);
+    // copies a state saved by older firmware (EEPROM.put at address) into target if the store was just created and the version matches
+    // @param version the target's version field
+    bool importLegacyState(void* target, size_t size, const uint8_t* version, size_t address);
+
+    /*** retained snapshot ***/
+    void setupRetained(); // layout key and payload size (once all components are added)
+    void restoreRetained(); // continue the statistics from before a warm reset
+    void retainSnapshot(); // take a new snapshot
+
+    /*** command registry ***/
+    void registerCommands(); // registers the controller commands
+    bool registerCommand(const char* verb, const char* help, LoggerComponent* component); // registers a component command
+    LoggerCommandVerb* findCommand(uint32_t hash, const char* verb); // NULL if not registered
 
     /*** command parsing ***/
-    int receiveCommand (String command); // receive cloud command
+    int receiveCommand (String command); // receive cloud command (checked and queued for execution in update)
+    int checkCommand (const char* command); // registry and lock check of each command (CMD_RET_SUCCESS, CMD_RET_ERR_CMD or CMD_RET_ERR_LOCKED)
+    int checkCommand (const char* command, bool* locked); // same starting from the given lock state (updated to the lock state after the command)
+    void processCommandQueue(); // run queued commands (within CMD_QUEUE_BUDGET)
+    int executeCommand (const char* command); // run a command right away
+    int executeCommandBatch (const char* command); // run CMD_BATCH_SEP separated commands right away
     virtual void parseCommand (); // parse a cloud command
     virtual void parseComponentsCommand(); // parse a cloud command in the components
     bool parseLocked();
@@ -409,8 +579,14 @@ class LoggerController {
     bool parseDataLogging();
     bool parseDataLoggingPeriod();
     bool parseDataReadingPeriod();
+    bool parseDataReadingPeriodValue(int* read_period); // manual/number + units, @return whether it is a valid read period
     bool parseReset();
     bool parseRestart();
+    bool parseMemory();
+    bool parseHelp();
+    bool parsePage();
+    bool parseStream();
+    bool parseReaders();
 
     /*** state changes ***/
     bool changeLocked(bool on);
@@ -418,6 +594,7 @@ class LoggerController {
     bool changeDataLogging(bool on);
     bool changeDataLoggingPeriod(int period, int type);
     bool changeDataReadingPeriod(int period);
+    uint getDataReadingPeriodMax(); // longest read period of the controller and its data readers (in ms)
 
     /*** command info to display ***/
     virtual void updateDisplayCommandInformation();
@@ -430,6 +607,13 @@ class LoggerController {
     virtual void showDisplayStateInformation();
     virtual void updateDisplayComponentsStateInformation();
 
+    /*** lcd pages ***/
+    static void renderMainPageCallback(LoggerDisplay* lcd, void* ctrl);
+    static void renderSystemPageCallback(LoggerDisplay* lcd, void* ctrl);
+    virtual void renderMainPage();
+    virtual void renderSystemPage();
+    void updatePageButton();
+
     /*** logger state variable ***/
     virtual void updateStateVariable();
     virtual void assembleStateVariable();
@@ -440,9 +624,11 @@ class LoggerController {
     /*** particle webhook state log ***/
     virtual void assembleStartupLog(); 
     virtual void assembleMissedDataLog();
+    virtual void assembleReadersLog(); // read statistics of the data readers (as many as fit)
     virtual void assembleStateLog(); 
+    virtual void assembleStateLog(const char* type, const char* data, const char* msg, const char* notes);
     virtual void queueStateLog(); 
-    virtual void publishStateLog();
+    virtual void publishStateLog(LoggerTransport* transport);
 
     /*** logger data variable ***/
     virtual void updateDataVariable();
@@ -451,13 +637,17 @@ class LoggerController {
     virtual void postDataVariable();
 
     /*** particle webhook data log ***/
+    virtual void updateDataLogs(); // latest samples and averaged data logs once their periods are up
     virtual bool isTimeForDataLogAndClear(); // whether it's time for data clear and log (if logging is on)
     virtual void clearData(bool clear_persistent = false); // clear data fields
-    virtual void logData(); 
+    virtual void logData(); // packs the data of all components into as few data logs as possible
+    virtual void logSamples(LoggerTransport* transport); // packs the samples since the transport's last data log into data logs for that transport
     virtual void resetDataLog();
+    virtual bool addToDataLog(LoggerData* data); // adds data to the data log (queues the log and starts a new one if it is full)
+    virtual void completeDataLog(); // queues the data log if there is data in it (deferred to the end of the controller's data log pass)
     virtual bool addToDataLogBuffer(char* info);
-    virtual bool finalizeDataLog(bool use_common_time, unsigned long common_time = 0);
+    virtual bool finalizeDataLog(bool use_common_time, uint64_t common_time = 0); // common_time: UTC epoch time (in ms) of all data in the log
     virtual void queueDataLog();
-    virtual void publishDataLog();
+    virtual void publishDataLog(LoggerTransport* transport);
 
 };
@@ -1,6 +1,36 @@
 #include "application.h"
 #include "LoggerData.h"
 #include "LoggerUtils.h"
+#include "LoggerClock.h"
+#include "LoggerStream.h"
+#include "LoggerRetained.h"
+
+/** SHARED BUFFERS **/
+
+char LoggerData::json[LOGGER_DATA_JSON_SIZE];
+
+// interned units (offset 0 = no units, offset 1 = units that did not fit)
+static char units_table[LOGGER_DATA_UNITS_TABLE_SIZE] = "\0?";
+static size_t units_table_size = 3;
+
+// @return offset of the text in the units table (added if not there yet)
+static uint8_t internUnits(const char* u) {
+  if (u[0] == 0) return(0);
+  // already in the table?
+  for (size_t i = 0; i < units_table_size; i += strlen(units_table + i) + 1) {
+    if (strcmp(units_table + i, u) == 0) return(i);
+  }
+  // add to the table
+  size_t size = strlen(u) + 1;
+  if (units_table_size + size > sizeof(units_table)) {
+    Serial.printlnf("ERROR: units table is full, cannot add units '%s' (increase LOGGER_DATA_UNITS_TABLE_SIZE)", u);
+    return(1);
+  }
+  uint8_t offset = units_table_size;
+  memcpy(units_table + offset, u, size);
+  units_table_size += size;
+  return(offset);
+}
 
 /** DEBUG **/
 
@@ -13,8 +43,10 @@ void LoggerData::debug() {
 void LoggerData::clear(bool clear_persistent) {
   if (!persistent || clear_persistent) {
     setNewestValueInvalid();
-    value.clear();
-    data_time.clear();
+    n = 0;
+    (scaled_stats) ? scaled_value.clear() : value.clear();
+    data_time_sum = 0;
+    markRetainedDirty();
   }
 }
 
@@ -25,24 +57,51 @@ void LoggerData::makePersistent() {
 /** DATA **/
 
 int LoggerData::getN() {
-  return value.n;
+  return n;
 }
 
 double LoggerData::getValue() {
-  return value.mean;
+  return (scaled_stats) ? scaled_value.getMean(n, stats_decimals) : value.getMean(n);
 }
 
 double LoggerData::getStdDev() {
-  return value.getStdDev();
+  return sqrt(getVariance());
+}
+
+double LoggerData::getVariance() {
+  return (scaled_stats) ? scaled_value.getVariance(n, stats_decimals) : value.getVariance(n);
+}
+
+void LoggerData::setValueStats(int n_values, double mean, double variance) {
+  // keep the mean data time
+  data_time_sum = (n > 0) ? divide_rounded(data_time_sum, n) * n_values : 0;
+  n = n_values;
+  (scaled_stats) ? 
+    scaled_value.set(n, mean, variance, stats_decimals) :
+    value.set(n, mean, variance);
+  markRetainedDirty();
+}
+
+void LoggerData::setScaledStats(int d) {
+  scaled_stats = true;
+  stats_decimals = (d > 9) ? 9 : ((d < 0) ? 0 : d);
+  n = 0;
+  scaled_value.clear();
+  data_time_sum = 0;
 }
 
-unsigned long LoggerData::getDataTime() {
-  return (unsigned long) round(data_time.mean);
+uint64_t LoggerData::getDataTime() {
+  return (n > 0) ? getNewestDataTime() + divide_rounded(data_time_sum, n) : 0;
 }
 
-void LoggerData::setVariable(char* var) {
-  strncpy(variable, var, sizeof(variable) - 1);
-  variable[sizeof(variable)-1] = 0;
+uint64_t LoggerData::getNewestDataTime() {
+  // newest data time is in the past (less than 2^32 ms)
+  uint64_t now = millis64();
+  return(now - (uint32_t) ((uint32_t) now - newest_data_time));
+}
+
+void LoggerData::setVariable(const char* var) {
+  variable = var;
 }
 
 void LoggerData::setIndex(int i) {
@@ -68,7 +127,7 @@ bool LoggerData::setNewestValue(char* val, bool strict, bool infer_decimals, int
   }
   // check for remainder to be only white spaces if strict
   if (strict) {
-    char c;
+    unsigned char c; // unsigned for isspace (arbitrary bytes are undefined behavior otherwise)
     for (int i = 0; i < remaining; i++) {
       c = val[converted+i];
       if (!isspace(c)) {
@@ -92,24 +151,31 @@ void LoggerData::setNewestValueInvalid() {
   newest_value_valid = false;
 }
 
-void LoggerData::setNewestDataTime(unsigned long dt) {
-  newest_data_time = dt;
+void LoggerData::setNewestDataTime(uint64_t dt) {
+  // data times are summed relative to the newest data time
+  if (n > 0) data_time_sum += (int64_t) (getNewestDataTime() - dt) * n;
+  newest_data_time = (uint32_t) dt;
 }
 
 void LoggerData::saveNewestValue(bool average) {
   if (newest_value_valid) {
 
-    // clear/overwrite values if not averaging or data time has overflowed (for safety)
-    if (!average || newest_data_time < getDataTime()) {
-      if (newest_data_time < getDataTime())
-        Serial.println("WARNING: data time has overflowed --> restarting value to avoid incorrect data");
-      value.clear();
-      data_time.clear();
+    // clear/overwrite values if not averaging
+    if (!average) {
+      n = 0;
+      (scaled_stats) ? scaled_value.clear() : value.clear();
+      data_time_sum = 0;
     }
 
-    // add new values
-    value.add(newest_value);
-    data_time.add(newest_data_time);
+    // add new values (the data time is the newest data time, i.e. adds 0 to the data time sum)
+    n++;
+    (scaled_stats) ?
+      scaled_value.add(newest_value, n, stats_decimals) :
+      value.add(newest_value, n);
+    markRetainedDirty();
+
+    // raw value stream (if on)
+    streamValue(idx, getNewestDataTime(), newest_value);
 
     // debug
     //Serial.printf("value add: %3.10f, datatime add: %lu\nvalue    : %3.10f, datatime    : %lu, stdev  : %.10f\n",
@@ -120,9 +186,9 @@ void LoggerData::saveNewestValue(bool average) {
         Serial.print("DEBUG: new average value saved for ") :
         Serial.print("DEBUG: single value saved for ");
       (getN() > 1) ?
-        getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), json, sizeof(json), PATTERN_IKVSUN_SIMPLE, decimals) :
-        getDataDoubleText(idx, variable, getValue(), units, json, sizeof(json), PATTERN_IKVU_SIMPLE, decimals);
-      Serial.printf("%s (data time = %Lu ms)\n", json, getDataTime());
+        getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), getUnits(), getN(), json, sizeof(json), PATTERN_IKVSUN_SIMPLE, decimals) :
+        getDataDoubleText(idx, variable, getValue(), getUnits(), json, sizeof(json), PATTERN_IKVU_SIMPLE, decimals);
+      Serial.printf("%s (data time = %lu ms)\n", json, (unsigned long) getDataTime());
     }
     
   } else {
@@ -130,9 +196,12 @@ void LoggerData::saveNewestValue(bool average) {
   }
 }
 
-void LoggerData::setUnits(char* u) {
-  strncpy(units, u, sizeof(units) - 1);
-  units[sizeof(units)-1] = 0;
+void LoggerData::setUnits(const char* u) {
+  units_offset = internUnits(u);
+}
+
+const char* LoggerData::getUnits() {
+  return(units_table + units_offset);
 }
 
 void LoggerData::setDecimals(int d) {
@@ -145,7 +214,7 @@ int LoggerData::getDecimals() {
 
 /**** OPERATIONS ****/
 
-bool LoggerData::isVariableIdentical(char* comparison) {
+bool LoggerData::isVariableIdentical(const char* comparison) {
   if (strcmp(variable, comparison) == 0) {
     return(true);
   } else {
@@ -153,39 +222,65 @@ bool LoggerData::isVariableIdentical(char* comparison) {
   }
 }
 
-bool LoggerData::isUnitsIdentical(char* comparison) {
-  if (strcmp(units, comparison) == 0) {
+bool LoggerData::isUnitsIdentical(const char* comparison) {
+  if (strcmp(getUnits(), comparison) == 0) {
     return(true);
   } else {
     return(false);
   }
 }
 
+/***** RETAINED *****/
+
+void LoggerData::retain(uint8_t* target) {
+  memcpy(target, &n, sizeof(n)); target += sizeof(n);
+  memcpy(target, &scaled_value, LOGGER_DATA_STATS_SIZE); target += LOGGER_DATA_STATS_SIZE; // either value or scaled_value (union)
+  memcpy(target, &newest_data_time, sizeof(newest_data_time)); target += sizeof(newest_data_time);
+  memcpy(target, &data_time_sum, sizeof(data_time_sum));
+}
+
+void LoggerData::restoreRetained(const uint8_t* source, int64_t time_shift) {
+  memcpy(&n, source, sizeof(n)); source += sizeof(n);
+  memcpy(&scaled_value, source, LOGGER_DATA_STATS_SIZE); source += LOGGER_DATA_STATS_SIZE;
+  memcpy(&newest_data_time, source, sizeof(newest_data_time)); source += sizeof(newest_data_time);
+  memcpy(&data_time_sum, source, sizeof(data_time_sum));
+  // the data times are relative to the newest data time, only that one moves to the current time line
+  newest_data_time += (uint32_t) time_shift;
+}
+
 /***** LOGGING *****/
 
-bool LoggerData::assembleLog(bool include_time_offset) {
+bool LoggerData::assembleLog(bool include_time) {
   if (getN() > 1) {
     // have data
-    (include_time_offset) ?
-      getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), millis() - getDataTime(), json, sizeof(json), PATTERN_IKVSUNT_JSON, decimals) :
-      getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), units, getN(), json, sizeof(json), PATTERN_IKVSUN_JSON, decimals);
+    (include_time) ?
+      getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), getUnits(), getN(), getEpochMillis(getDataTime()), json, sizeof(json), PATTERN_IKVSUNT_JSON, decimals) :
+      getDataDoubleWithSigmaText(idx, variable, getValue(), getStdDev(), getUnits(), getN(), json, sizeof(json), PATTERN_IKVSUN_JSON, decimals);
     return(true);
   } else if (getN() == 1) {
     // have single data point (sigma is not meaningful)
-    (include_time_offset) ?
-      getDataDoubleText(idx, variable, getValue(), units, getN(), millis() - getDataTime(), json, sizeof(json), PATTERN_IKVUNT_JSON, decimals) :
-      getDataDoubleText(idx, variable, getValue(), units, getN(), json, sizeof(json), PATTERN_IKVUN_JSON, decimals);
+    (include_time) ?
+      getDataDoubleText(idx, variable, getValue(), getUnits(), getN(), getEpochMillis(getDataTime()), json, sizeof(json), PATTERN_IKVUNT_JSON, decimals) :
+      getDataDoubleText(idx, variable, getValue(), getUnits(), getN(), json, sizeof(json), PATTERN_IKVUN_JSON, decimals);
     return(true);
   } else {
     return (false);// don't include if there is no data
   }
 }
 
+bool LoggerData::assembleSampleLog(bool include_time) {
+  if (!newest_value_valid) return(false); // no sample
+  (include_time) ?
+    getDataDoubleText(idx, variable, newest_value, getUnits(), 1, getEpochMillis(getNewestDataTime()), json, sizeof(json), PATTERN_IKVUNT_JSON, decimals) :
+    getDataDoubleText(idx, variable, newest_value, getUnits(), 1, json, sizeof(json), PATTERN_IKVUN_JSON, decimals);
+  return(true);
+}
+
 void LoggerData::assembleInfo() {
   if (newest_value_valid) {
     // valid data
-    (strlen(units) > 0) ?
-      getDataDoubleText(idx, variable, newest_value, units, json, sizeof(json), PATTERN_IKVU_JSON, decimals) :
+    (units_offset > 0) ?
+      getDataDoubleText(idx, variable, newest_value, getUnits(), json, sizeof(json), PATTERN_IKVU_JSON, decimals) :
       getDataDoubleText(idx, variable, newest_value, json, sizeof(json), PATTERN_IKV_JSON, decimals);
   } else {
     // no valid data
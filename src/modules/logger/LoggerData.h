@@ -1,51 +1,84 @@
 #pragma once
 #include "LoggerMath.h"
 
-// Logger data for spark cloud
-struct LoggerData {
+// size of the shared data text buffer
+#define LOGGER_DATA_JSON_SIZE 100
 
-  // debug
-  bool debug_data = false;
+// size of the interned units string table
+#ifndef LOGGER_DATA_UNITS_TABLE_SIZE
+#define LOGGER_DATA_UNITS_TABLE_SIZE 128
+#endif
+#if LOGGER_DATA_UNITS_TABLE_SIZE > 256
+#error "LOGGER_DATA_UNITS_TABLE_SIZE can be at most 256 (units are stored as 8 bit offsets into the table)"
+#endif
 
-  // data information
-  char variable[25]; // the name of the data variable
-  int idx; // the index of the data
-  char units[20]; // the units the data is recorded in
+// size of the retained accumulators (count + value statistics + data time statistics, see LoggerRetained.h)
+#define LOGGER_DATA_STATS_SIZE    (sizeof(WelfordSums<double>) > sizeof(ScaledSums) ? sizeof(WelfordSums<double>) : sizeof(ScaledSums))
+#define LOGGER_DATA_RETAINED_SIZE (sizeof(uint32_t) + LOGGER_DATA_STATS_SIZE + sizeof(uint32_t) + sizeof(int64_t))
 
-  // newest data
-  unsigned long newest_data_time; // the last recorded datetime (in ms)
-  double newest_value; // the last recorded value
-  bool newest_value_valid; // whether the newest value is valid
+// Logger data for spark cloud
+// @note the layout is kept under 64 bytes (56 on the Photon) since every data of every component has one:
+// 8 info and flags (the units are an offset into the shared units table) + 4 count (shared by value and time statistics)
+// + 4 newest data time + 8 newest value + 24 value statistics + 8 data time statistics.
+// The newest data time is kept as the lower 32 bits of its millis64() time (the full time is restored relative to the
+// current time so it must be less than ~49 days old) and the data times are summed relative to it in 64 bit,
+// so the mean data time is exact and does not depend on the uptime
+struct LoggerData {
 
-  // saved data
-  RunningStats value;
-  RunningStats data_time;
+  // data information
+  const char* variable; // the name of the data variable (not copied, must be a string constant)
+  uint8_t units_offset; // the units the data is recorded in (offset into the shared units table, see setUnits/getUnits)
+  uint8_t idx; // the index of the data
+  int8_t decimals; // what should the decimals be? (positive = decimals, negative = integers)
 
+  // flags
+  bool debug_data : 1; // debug
+  bool newest_value_valid : 1; // whether the newest value is valid
   // clearing
   // FIXME: consider deprecating this attribute (formerly auto_clear) and all related functionality
   // UPDATE: see use case in Scale! should remain
   // check if it is needed / useded anywhere?
-  bool persistent;
+  bool persistent : 1;
+  bool scaled_stats : 1; // whether the value statistics are scaled integers (setScaledStats) instead of double precision
+  uint8_t stats_decimals : 4; // decimals of the scaled integers (0 to 9)
 
-  // output parameters
-  int decimals; // what should the decimals be? (idxitive = decimals, negative = integers)
-  char json[100]; // full data log text
+  // number of saved values (value and time statistics)
+  uint32_t n;
 
-  LoggerData() {
+  // newest data
+  uint32_t newest_data_time; // lower 32 bits of the last recorded data time (see getNewestDataTime)
+  double newest_value; // the last recorded value
+
+  // saved data (value statistics depending on scaled_stats)
+  union {
+    WelfordSums<double> value;
+    ScaledSums scaled_value;
+  };
+  int64_t data_time_sum; // sum of the data times relative to the newest data time
+
+  // output
+  static char json[LOGGER_DATA_JSON_SIZE]; // data log text (shared, only valid right after assembleLog/assembleInfo)
+
+  LoggerData() : scaled_value() {
     idx = 0;
-    variable[0] = 0;
-    units[0] = 0;
+    variable = "";
+    units_offset = 0;
     decimals = 0;
+    debug_data = false;
     persistent = false;
+    scaled_stats = false;
+    stats_decimals = 0;
+    newest_data_time = 0;
+    newest_value = 0.0;
     clear(true);
   };
 
   LoggerData(int idx) : LoggerData() { setIndex(idx); }
-  LoggerData(int idx, char* var) : LoggerData(idx) { setVariable(var); }
-  LoggerData(int idx, char* var, char* units) : LoggerData(idx, var) { setUnits(units); }
+  LoggerData(int idx, const char* var) : LoggerData(idx) { setVariable(var); }
+  LoggerData(int idx, const char* var, const char* units) : LoggerData(idx, var) { setUnits(units); }
   LoggerData(int idx, int d) : LoggerData(idx) { setDecimals(d); }
-  LoggerData(int idx, char* var, int d) : LoggerData(idx, var) { setDecimals(d); }
-  LoggerData(int idx, char* var, char* units, int d) : LoggerData(idx, var, units) { setDecimals(d); }
+  LoggerData(int idx, const char* var, int d) : LoggerData(idx, var) { setDecimals(d); }
+  LoggerData(int idx, const char* var, const char* units, int d) : LoggerData(idx, var, units) { setDecimals(d); }
 
   // debug
   void debug();
@@ -58,24 +91,38 @@ struct LoggerData {
   int getN();
   double getValue();
   double getStdDev();
-  unsigned long getDataTime();
-  void setVariable(char* var);
+  double getVariance();
+  void setValueStats(int n, double mean, double variance); // set value statistics directly (for derived values)
+  void setScaledStats(int d); // average values as integers scaled to d decimals (faster than double precision)
+  uint64_t getDataTime(); // mean data time (millis64() time line)
+  uint64_t getNewestDataTime(); // millis64() time of the newest value
+  void setVariable(const char* var);
   void setIndex(int idx);
   void setNewestValue(double val);
   // returns whether the value is a valid number or not (if strict, expects only white spaces after the value)
   bool setNewestValue(char* val, bool strict = true, bool infer_decimals = false, int add_decimals = 1, const char* sep = ".");
   void setNewestValueInvalid();
   void saveNewestValue(bool average); // set value based on current newest_value (calculate average if true)
-  void setNewestDataTime(unsigned long dt);
-  void setUnits(char* u);
+  void setNewestDataTime(uint64_t dt); // millis64() time of the newest value
+  void setUnits(const char* u); // units are stored in a table shared by all data (each distinct units text only once)
+  const char* getUnits();
   void setDecimals(int d);
   int getDecimals();
 
   // operations
-  bool isVariableIdentical(char* comparison);
-  bool isUnitsIdentical(char* comparison);
+  bool isVariableIdentical(const char* comparison);
+  bool isUnitsIdentical(const char* comparison);
+
+  // retained accumulators (kept across warm resets)
+  void retain(uint8_t* target); // copies the accumulators (LOGGER_DATA_RETAINED_SIZE bytes)
+  void restoreRetained(const uint8_t* source, int64_t time_shift); // time shift from the old to the current millis64() time line
 
   // logging
-  bool assembleLog(bool include_time_offset = true); // assemble log (with our without time offset, in seconds)
+  bool assembleLog(bool include_time = true); // assemble log (with or without the data time as UTC epoch in ms)
+  bool assembleSampleLog(bool include_time = true); // assemble log of the newest value (n = 1, with or without its data time)
   void assembleInfo(); // assemble data info
 };
+
+// size on the Photon: the 8 byte pointer on 64 bit hosts (host tests) adds 8 bytes with the alignment of the doubles
+#define LOGGER_DATA_DEVICE_SIZE (sizeof(LoggerData) - (sizeof(const char*) > 4 ? 8 : 0))
+static_assert(LOGGER_DATA_DEVICE_SIZE < 64, "LoggerData must stay under 64 bytes on the Photon");
@@ -1,5 +1,6 @@
 #include "application.h"
 #include "LoggerDisplay.h"
+#include <new>
 
 void LoggerDisplay::debug() {
 	debug_display = true;
@@ -15,8 +16,8 @@ void LoggerDisplay::init()
 
 	if (present)
 	{
-		// create the lcd object and initialize it
-		lcd = new LiquidCrystal_I2C(lcd_addr, cols, lines);
+		// create the lcd object (in place, no heap) and initialize it
+		lcd = new (lcd_storage) LoggerDisplayDriver(lcd_addr, cols, lines);
 		lcd->init();
 		//LiquidCrystal_I2C::init();
 		//backlight();
@@ -27,10 +28,13 @@ void LoggerDisplay::init()
 		{
 			temp_pos[i] = false;
 			text[i] = ' ';
+			shown[i] = ' ';
 			memory[i] = ' ';
 		}
 		text[cols * lines] = 0;
+		shown[cols * lines] = 0;
 		memory[cols * lines] = 0;
+		lcd_pos = 0; // clear returns the cursor home
 		moveToPos(1, 1);
 	}
 }
@@ -70,6 +74,146 @@ void LoggerDisplay::setTempTextShowTime(uint8_t show_time)
 	Serial.printf("INFO: setting LCD temporary text timer to %d seconds (%d ms)\n", show_time, temp_text_show_time);
 }
 
+void LoggerDisplay::setFlushBudget(uint8_t budget)
+{
+	flush_budget = (budget > 0) ? budget : 1;
+	Serial.printf("INFO: setting LCD flush budget to %d characters per update\n", flush_budget);
+}
+
+// sends runs of changed characters, starting where the last flush stopped so all lines get their turn
+bool LoggerDisplay::flush(uint16_t budget)
+{
+	if (!present) return(true);
+
+	uint16_t size = cols * lines;
+	uint16_t pos = flush_start;
+	uint16_t checked = 0;
+	char run[LCD_MAX_SIZE + 1];
+	uint8_t n;
+
+	while (checked < size && budget > 0)
+	{
+		// unchanged
+		if (text[pos] == shown[pos])
+		{
+			pos = (pos + 1) % size;
+			checked++;
+			continue;
+		}
+
+		// move cursor (only if not already there)
+		if (lcd_pos != pos)
+		{
+			lcd->setCursor(pos % cols, pos / cols);
+			lcd_pos = pos;
+			budget--;
+			if (budget == 0) break;
+		}
+
+		// changed characters until the end of the line (lcd addresses are not continuous across lines)
+		n = 0;
+		do
+		{
+			run[n++] = text[pos];
+			shown[pos] = text[pos];
+			pos++;
+			checked++;
+			budget--;
+		} while (budget > 0 && checked < size && pos % cols != 0 && text[pos] != shown[pos]);
+		run[n] = 0;
+		lcd->print(run);
+		lcd_pos = (pos % cols == 0) ? -1 : pos;
+		pos = pos % size;
+
+		if (debug_display) {
+			Serial.printf(" - flushed '%s' to lcd ending at position %d\n", run, (pos == 0) ? size : pos);
+		}
+	}
+
+	flush_start = pos;
+	return(!isDirty());
+}
+
+bool LoggerDisplay::isDirty()
+{
+	if (!present) return(false);
+	return(memcmp(text, shown, cols * lines) != 0);
+}
+
+/*** pages ***/
+
+uint8_t LoggerDisplay::addPage(const char* name, LoggerDisplayPageRender render, void* context)
+{
+	if (pages_n >= LCD_MAX_PAGES)
+	{
+		Serial.printf("ERROR: cannot add LCD page '%s', too many pages (increase LCD_MAX_PAGES)\n", name);
+		return(LCD_NO_PAGE);
+	}
+	pages[pages_n] = {name, render, context, false}; // rendered once marked dirty or switched to
+	if (debug_display) {
+		Serial.printf("DEBUG: added LCD page #%d '%s'\n", pages_n + 1, name);
+	}
+	return(pages_n++);
+}
+
+void LoggerDisplay::markPageDirty(uint8_t p)
+{
+	if (p < pages_n) pages[p].dirty = true;
+}
+
+// clears the page lines and lets the page print its content into the frame buffer
+// (only the characters that actually changed are sent to the lcd by flush)
+void LoggerDisplay::renderPage()
+{
+	if (page >= pages_n || !pages[page].dirty) return;
+	pages[page].dirty = false;
+	if (present) clearScreen(LCD_PAGE_LINE);
+	pages[page].render(this, pages[page].context);
+	if (debug_display) {
+		Serial.printf("DEBUG: rendered LCD page #%d '%s'\n", page + 1, pages[page].name);
+	}
+}
+
+void LoggerDisplay::setPage(uint8_t p)
+{
+	if (p >= pages_n) return;
+	page = p;
+	pages[page].dirty = true;
+	if (debug_display) {
+		Serial.printf("DEBUG: switching to LCD page #%d '%s'\n", page + 1, pages[page].name);
+	}
+}
+
+void LoggerDisplay::nextPage()
+{
+	if (pages_n > 0) setPage((page + 1) % pages_n);
+}
+
+uint8_t LoggerDisplay::getPage()
+{
+	return(page);
+}
+
+uint8_t LoggerDisplay::getPagesN()
+{
+	return(pages_n);
+}
+
+uint8_t LoggerDisplay::getLines()
+{
+	return(lines);
+}
+
+const char* LoggerDisplay::getPageName(uint8_t p)
+{
+	return((p < pages_n) ? pages[p].name : "");
+}
+
+bool LoggerDisplay::isPageVisible(uint8_t p)
+{
+	return(p == page && p < pages_n);
+}
+
 void LoggerDisplay::moveToPos(uint8_t line, uint8_t col)
 {
 	if (checkPresent() && (line_now != line || col_now != col))
@@ -79,7 +223,6 @@ void LoggerDisplay::moveToPos(uint8_t line, uint8_t col)
 		line = (line > lines) ? 1 : line;	  // start at beginning of screen if lines overflow
 		line_now = line;
 		col_now = col;
-		lcd->setCursor(col - 1L, line - 1L);
 	}
 }
 
@@ -120,38 +263,15 @@ void LoggerDisplay::print(const char c[], bool temp)
 		uint8_t col_init = col_now;
 		uint16_t pos_now = getPos();
 
-		// update actual LCD text (but only parts that are necessary, to avoid slow i2c communication)
-		char update[length + 1];
-		int needs_update = -1;
-		for (uint8_t i = 0; i <= length; i++)
+		// update the frame buffer (the lcd itself is updated by flush)
+		for (uint8_t i = 0; i < length; i++)
 		{
-			if (needs_update > -1 && (i == length || text[pos_now + i] == c[i]))
-			{
-				// either at the end OR text buffer the same as new text but prior text has needs_update flag on -> write text
-				strncpy(update, c + needs_update, i - needs_update);
-				update[i - needs_update] = 0; // make sure it's 0-pointer terminated
-
-				if (debug_display) {
-					Serial.printf(
-						" - part '%s' (%d to %d, length %d)  sent to lcd on line %d, col %d\n",
-						update, needs_update + 1, i, length, line_now, col_init + needs_update);
-				}
-
-				// update lcd
-				moveToPos(line_now, col_init + needs_update);
-				lcd->print(update);
-				//LiquidCrystal_I2C::print(update);
-
-				// store new text in text buffer
-				strncpy(text + pos_now + needs_update, update, i - needs_update);
+			// temp text is only overwritten by new temp text
+			if (temp || !temp_pos[pos_now + i]) text[pos_now + i] = c[i];
+		}
 
-				needs_update = -1; // reset
-			}
-			else if (needs_update == -1 && i < length && (temp || !temp_pos[pos_now + i]) && text[pos_now + i] != c[i])
-			{
-				// either a new temp or NOT overwriting a temp position + text buffer not the same as new text (and not at end yet)
-				needs_update = i; // mark beginning of update
-			}
+		if (debug_display) {
+			Serial.printf(" - '%.*s' written to frame buffer on line %d, col %d\n", length, c, line_now, col_init);
 		}
 
 		// update final position
@@ -324,7 +444,7 @@ void LoggerDisplay::clearTempText()
 {
 
 	// revert data
-	char revert[cols];
+	char revert[cols + 1];
 	int needs_revert = -1;
 	uint16_t pos, i;
 
@@ -386,4 +506,6 @@ void LoggerDisplay::update()
 	{
 		clearTempText();
 	}
+	renderPage();
+	flush(flush_budget);
 }
@@ -1,5 +1,14 @@
 #pragma once
+
+// lcd driver: burst I2C driver (default) or the LiquidCrystal_I2C library (uncomment to use the library)
+//#define LCD_LIBRARY_DRIVER
+#ifdef LCD_LIBRARY_DRIVER
 #include <LiquidCrystal_I2C_Spark.h> // requirement: https://github.com/BulldogLowell/LiquidCrystal_I2C_Spark
+typedef LiquidCrystal_I2C LoggerDisplayDriver;
+#else
+#include "LoggerDisplayI2C.h"
+typedef LoggerDisplayI2C LoggerDisplayDriver;
+#endif
 
 // alignments
 #define LCD_ALIGN_LEFT   1
@@ -13,6 +22,29 @@
 // buffers
 #define LCD_MAX_SIZE     80 // maximum number of characters on LCD
 
+// flushing (all prints go to the frame buffer, update() sends the changed characters to the LCD)
+#ifndef LCD_FLUSH_BUDGET
+#define LCD_FLUSH_BUDGET 10 // maximum number of characters sent to the LCD per update (a cursor move counts as one character)
+#endif
+
+// pages (line 1 is shared by all pages, the other lines show the visible page)
+#ifndef LCD_MAX_PAGES
+#define LCD_MAX_PAGES    8 // maximum number of registered pages
+#endif
+#define LCD_NO_PAGE      255 // code for no / unknown page
+#define LCD_PAGE_LINE    2 // first line that belongs to the pages
+
+// page render callback (context is the pointer passed to addPage, e.g. the component that owns the page)
+class LoggerDisplay;
+typedef void (*LoggerDisplayPageRender)(LoggerDisplay* lcd, void* context);
+
+struct LoggerDisplayPage {
+	const char* name;
+	LoggerDisplayPageRender render;
+	void* context;
+	bool dirty; // needs rendering the next time it is visible
+};
+
 // Display class handles displaying information
 class LoggerDisplay
 {
@@ -31,15 +63,17 @@ private:
 	// lcd actually present at one of the i2c addresses?
 	bool present = false;
 
-	// display object
-	LiquidCrystal_I2C* lcd;
+	// display object (constructed in init)
+	LoggerDisplayDriver* lcd;
+	alignas(LoggerDisplayDriver) uint8_t lcd_storage[sizeof(LoggerDisplayDriver)];
 
 	// display layout
 	const uint8_t cols, lines;
 
 	// display data
 	uint8_t col_now, line_now;		 // current print position on the display
-	char text[LCD_MAX_SIZE + 1];     // the current text of the lcd display
+	char text[LCD_MAX_SIZE + 1];     // frame buffer: the current text of the lcd display
+	char shown[LCD_MAX_SIZE + 1];    // the text actually sent to the lcd (differences to text are flushed in update)
 	char memory[LCD_MAX_SIZE + 1];   // the memory text of the lcd display for non temporay messages
 	bool temp_pos[LCD_MAX_SIZE + 1]; // which text is only temporary
 
@@ -48,6 +82,16 @@ private:
 	uint16_t temp_text_show_time = 3000;	// how long current temp text is being shown for (in ms)
 	unsigned long temp_text_show_start = 0; // when the last temp text was started (changes reset the start time for all temp text!)
 
+	// flushing
+	int16_t lcd_pos = -1;			 // position of the lcd cursor (-1 = unknown)
+	uint16_t flush_start = 0;		 // where the next flush starts looking for changes (round robin)
+	uint8_t flush_budget = LCD_FLUSH_BUDGET;
+
+	// pages
+	LoggerDisplayPage pages[LCD_MAX_PAGES];
+	uint8_t pages_n = 0;
+	uint8_t page = 0; // visible page
+
 	// keep track of position / navigation
 	void moveToPos(uint8_t line, uint8_t col);
 	uint16_t getPos();
@@ -87,13 +131,44 @@ public:
 	// set temporary text show time (in seconds)
 	void setTempTextShowTime(uint8_t show_time);
 
+	// set how many characters are sent to the lcd per update (a cursor move counts as one character)
+	void setFlushBudget(uint8_t budget);
+
+	// send changed characters in the frame buffer to the lcd (up to budget characters)
+	// @return whether the lcd is up to date
+	bool flush(uint16_t budget);
+
+	// whether the frame buffer has changes not yet sent to the lcd
+	bool isDirty();
+
+	// register a page (pages are only rendered while visible, see markPageDirty)
+	// @return the page number (LCD_NO_PAGE if the page registry is full)
+	uint8_t addPage(const char* name, LoggerDisplayPageRender render, void* context = NULL);
+
+	// flag a page for re-rendering (cheap for hidden pages, they render once they become visible)
+	void markPageDirty(uint8_t p);
+
+	// render the visible page now if it is flagged (otherwise happens in update)
+	void renderPage();
+
+	// switch pages (the new page is rendered in the next update)
+	void setPage(uint8_t p);
+	void nextPage();
+
+	// page information
+	uint8_t getPage();
+	uint8_t getPagesN();
+	uint8_t getLines(); // lines of the display (pages use lines LCD_PAGE_LINE to getLines())
+	const char* getPageName(uint8_t p);
+	bool isPageVisible(uint8_t p);
+
 	// clears the line (overwrites spaces)
 	void clearLine(uint8_t line, uint8_t start = 1, uint8_t end = LCD_LINE_END);
 
 	// move to a specific line (e.g. before adding individual text with print)
 	void goToLine(uint8_t line);
 
-	// print normal text (temp text that is still visible is only overwritten with new temp text)
+	// print normal text into the frame buffer (temp text that is still visible is only overwritten with new temp text)
 	void print(const char c[], bool temp = false);
 
 	// print a whole line (shortens text if too long, pads with spaces if too short)
@@ -127,6 +202,6 @@ public:
 	// clear whole screen (temp text will stay until timer is up)
 	void clearScreen(uint8_t start_line = 1L);
 
-	// call in loop to keep temporary text up to date
+	// call in loop to keep temporary text up to date, render the visible page if needed and flush changes to the lcd
 	void update();
 };
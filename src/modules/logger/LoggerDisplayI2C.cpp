@@ -0,0 +1,101 @@
+#include "application.h"
+#include "LoggerDisplayI2C.h"
+
+/*** burst assembly ***/
+
+void LoggerDisplayI2C::queueNibble(uint8_t nibble, uint8_t mode) {
+  uint8_t out = (nibble & 0xf0) | mode | backlight_flag;
+  // register select changes need to settle before the enable pulse
+  if (mode != burst_mode) {
+    if (burst_n + 1 > LCD_I2C_BURST_MAX) send();
+    burst[burst_n++] = out;
+    burst_mode = mode;
+  }
+  if (burst_n + 2 > LCD_I2C_BURST_MAX) send();
+  burst[burst_n++] = out | LCD_I2C_EN;
+  burst[burst_n++] = out;
+}
+
+void LoggerDisplayI2C::queueByte(uint8_t value, uint8_t mode) {
+  if (burst_n + 4 > LCD_I2C_BURST_MAX) send();
+  queueNibble(value & 0xf0, mode);
+  queueNibble(value << 4, mode);
+}
+
+void LoggerDisplayI2C::send() {
+  if (burst_n == 0) return;
+  Wire.beginTransmission(addr);
+  Wire.write(burst, burst_n);
+  Wire.endTransmission();
+  transactions++;
+  bytes += burst_n + 1;
+  burst_n = 0;
+}
+
+void LoggerDisplayI2C::updateBacklight() {
+  send();
+  burst[burst_n++] = backlight_flag | ((burst_mode == 0xff) ? 0 : burst_mode);
+  send();
+}
+
+void LoggerDisplayI2C::command(uint8_t value) {
+  queueByte(value, 0);
+}
+
+/*** LiquidCrystal_I2C compatible interface ***/
+
+void LoggerDisplayI2C::init() {
+  // power up: switch to 4 bit mode (HD44780 datasheet, initialization by instruction)
+  delay(50);
+  burst_n = 0;
+  burst_mode = 0xff;
+  queueNibble(0x30, 0); send(); delayMicroseconds(4500);
+  queueNibble(0x30, 0); send(); delayMicroseconds(4500);
+  queueNibble(0x30, 0); send(); delayMicroseconds(150);
+  queueNibble(0x20, 0); send();
+  // configure
+  command((lines > 1) ? LCD_I2C_CMD_4BIT_2 : LCD_I2C_CMD_4BIT_1);
+  command(LCD_I2C_CMD_ON);
+  command(LCD_I2C_CMD_ENTRY);
+  send();
+  clear();
+}
+
+void LoggerDisplayI2C::backlight() {
+  backlight_flag = LCD_I2C_BACKLIGHT;
+  updateBacklight();
+}
+
+void LoggerDisplayI2C::noBacklight() {
+  backlight_flag = 0;
+  updateBacklight();
+}
+
+void LoggerDisplayI2C::clear() {
+  command(LCD_I2C_CMD_CLEAR);
+  send();
+  delayMicroseconds(2000); // clear takes 1.52ms
+}
+
+void LoggerDisplayI2C::setCursor(uint8_t col, uint8_t row) {
+  const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+  if (row >= lines || row > 3) row = (lines > 4 ? 4 : lines) - 1;
+  command(LCD_I2C_CMD_DDRAM | (col + row_offsets[row]));
+}
+
+size_t LoggerDisplayI2C::print(const char* text) {
+  size_t n = 0;
+  for (; text[n] != 0; n++) queueByte(text[n], LCD_I2C_RS);
+  send();
+  return(n);
+}
+
+/*** stats ***/
+
+unsigned long LoggerDisplayI2C::getTransactions() {
+  return(transactions);
+}
+
+unsigned long LoggerDisplayI2C::getBytes() {
+  return(bytes);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "application.h"
+
+/*** I2C LCD driver ***/
+
+// HD44780 character LCDs behind a PCF8574 I2C backpack (same wiring as LiquidCrystal_I2C)
+#define LCD_I2C_RS         0x01 // register select (0 = command, 1 = data)
+#define LCD_I2C_EN         0x04 // enable (the lcd reads the data lines on the falling edge)
+#define LCD_I2C_BACKLIGHT  0x08 // backlight on
+
+// lcd commands
+#define LCD_I2C_CMD_CLEAR  0x01
+#define LCD_I2C_CMD_ENTRY  0x06 // entry mode: left to right, no display shift
+#define LCD_I2C_CMD_ON     0x0C // display on, cursor off, blink off
+#define LCD_I2C_CMD_4BIT_1 0x20 // function set: 4 bit, 1 line
+#define LCD_I2C_CMD_4BIT_2 0x28 // function set: 4 bit, 2+ lines
+#define LCD_I2C_CMD_DDRAM  0x80 // set cursor address
+
+// bytes per I2C transaction (Wire buffer size)
+#define LCD_I2C_BURST_MAX  32
+
+// lcd driver that sends all enable-toggled nibbles of a text (and the preceding cursor command)
+// in a single I2C transaction instead of ~6 transactions per character
+//  - each character costs 4 bytes (2 nibbles x enable high/low), a new burst starts every LCD_I2C_BURST_MAX bytes
+//  - setCursor is only queued and goes out in the same transaction as the next print
+class LoggerDisplayI2C
+{
+
+  private:
+
+    uint8_t addr, cols, lines;
+    uint8_t backlight_flag = LCD_I2C_BACKLIGHT;
+
+    // burst buffer
+    uint8_t burst[LCD_I2C_BURST_MAX];
+    uint8_t burst_n = 0;
+    uint8_t burst_mode = 0xff; // register select of the last queued byte (0xff = unknown)
+
+    // stats
+    unsigned long transactions = 0;
+    unsigned long bytes = 0;
+
+    void queueByte(uint8_t value, uint8_t mode);
+    void queueNibble(uint8_t nibble, uint8_t mode); // nibble in the upper 4 bits
+    void send();
+    void command(uint8_t value);
+    void updateBacklight();
+
+  public:
+
+    /*** constructors ***/
+    LoggerDisplayI2C(uint8_t addr, uint8_t cols, uint8_t lines) : addr(addr), cols(cols), lines(lines) {}
+
+    /*** LiquidCrystal_I2C compatible interface ***/
+    void init();
+    void backlight();
+    void noBacklight();
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    size_t print(const char* text);
+
+    /*** stats ***/
+    unsigned long getTransactions(); // I2C transactions since init
+    unsigned long getBytes(); // I2C bytes since init (incl. the address byte of each transaction)
+
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+/*** log stack ***/
+
+// last-in-first-out stack of log texts in fixed storage (no heap allocation)
+// each entry is stored as its text (null terminated) followed by its length (2 bytes)
+// so the latest entry can be found without scanning the stack
+// the stack logic works on storage provided by the derived LoggerLogStack<SIZE>
+// so stacks of different sizes can be used through a common pointer (e.g. by the log transports)
+class LoggerLogStackBase
+{
+
+  private:
+
+    char* storage;
+    const size_t capacity;
+    size_t used = 0; // bytes in use
+    size_t n = 0; // number of entries
+    size_t max_used = 0; // high-water mark of the bytes in use
+    size_t max_n = 0; // high-water mark of the number of entries
+
+  protected:
+
+    LoggerLogStackBase(char* storage, size_t capacity) : storage(storage), capacity(capacity) {}
+
+  public:
+
+    bool empty() {
+      return(n == 0);
+    }
+
+    size_t size() {
+      return(n);
+    }
+
+    size_t bytesUsed() {
+      return(used);
+    }
+
+    size_t bytesCapacity() {
+      return(capacity);
+    }
+
+    size_t maxSize() {
+      return(max_n);
+    }
+
+    size_t maxBytesUsed() {
+      return(max_used);
+    }
+
+    // @return whether the log text fit onto the stack
+    bool push(const char* text) {
+      size_t length = strlen(text);
+      if (length > 0xffff || used + length + 1 + sizeof(uint16_t) > capacity) return(false);
+      uint16_t entry_length = length;
+      memcpy(storage + used, text, length + 1);
+      used += length + 1;
+      memcpy(storage + used, &entry_length, sizeof(entry_length));
+      used += sizeof(entry_length);
+      n++;
+      if (n > max_n) max_n = n;
+      if (used > max_used) max_used = used;
+      return(true);
+    }
+
+    // latest log text (only valid until the next push/pop)
+    const char* back() {
+      if (n == 0) return("");
+      uint16_t entry_length;
+      memcpy(&entry_length, storage + used - sizeof(entry_length), sizeof(entry_length));
+      return(storage + used - sizeof(entry_length) - entry_length - 1);
+    }
+
+    void pop() {
+      if (n == 0) return;
+      uint16_t entry_length;
+      memcpy(&entry_length, storage + used - sizeof(entry_length), sizeof(entry_length));
+      used -= entry_length + 1 + sizeof(entry_length);
+      n--;
+    }
+
+};
+
+template<size_t SIZE>
+class LoggerLogStack : public LoggerLogStackBase
+{
+
+  private:
+
+    char buffer[SIZE];
+
+  public:
+
+    LoggerLogStack() : LoggerLogStackBase(buffer, SIZE) {}
+
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <math.h>
+#include <stdint.h>
 
 /**** NUMERIC DATA FUNCTIONS ****/
 
@@ -48,30 +49,74 @@ static void print_to_signif (char* target, int size, double number, int signif)
 
 /**** Value statistics ****/
 
-// implemented based on Welford's algorithm
-struct RunningStats {
+// the accumulators (*Sums) do not keep the number of values, it is passed in so several accumulators of the same
+// values can share one count (see LoggerData), the *RunningStats structs bundle an accumulator with its own count
+
+// Welford's algorithm
+template<typename T>
+struct WelfordSums {
+
+    T mean;
+    T M2;
+
+    public:
+
+        void clear() {
+            mean = 0.0;
+            M2 = 0.0;
+        }
+
+        // @param n number of values including x
+        void add(T x, uint32_t n) {
+            T delta = x - mean;
+            mean += delta / n;
+            M2 += delta * (x - mean);
+        }
+
+        void set(uint32_t n, double mean_value, double variance) {
+            mean = mean_value;
+            M2 = (n > 1) ? variance * (n - 1) : 0.0;
+        }
+
+        double getMean(uint32_t n) {
+            return mean;
+        }
+
+        double getVariance(uint32_t n) {
+          // technically not defined for n = 1, returning 0.0 instead
+          return ( (n > 1) ? M2 / (n - 1) : 0.0 );
+        }
+
+};
+
+// @note templated on the accumulator type, on FPU-less processors (Photon) every double operation is emulated in software
+// so use float if the precision is sufficient or ScaledRunningStats for values with a fixed number of decimals
+template<typename T>
+struct RunningStatsT {
 
     int n;
-    double mean;
-    double M2;
+    WelfordSums<T> sums;
 
     public:
 
-        RunningStats() {
+        RunningStatsT() {
           clear();
         }
 
         void clear () {
             n = 0;
-            mean = 0.0;
-            M2 = 0.0;
+            sums.clear();
         }
 
-        void add(double x) {
+        void add(T x) {
             n++;
-            double delta = x - mean;
-            mean += delta / n;
-            M2 += delta * (x - mean);
+            sums.add(x, n);
+        }
+
+        // set the statistics directly (e.g. for derived values)
+        void set(int n_values, double mean_value, double variance) {
+            n = n_values;
+            sums.set(n, mean_value, variance);
         }
 
         int getN() {
@@ -79,17 +124,128 @@ struct RunningStats {
         }
 
         double getMean() {
-            return mean;
+            return sums.getMean(n);
         }
 
         double getVariance() {
-          // technically not defined for n = 1, returning 0.0 instead
-          return ( (n > 1) ? M2 / (n - 1) : 0.0 );
+          return sums.getVariance(n);
         }
 
         double getStdDev() {
             return sqrt( getVariance() );
         }
 
+};
+
+typedef RunningStatsT<double> RunningStats;
+
+// powers of 10 for scaled integers
+static const double SCALED_FACTORS[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// sums of values with a fixed number of decimals (0 to 9)
+// values are stored as integers (scaled by 10^decimals, relative to the first value to keep the sums small)
+// so adding a value costs one floating point multiplication instead of Welford's divisions,
+// mean and variance are only calculated in floating point when requested
+// @note values with more decimals are rounded, so use the decimals the instrument actually reports;
+// single deviations from the first value must stay within the 32 bit range (e.g. +/-200kg at 4 decimals) and
+// fluctuations beyond ~1e5 scaled units within one averaging period lose precision in the variance
+struct ScaledSums {
+
+    double offset; // first value (all others stored relative to it)
+    int64_t sum_sq; // sum of squared scaled deviations
+    int64_t sum; // sum of scaled deviations
+
+    public:
+
+        void clear() {
+            offset = 0.0;
+            sum = 0;
+            sum_sq = 0;
+        }
+
+        // @param n number of values including x
+        void add(double x, uint32_t n, uint8_t decimals) {
+            if (n == 1) offset = x;
+            int32_t dx = lround((x - offset) * SCALED_FACTORS[decimals]);
+            sum += dx;
+            sum_sq += (int64_t) dx * dx;
+        }
+
+        void set(uint32_t n, double mean_value, double variance, uint8_t decimals) {
+            double factor = SCALED_FACTORS[decimals];
+            offset = mean_value;
+            sum = 0;
+            sum_sq = (n > 1) ? llround(variance * (n - 1) * factor * factor) : 0;
+        }
+
+        double getMean(uint32_t n, uint8_t decimals) {
+            return ( (n > 0) ? offset + (double) sum / n / SCALED_FACTORS[decimals] : 0.0 );
+        }
+
+        double getVariance(uint32_t n, uint8_t decimals) {
+          // technically not defined for n = 1, returning 0.0 instead
+          if (n < 2) return(0.0);
+          double factor = SCALED_FACTORS[decimals];
+          double ss = (double) sum_sq - (double) sum * (double) sum / n;
+          return ( (ss > 0.0) ? ss / (n - 1) / factor / factor : 0.0 );
+        }
+
+};
+
+// running statistics on values with a fixed number of decimals (see ScaledSums)
+struct ScaledRunningStats {
+
+    ScaledSums sums;
+    uint32_t n; // number of values
+    uint8_t decimals; // scaling decimals (0 to 9)
+
+    public:
+
+        ScaledRunningStats(uint8_t d = 4) {
+          setDecimals(d);
+          clear();
+        }
+
+        void setDecimals(uint8_t d) {
+            decimals = (d > 9) ? 9 : d;
+        }
+
+        void clear () {
+            n = 0;
+            sums.clear();
+        }
+
+        void add(double x) {
+            n++;
+            sums.add(x, n, decimals);
+        }
+
+        // set the statistics directly (e.g. for derived values)
+        void set(int n_values, double mean_value, double variance) {
+            n = n_values;
+            sums.set(n, mean_value, variance, decimals);
+        }
+
+        int getN() {
+            return n;
+        }
+
+        double getMean() {
+            return sums.getMean(n, decimals);
+        }
+
+        double getVariance() {
+          return sums.getVariance(n, decimals);
+        }
+
+        double getStdDev() {
+            return sqrt( getVariance() );
+        }
 
 };
+
+// integer division rounded to the nearest integer (halves up, also for negative numerators)
+static int64_t divide_rounded(int64_t numerator, uint32_t n) {
+    int64_t x = numerator + n / 2;
+    return( (x >= 0) ? x / n : -((-x + n - 1) / n) );
+}
@@ -0,0 +1,85 @@
+#include "application.h"
+#include "LoggerMemory.h"
+#include <new>
+
+#if LOGGER_HEAP_TRACKING
+
+// counters (atomic updates, new/delete can be called from the system thread)
+static unsigned long heap_allocations = 0;
+static unsigned long heap_deallocations = 0;
+static unsigned long heap_bytes = 0;
+static unsigned long heap_bytes_total = 0;
+
+// allocation header to remember the size (padded to keep 8 byte alignment)
+union HeapHeader {
+  size_t size;
+  double align;
+};
+
+static void* trackedAlloc(size_t size) {
+  HeapHeader* header = (HeapHeader*) malloc(sizeof(HeapHeader) + size);
+  if (header == NULL) return(NULL);
+  header->size = size;
+  __atomic_add_fetch(&heap_allocations, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&heap_bytes, size, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&heap_bytes_total, size, __ATOMIC_RELAXED);
+  return(header + 1);
+}
+
+static void trackedFree(void* ptr) {
+  if (ptr == NULL) return;
+  HeapHeader* header = (HeapHeader*) ptr - 1;
+  __atomic_add_fetch(&heap_deallocations, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&heap_bytes, header->size, __ATOMIC_RELAXED);
+  free(header);
+}
+
+void* operator new(size_t size) { return(trackedAlloc(size)); }
+void* operator new[](size_t size) { return(trackedAlloc(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return(trackedAlloc(size)); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return(trackedAlloc(size)); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+
+unsigned long getHeapAllocations() { return(heap_allocations); }
+unsigned long getHeapDeallocations() { return(heap_deallocations); }
+unsigned long getHeapBytesInUse() { return(heap_bytes); }
+unsigned long getHeapBytesAllocated() { return(heap_bytes_total); }
+
+#else
+
+unsigned long getHeapAllocations() { return(0); }
+unsigned long getHeapDeallocations() { return(0); }
+unsigned long getHeapBytesInUse() { return(0); }
+unsigned long getHeapBytesAllocated() { return(0); }
+
+#endif
+
+/*** heap fragmentation ***/
+
+unsigned long getLargestFreeHeapBlock() {
+  runtime_info_t info;
+  memset(&info, 0, sizeof(info));
+  info.size = sizeof(info);
+  HAL_Core_Runtime_Info(&info, NULL);
+  return(info.largest_free_block_heap);
+}
+
+/*** stack usage ***/
+
+static uintptr_t stack_top = 0;
+static uintptr_t stack_deepest = 0;
+
+void __attribute__((noinline)) noteStackUsage() {
+  uintptr_t frame = (uintptr_t) __builtin_frame_address(0);
+  if (stack_top == 0) stack_top = frame;
+  if (stack_deepest == 0 || frame < stack_deepest) stack_deepest = frame;
+}
+
+unsigned long getStackHighWater() {
+  return( (stack_top > stack_deepest) ? stack_top - stack_deepest : 0 );
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stddef.h>
+
+/*** heap tracking ***/
+
+// replaces the global operator new/delete with versions that keep track of heap allocations
+// so the controller can check that nothing is allocated after setup (see LoggerController::update)
+// set to 0 to use the default operators (e.g. for host builds with sanitizers)
+// @note only new/delete are counted, direct malloc users (e.g. String, Time.format) are not seen by the check
+// and must be kept out of the loop paths
+#ifndef LOGGER_HEAP_TRACKING
+#define LOGGER_HEAP_TRACKING 1
+#endif
+
+// @return number of allocations via new since startup (0 if heap tracking is off)
+unsigned long getHeapAllocations();
+
+// @return number of deallocations via delete since startup (0 if heap tracking is off)
+unsigned long getHeapDeallocations();
+
+// @return number of bytes currently allocated via new (0 if heap tracking is off)
+unsigned long getHeapBytesInUse();
+
+// @return total number of bytes allocated via new since startup (0 if heap tracking is off)
+unsigned long getHeapBytesAllocated();
+
+/*** heap fragmentation ***/
+
+// @return the largest block that can currently be allocated from the heap
+unsigned long getLargestFreeHeapBlock();
+
+/*** stack usage ***/
+
+// note the current stack depth (call at the deepest points of the logger's call paths)
+// the first call marks the top of the stack (call it from setup)
+void noteStackUsage();
+
+// @return the deepest stack use noted so far (in bytes, approximate since it is only sampled where noteStackUsage is called)
+unsigned long getStackHighWater();
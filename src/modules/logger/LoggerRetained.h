@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*** retained memory parameters ***/
+#ifndef RETAINED_SIZE
+#define RETAINED_SIZE     1472 // payload bytes of each of the two retained snapshots (the photon has 3068 bytes of backup SRAM in total)
+#endif
+#define RETAINED_MAGIC    0x524c4f47 // marks an initialized snapshot
+#define RETAINED_VERSION  2 // snapshot format (part of the layout key)
+#define RETAINED_LAYOUT_SEED (2166136261UL ^ RETAINED_VERSION) // start value of the layout key
+
+/*** retained snapshot ***/
+
+// snapshot of the in-progress statistics in backup SRAM (retained variables), kept across warm resets
+// (watchdog, restart command, System.reset) and across power loss / brownouts if VBAT stays powered:
+//  - the controller assembles the payload (data accumulators, component specific data, log queue counts)
+//    and commits it whenever something changed, the commit seals it with a sequence number and a CRC
+//  - there are two snapshot buffers that are written alternately, a new snapshot is assembled in the buffer
+//    of the older one so the previous snapshot stays intact until the new one is sealed
+//  - the layout key identifies the data and components the payload was assembled from, a snapshot is only
+//    restored into the same layout (a firmware with different components or data starts from scratch)
+//  - a reset in the middle of a commit leaves a snapshot with a bad CRC, which is ignored: the newest intact
+//    snapshot is restored
+
+// marks the snapshot as outdated (the data call this whenever their accumulators change)
+void markRetainedDirty();
+
+// whether the snapshot is outdated
+bool isRetainedDirty();
+
+// @return the payload buffer for the next snapshot (RETAINED_SIZE bytes, the buffer of the older snapshot)
+uint8_t* getRetainedBuffer();
+
+// seals the first size bytes of the next snapshot with the layout key, the next sequence number and the CRC
+// (it becomes the newest snapshot, clears the dirty flag)
+void commitRetained(uint32_t layout, size_t size);
+
+// @return the payload size of the newest intact snapshot if it is for the layout (0 otherwise)
+size_t checkRetained(uint32_t layout);
+
+// @return the payload of the newest intact snapshot (NULL if there is none)
+const uint8_t* getRetainedSnapshot();
+
+// invalidates both snapshots
+void clearRetained();
+
+// CRC-16/CCITT (table driven, start with 0xffff)
+uint16_t calculateRetainedCRC(uint16_t crc, const uint8_t* data, size_t size);
+
+// layout key (FNV-1a) over the parts of the payload, start with RETAINED_LAYOUT_SEED
+uint32_t hashRetainedLayout(uint32_t hash, const char* text);
+uint32_t hashRetainedLayout(uint32_t hash, uint32_t value);
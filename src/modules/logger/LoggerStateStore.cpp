@@ -0,0 +1,308 @@
+#include "application.h"
+#include "LoggerStateStore.h"
+
+/*** eeprom access ***/
+
+size_t LoggerStateStore::getBankStart(uint8_t b) {
+  return(start + b * bank_size);
+}
+
+uint16_t LoggerStateStore::readUint16(size_t address) {
+  return(EEPROM.read(address) | (EEPROM.read(address + 1) << 8));
+}
+
+void LoggerStateStore::writeUint16(size_t address, uint16_t value) {
+  EEPROM.write(address, value & 0xff);
+  EEPROM.write(address + 1, value >> 8);
+}
+
+bool LoggerStateStore::readBankHeader(uint8_t b, uint16_t* gen) {
+  *gen = readUint16(getBankStart(b) + 2);
+  return(readUint16(getBankStart(b)) == STATE_STORE_MAGIC);
+}
+
+/*** setup ***/
+
+void LoggerStateStore::begin() {
+
+  // find active bank
+  uint16_t gen0, gen1;
+  bool valid0 = readBankHeader(0, &gen0);
+  bool valid1 = readBankHeader(1, &gen1);
+  if (valid0 && valid1) {
+    // both valid (interrupted compaction) --> the newer generation wins
+    bank = ((int16_t) (gen1 - gen0) > 0) ? 1 : 0;
+    generation = (bank == 0) ? gen0 : gen1;
+  } else if (valid0 || valid1) {
+    bank = valid0 ? 0 : 1;
+    generation = valid0 ? gen0 : gen1;
+  } else {
+    // start in the second bank, the first may hold states saved by older firmware (imported with loadLegacy)
+    Serial.println("INFO: no state store found in memory, formatting a new one");
+    format(1, 1);
+    legacy = true;
+  }
+
+  // index records
+  scanBank();
+  started = true;
+  Serial.printlnf("INFO: state store in bank %d (generation %u) with %d records, %u of %u bytes used",
+    bank, generation, index_n, getUsed(), getCapacity());
+}
+
+/*** keys ***/
+
+uint16_t LoggerStateStore::getKey(const char* id) {
+  // 32 bit FNV-1a folded to 16 bits
+  uint32_t hash = 2166136261UL;
+  for (const char* c = id; *c != 0; c++) {
+    hash ^= (uint8_t) *c;
+    hash *= 16777619UL;
+  }
+  uint16_t key = (hash >> 16) ^ (hash & 0xffff);
+  if (key == STATE_STORE_KEY_END) key--; // reserved
+  return(key);
+}
+
+int LoggerStateStore::findKey(uint16_t key) {
+  for (int i = 0; i < index_n; i++) {
+    if (index_keys[i] == key) return(i);
+  }
+  return(-1);
+}
+
+void LoggerStateStore::indexKey(uint16_t key, size_t pos) {
+  int i = findKey(key);
+  if (i < 0) {
+    if (index_n >= STATE_STORE_MAX_KEYS) {
+      Serial.printlnf("ERROR: state store index is full, cannot index record %04x (increase STATE_STORE_MAX_KEYS)", key);
+      return;
+    }
+    i = index_n;
+    index_n++;
+    index_keys[i] = key;
+  }
+  index_pos[i] = pos;
+}
+
+/*** records ***/
+
+uint16_t LoggerStateStore::calculateCRC(uint16_t key, uint8_t version, const uint8_t* data, uint8_t size) {
+  // CRC-16/CCITT over key, version, size and data
+  uint8_t header[4] = {(uint8_t) (key & 0xff), (uint8_t) (key >> 8), version, size};
+  uint16_t crc = 0xffff;
+  for (int i = 0; i < 4 + size; i++) {
+    crc ^= (uint16_t) ((i < 4) ? header[i] : data[i - 4]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return(crc);
+}
+
+// reads the record at pos into the record buffer
+// @return whether there is a valid record at pos
+bool LoggerStateStore::readRecord(uint8_t b, size_t pos, uint16_t* key, uint8_t* version, uint8_t* size, bool check_crc) {
+  if (pos + STATE_STORE_RECORD_OVERHEAD > bank_size) return(false);
+  size_t address = getBankStart(b) + pos;
+  *key = readUint16(address);
+  if (*key == STATE_STORE_KEY_END) return(false);
+  *version = EEPROM.read(address + 2);
+  *size = EEPROM.read(address + 3);
+  if (pos + STATE_STORE_RECORD_OVERHEAD + *size > bank_size) return(false);
+  for (int i = 0; i < *size; i++) record[i] = EEPROM.read(address + 4 + i);
+  if (!check_crc) return(true);
+  return(readUint16(address + 4 + *size) == calculateCRC(*key, *version, record, *size));
+}
+
+// writes a record and the end marker after it
+// the end marker goes first and the key last so an interrupted write never exposes stale records further down the bank
+// @return the position after the record
+size_t LoggerStateStore::writeRecord(uint8_t b, size_t pos, uint16_t key, uint8_t version, const uint8_t* data, uint8_t size) {
+  size_t address = getBankStart(b) + pos;
+  size_t next = pos + STATE_STORE_RECORD_OVERHEAD + size;
+  if (next + 2 <= bank_size) writeUint16(getBankStart(b) + next, STATE_STORE_KEY_END);
+  for (int i = 0; i < size; i++) EEPROM.write(address + 4 + i, data[i]);
+  writeUint16(address + 4 + size, calculateCRC(key, version, data, size));
+  EEPROM.write(address + 2, version);
+  EEPROM.write(address + 3, size);
+  writeUint16(address, key);
+  writes++;
+  return(next);
+}
+
+// indexes the valid records of the active bank
+// a corrupted record (bad CRC) whose size still fits the bank is skipped (the previous record for its key stays in use)
+// unless the record before was corrupted too (then its size was likely garbage and the rest of the bank is not trusted)
+void LoggerStateStore::scanBank() {
+  index_n = 0;
+  size_t pos = STATE_STORE_BANK_HEADER;
+  uint16_t key;
+  uint8_t version, size;
+  int bad_n = 0;
+  while (readRecord(bank, pos, &key, &version, &size, false)) {
+    if (readUint16(getBankStart(bank) + pos + 4 + size) == calculateCRC(key, version, record, size)) {
+      indexKey(key, pos);
+      bad_n = 0;
+    } else if (bad_n < STATE_STORE_MAX_BAD_RECORDS) {
+      Serial.printlnf("WARNING: state store skipping corrupted record %04x (%d bytes) at bank %d position %u", key, size, bank, pos);
+      bad_records++;
+      bad_n++;
+    } else {
+      Serial.printlnf("WARNING: state store stopped scanning at bank %d position %u after %d corrupted records", bank, pos, bad_n);
+      break;
+    }
+    pos += STATE_STORE_RECORD_OVERHEAD + size;
+  }
+  end = pos;
+}
+
+void LoggerStateStore::format(uint8_t b, uint16_t gen) {
+  writeUint16(getBankStart(b), 0); // invalidate while formatting
+  writeUint16(getBankStart(b) + STATE_STORE_BANK_HEADER, STATE_STORE_KEY_END);
+  writeUint16(getBankStart(b) + 2, gen);
+  writeUint16(getBankStart(b), STATE_STORE_MAGIC);
+  bank = b;
+  generation = gen;
+  end = STATE_STORE_BANK_HEADER;
+  index_n = 0;
+}
+
+// copy the latest record of each key (and the new record) into the other bank
+bool LoggerStateStore::compact(uint16_t key, uint8_t version, const uint8_t* data, uint8_t size) {
+
+  // check space
+  size_t needed = STATE_STORE_BANK_HEADER + STATE_STORE_RECORD_OVERHEAD + size;
+  uint16_t old_key;
+  uint8_t old_version, old_size;
+  for (int i = 0; i < index_n; i++) {
+    if (index_keys[i] != key && readRecord(bank, index_pos[i], &old_key, &old_version, &old_size, false))
+      needed += STATE_STORE_RECORD_OVERHEAD + old_size;
+  }
+  if (needed > bank_size) {
+    Serial.printlnf("ERROR: state store cannot fit all states (%u bytes needed, bank size %u)", needed, bank_size);
+    return(false);
+  }
+
+  // copy records
+  uint8_t target = 1 - bank;
+  legacy = false;
+  writeUint16(getBankStart(target), 0); // invalidate target while copying
+  size_t pos = STATE_STORE_BANK_HEADER;
+  for (int i = 0; i < index_n; i++) {
+    if (index_keys[i] != key && readRecord(bank, index_pos[i], &old_key, &old_version, &old_size))
+      pos = writeRecord(target, pos, old_key, old_version, record, old_size);
+  }
+  pos = writeRecord(target, pos, key, version, data, size);
+
+  // activate target bank (magic last), then retire the old one
+  writeUint16(getBankStart(target) + 2, generation + 1);
+  writeUint16(getBankStart(target), STATE_STORE_MAGIC);
+  writeUint16(getBankStart(bank), 0);
+  bank = target;
+  generation++;
+  compactions++;
+  scanBank();
+
+  if (debug_store) {
+    Serial.printlnf("DEBUG: state store compacted into bank %d (generation %u), %u of %u bytes used",
+      bank, generation, getUsed(), getCapacity());
+  }
+  return(true);
+}
+
+const uint8_t* LoggerStateStore::load(uint16_t key, uint8_t* version, size_t* size) {
+  if (!started) return(NULL);
+  int i = findKey(key);
+  if (i < 0) return(NULL);
+  uint16_t record_key;
+  uint8_t record_size;
+  if (!readRecord(bank, index_pos[i], &record_key, version, &record_size)) return(NULL);
+  *size = record_size;
+  return(record);
+}
+
+bool LoggerStateStore::save(uint16_t key, uint8_t version, const void* data, size_t size) {
+
+  // safety checks
+  if (!started) {
+    Serial.printlnf("ERROR: state store not started, cannot save state record %04x", key);
+    return(false);
+  }
+  if (size > STATE_STORE_RECORD_MAX) {
+    Serial.printlnf("ERROR: state record %04x is too large (%u bytes)", key, size);
+    return(false);
+  }
+
+  // unchanged?
+  uint8_t saved_version;
+  size_t saved_size;
+  const uint8_t* saved = load(key, &saved_version, &saved_size);
+  if (saved != NULL && saved_version == version && saved_size == size && memcmp(saved, data, size) == 0) {
+    skipped_writes++;
+    if (debug_store) Serial.printlnf("DEBUG: state record %04x unchanged, not saved", key);
+    return(true);
+  }
+
+  // new record
+  if (findKey(key) < 0 && index_n >= STATE_STORE_MAX_KEYS) {
+    Serial.printlnf("ERROR: state store cannot hold more than %d records (increase STATE_STORE_MAX_KEYS)", STATE_STORE_MAX_KEYS);
+    return(false);
+  }
+
+  // compact if the bank is full (record + end marker)
+  if (end + STATE_STORE_RECORD_OVERHEAD + size + 2 > bank_size) {
+    return(compact(key, version, (const uint8_t*) data, size));
+  }
+
+  // append
+  size_t pos = end;
+  end = writeRecord(bank, end, key, version, (const uint8_t*) data, size);
+  indexKey(key, pos);
+  if (debug_store) {
+    Serial.printlnf("DEBUG: state record %04x (version %d, %u bytes) saved at bank %d position %u",
+      key, version, size, bank, pos);
+  }
+  return(true);
+}
+
+const uint8_t* LoggerStateStore::loadLegacy(size_t address, size_t size) {
+  // only the first bank is untouched (and only until the store is first compacted into it)
+  if (!legacy || size > STATE_STORE_RECORD_MAX || address + size > getBankStart(1)) return(NULL);
+  bool erased = true;
+  for (size_t i = 0; i < size; i++) {
+    record[i] = EEPROM.read(address + i);
+    if (record[i] != 0xff) erased = false;
+  }
+  return(erased ? NULL : record);
+}
+
+/*** info ***/
+
+size_t LoggerStateStore::getCapacity() {
+  return(bank_size - STATE_STORE_BANK_HEADER);
+}
+
+size_t LoggerStateStore::getUsed() {
+  return(end - STATE_STORE_BANK_HEADER);
+}
+
+uint16_t LoggerStateStore::getGeneration() {
+  return(generation);
+}
+
+unsigned long LoggerStateStore::getWrites() {
+  return(writes);
+}
+
+unsigned long LoggerStateStore::getSkippedWrites() {
+  return(skipped_writes);
+}
+
+unsigned long LoggerStateStore::getCompactions() {
+  return(compactions);
+}
+
+unsigned long LoggerStateStore::getBadRecords() {
+  return(bad_records);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/*** state store parameters ***/
+#ifndef STATE_STORE_MAX_KEYS
+#define STATE_STORE_MAX_KEYS    16 // maximum number of distinct state records (controller + components)
+#endif
+#define STATE_STORE_RECORD_MAX  255 // maximum size of a state record (in bytes)
+
+// bank and record layout
+#define STATE_STORE_MAGIC       0x4C53 // marks a valid bank
+#define STATE_STORE_KEY_END     0xFFFF // marks the end of the records in a bank
+#define STATE_STORE_BANK_HEADER 4 // magic (2 bytes) + generation (2 bytes)
+#define STATE_STORE_RECORD_OVERHEAD 6 // key (2 bytes) + version (1 byte) + size (1 byte) + crc (2 bytes)
+#define STATE_STORE_MAX_BAD_RECORDS 1 // corrupted records skipped in a row while scanning a bank (more means the sizes are garbage too)
+
+/*** state store ***/
+
+// journaled key/value store for the controller and component states in the (emulated) EEPROM
+//  - the EEPROM is split into two banks, records are appended to the active bank so writes move across the whole bank (wear-leveling)
+//  - a full bank is compacted into the other bank (latest record for each key only), the bank generation decides which one is active
+//  - each record is protected by a CRC, torn or corrupted records are ignored (the previous record for the key is used instead)
+//  - records are identified by a key derived from the component id (independent of the order components are added in)
+//  - a new store starts in the second bank so states saved by older firmware (EEPROM.put at fixed offsets from 0)
+//    can still be imported until the first bank is used (see loadLegacy)
+class LoggerStateStore
+{
+
+  private:
+
+    // eeprom area
+    size_t start;
+    size_t bank_size;
+
+    // active bank
+    bool started = false; // whether begin() found/formatted the active bank (nothing is read or written before)
+    uint8_t bank = 0;
+    uint16_t generation = 0;
+    size_t end = 0; // where the next record goes (relative to the bank start)
+    bool legacy = false; // whether the first bank may still hold states in the old layout (new store, not yet compacted)
+
+    // index of the latest record for each key
+    uint16_t index_keys[STATE_STORE_MAX_KEYS];
+    uint16_t index_pos[STATE_STORE_MAX_KEYS];
+    uint8_t index_n = 0;
+
+    // record buffer
+    uint8_t record[STATE_STORE_RECORD_MAX];
+
+    // stats
+    unsigned long writes = 0; // number of records written since startup
+    unsigned long skipped_writes = 0; // number of writes skipped because the record was unchanged
+    unsigned long compactions = 0; // number of bank compactions since startup
+    unsigned long bad_records = 0; // corrupted records skipped while scanning
+
+    // eeprom access
+    size_t getBankStart(uint8_t b);
+    uint16_t readUint16(size_t address);
+    void writeUint16(size_t address, uint16_t value);
+    bool readBankHeader(uint8_t b, uint16_t* gen);
+
+    // records
+    static uint16_t calculateCRC(uint16_t key, uint8_t version, const uint8_t* data, uint8_t size);
+    bool readRecord(uint8_t b, size_t pos, uint16_t* key, uint8_t* version, uint8_t* size, bool check_crc = true);
+    size_t writeRecord(uint8_t b, size_t pos, uint16_t key, uint8_t version, const uint8_t* data, uint8_t size);
+    void scanBank();
+    void format(uint8_t b, uint16_t gen);
+    bool compact(uint16_t key, uint8_t version, const uint8_t* data, uint8_t size);
+    int findKey(uint16_t key);
+    void indexKey(uint16_t key, size_t pos);
+
+  public:
+
+    // debug flag
+    bool debug_store = false;
+
+    /*** constructors ***/
+    // @param size how many bytes of the EEPROM to use (0 = from the start to the end of the EEPROM)
+    LoggerStateStore(size_t start = 0, size_t size = 0) : start(start), bank_size(((size > 0) ? size : EEPROM.length() - start) / 2) {}
+
+    /*** setup ***/
+    void begin(); // finds the active bank and indexes its records (call once before using the store, loads and saves fail before)
+
+    /*** keys ***/
+    static uint16_t getKey(const char* id); // stable record key for an id (16 bit FNV-1a hash)
+
+    /*** records ***/
+    // loads the latest record for the key
+    // @return pointer to the record data (only valid until the next load), NULL if there is no record
+    const uint8_t* load(uint16_t key, uint8_t* version, size_t* size);
+    // writes a new record for the key (skipped if identical to the latest one)
+    // @return whether the record was saved
+    bool save(uint16_t key, uint8_t version, const void* data, size_t size);
+    // reads a state saved in the old layout (raw bytes at an EEPROM address)
+    // @return pointer to the data (only valid until the next load), NULL if the old layout is no longer available or the bytes are erased
+    const uint8_t* loadLegacy(size_t address, size_t size);
+
+    /*** info ***/
+    size_t getCapacity(); // how many bytes of records fit in one bank
+    size_t getUsed(); // how many bytes of records are in the active bank
+    uint16_t getGeneration();
+    unsigned long getWrites();
+    unsigned long getSkippedWrites();
+    unsigned long getCompactions();
+    unsigned long getBadRecords();
+
+};
@@ -0,0 +1,95 @@
+#include "application.h"
+#include "LoggerStream.h"
+#include "LoggerClock.h"
+
+/*** stream state ***/
+
+static bool streaming = false;
+static unsigned long streamed_records = 0;
+static unsigned long stream_dropped = 0;
+
+/*** checksum ***/
+
+// CRC-8 (polynomial 0x07)
+static uint8_t calculateCRC8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return(crc);
+}
+
+/*** COBS ***/
+
+size_t encodeCOBS(const uint8_t* data, size_t size, uint8_t* target) {
+    size_t code_pos = 0; // where the code byte of the current block goes
+    size_t pos = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != 0) {
+            target[pos++] = data[i];
+            code++;
+        }
+        if (data[i] == 0 || code == 0xff) {
+            // close the block
+            target[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    target[code_pos] = code;
+    return(pos);
+}
+
+/*** stream ***/
+
+void startStream() {
+    streamed_records = 0;
+    stream_dropped = 0;
+    streaming = true;
+}
+
+void stopStream() {
+    streaming = false;
+}
+
+bool isStreaming() {
+    return(streaming);
+}
+
+void streamValue(uint8_t idx, uint64_t local_ms, double value) {
+    if (!streaming) return;
+
+    // record (the photon is little endian so the values are copied as is)
+    uint8_t record[STREAM_RECORD_SIZE];
+    uint64_t epoch_ms = getEpochMillis(local_ms);
+    record[0] = idx;
+    memcpy(record + 1, &epoch_ms, sizeof(epoch_ms));
+    memcpy(record + 9, &value, sizeof(value));
+    record[17] = calculateCRC8(record, STREAM_RECORD_SIZE - 1);
+
+    // frame
+    uint8_t frame[STREAM_FRAME_MAX];
+    frame[0] = STREAM_DELIMITER;
+    size_t size = 1 + encodeCOBS(record, STREAM_RECORD_SIZE, frame + 1);
+    frame[size++] = STREAM_DELIMITER;
+
+    // send without blocking
+    if (Serial.availableForWrite() < (int) size) {
+        stream_dropped++;
+        return;
+    }
+    Serial.write(frame, size);
+    streamed_records++;
+}
+
+unsigned long getStreamedRecords() {
+    return(streamed_records);
+}
+
+unsigned long getStreamDropped() {
+    return(stream_dropped);
+}
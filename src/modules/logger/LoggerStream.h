@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*** stream parameters ***/
+// record (little endian): data index (1 byte) + data time as UTC epoch in ms (8 bytes) + value (8 byte double) + CRC-8 (1 byte)
+#define STREAM_RECORD_SIZE  18
+#define STREAM_FRAME_MAX    (STREAM_RECORD_SIZE + STREAM_RECORD_SIZE / 254 + 3) // COBS overhead + leading/trailing delimiter
+#define STREAM_DELIMITER    0x00 // frame delimiter (never part of a COBS encoded record)
+
+/*** raw data stream ***/
+
+// streams every saved data value (see LoggerData::saveNewestValue) as a COBS framed binary record over USB serial
+//  - each frame starts and ends with a delimiter so text printed between frames (INFO/DEBUG messages) ends up
+//    in its own chunk (readers skip chunks that do not decode to a record with a valid CRC)
+//  - frames are dropped (not waited for) when the USB serial buffer is full so streaming never stalls the loop
+//  - data logging continues unchanged while streaming
+
+void startStream();
+void stopStream();
+bool isStreaming();
+
+// stream a value (local_ms on the millis64() time line, converted to UTC epoch ms, 0 if the clock is not synced)
+void streamValue(uint8_t idx, uint64_t local_ms, double value);
+
+// @return number of records streamed since the stream started
+unsigned long getStreamedRecords();
+
+// @return number of records dropped because the USB serial buffer was full
+unsigned long getStreamDropped();
+
+// COBS encoding (without delimiter)
+// @return number of encoded bytes (at most size + size / 254 + 1)
+size_t encodeCOBS(const uint8_t* data, size_t size, uint8_t* target);
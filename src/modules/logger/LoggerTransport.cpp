@@ -0,0 +1,150 @@
+#include "application.h"
+#include "LoggerTransport.h"
+
+/*** queue ***/
+
+bool LoggerTransport::queueLog(uint8_t type, const char* log) {
+    LoggerLogStackBase* logs = getLogs(type);
+    if (logs == NULL || !logs->push(log)) {
+        dropped++;
+        return(false);
+    }
+    return(true);
+}
+
+LoggerLogStackBase* LoggerTransport::getLogs(uint8_t type) {
+    if (type == TRANSPORT_STATE_LOG) return(state_logs);
+    else if (type == TRANSPORT_DATA_LOG) return(data_logs);
+    return(NULL);
+}
+
+bool LoggerTransport::hasLogs() {
+    return(!state_logs->empty() || !data_logs->empty());
+}
+
+/*** data logs ***/
+
+bool LoggerTransport::hasDataLogPeriod() {
+    return(data_log_period > 0);
+}
+
+bool LoggerTransport::isTimeForDataLog() {
+    return(hasDataLogPeriod() && millis() - last_data_log >= data_log_period);
+}
+
+void LoggerTransport::markDataLog() {
+    last_data_log = millis();
+}
+
+/*** send ***/
+
+bool LoggerTransport::isTimeToSend() {
+    return(millis() - last_send > send_interval);
+}
+
+void LoggerTransport::markSendAttempt() {
+    last_send = millis();
+}
+
+/*** particle cloud ***/
+
+bool LoggerParticleTransport::isConnected() {
+    return(Particle.connected());
+}
+
+bool LoggerParticleTransport::send(uint8_t type, const char* log) {
+    bool success = Particle.publish(type == TRANSPORT_STATE_LOG ? state_event : data_event, log, WITH_ACK);
+    (success) ? sent++ : failed++;
+    return(success);
+}
+
+/*** frames ***/
+
+// frame header for the local transports: length of type + log (big endian), type
+static size_t getFrameHeader(uint8_t* header, uint8_t type, size_t log_length) {
+    uint16_t frame_length = log_length + 1;
+    header[0] = frame_length >> 8;
+    header[1] = frame_length & 0xff;
+    header[2] = type;
+    return(TRANSPORT_FRAME_HEADER);
+}
+
+/*** tcp ***/
+
+bool LoggerTCPTransport::isConnected() {
+    if (client.connected()) return(true);
+    if (!WiFi.ready()) return(false);
+    // connecting blocks until it succeeds or times out --> back off while the collector is down
+    if (reconnect_interval > 0 && millis() - last_connect < reconnect_interval) return(false);
+    connects++;
+    client.stop(); // release the socket of a dropped connection
+    bool success = client.connect(server, port);
+    last_connect = millis();
+    if (success) {
+        Serial.printlnf("INFO: tcp transport connected to port %d", port);
+        reconnect_interval = 0;
+        return(true);
+    }
+    reconnect_interval = (reconnect_interval == 0) ? TRANSPORT_RECONNECT_INTERVAL :
+        (reconnect_interval >= TRANSPORT_RECONNECT_MAX / 2) ? TRANSPORT_RECONNECT_MAX : 2 * reconnect_interval;
+    Serial.printlnf("WARNING: tcp transport could not connect to port %d, retrying in %lu ms", port, reconnect_interval);
+    return(false);
+}
+
+bool LoggerTCPTransport::send(uint8_t type, const char* log) {
+    size_t length = strlen(log);
+    if (length >= 0xffff) {
+        // cannot be framed, count as sent so it does not block the stack
+        Serial.printlnf("ERROR: tcp transport cannot send log of %d bytes, discarding it", length);
+        dropped++;
+        return(true);
+    }
+    uint8_t header[TRANSPORT_FRAME_HEADER];
+    size_t header_length = getFrameHeader(header, type, length);
+    bool success =
+        client.write(header, header_length) == header_length &&
+        client.write((const uint8_t*) log, length) == length;
+    if (success) {
+        sent++;
+    } else {
+        // partial frame on the wire --> start over with a new connection
+        failed++;
+        client.stop();
+    }
+    return(success);
+}
+
+/*** udp ***/
+
+bool LoggerUDPTransport::isConnected() {
+    if (!WiFi.ready()) {
+        if (started) {
+            udp.stop();
+            started = false;
+        }
+        return(false);
+    }
+    if (!started) {
+        started = udp.begin(port) != 0;
+        if (!started) Serial.printlnf("WARNING: udp transport could not open local port %d", port);
+    }
+    return(started);
+}
+
+bool LoggerUDPTransport::send(uint8_t type, const char* log) {
+    size_t length = strlen(log);
+    if (length >= 0xffff) {
+        Serial.printlnf("ERROR: udp transport cannot send log of %d bytes, discarding it", length);
+        dropped++;
+        return(true);
+    }
+    uint8_t header[TRANSPORT_FRAME_HEADER];
+    size_t header_length = getFrameHeader(header, type, length);
+    bool success =
+        udp.beginPacket(server, port) > 0 &&
+        udp.write(header, header_length) == header_length &&
+        udp.write((const uint8_t*) log, length) == length &&
+        udp.endPacket() > 0;
+    (success) ? sent++ : failed++;
+    return(success);
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include "LoggerLogStack.h"
+
+/*** transport parameters ***/
+#define TRANSPORT_STATE_LOG         'S' // state log (also the type byte of TCP/UDP frames)
+#define TRANSPORT_DATA_LOG          'D' // data log (also the type byte of TCP/UDP frames)
+#define TRANSPORT_FRAME_HEADER      3 // TCP/UDP frames: length of type + log (2 bytes, big endian) + type (1 byte), followed by the log text
+#define PARTICLE_PUBLISH_INTERVAL   1000 // 1/s is the max frequency for particle cloud publishing
+#ifndef TRANSPORT_LOCAL_SEND_INTERVAL
+#define TRANSPORT_LOCAL_SEND_INTERVAL   50 // default minimum time (in ms) between sends to a local collector (TCP/UDP)
+#endif
+#ifndef TRANSPORT_LOCAL_DATA_LOG_PERIOD
+#define TRANSPORT_LOCAL_DATA_LOG_PERIOD 1000 // default data log period (in ms) of the local transports (latest samples instead of the averaged data logs)
+#endif
+// connecting to a local collector blocks the loop (TCPClient has no connect timeout), attempts are only made
+// when logs are waiting and back off from the first to the maximum interval while the collector stays down
+#ifndef TRANSPORT_RECONNECT_INTERVAL
+#define TRANSPORT_RECONNECT_INTERVAL    10000 // how long (in ms) to wait after the first failed connection attempt
+#endif
+#ifndef TRANSPORT_RECONNECT_MAX
+#define TRANSPORT_RECONNECT_MAX         600000 // longest wait (in ms) between connection attempts (interval doubles after each failure)
+#endif
+
+/*** log stacks (fixed storage for logs waiting to be published, in bytes) ***/
+#ifndef STATE_LOG_STACK_SIZE
+#define STATE_LOG_STACK_SIZE  2048 // a few state logs
+#endif
+#ifndef DATA_LOG_STACK_SIZE
+#define DATA_LOG_STACK_SIZE   20000 // typically 50-100 data logs
+#endif
+
+/*** log stacks of the local transports (fixed storage for logs waiting to be sent, in bytes) ***/
+#ifndef LOCAL_STATE_LOG_STACK_SIZE
+#define LOCAL_STATE_LOG_STACK_SIZE  1024 // a few state logs
+#endif
+#ifndef LOCAL_DATA_LOG_STACK_SIZE
+#define LOCAL_DATA_LOG_STACK_SIZE   4096 // typically 10-20 data logs
+#endif
+
+/*** transport ***/
+
+// destination for the state and data logs (particle cloud, local TCP/UDP collector)
+// each transport has its own log stacks and send interval, the controller queues every state log
+// to all transports and sends the latest log of each transport once its interval is up (state logs first)
+// data logs depend on the transport's data log period: without one (particle cloud) the transport gets the averaged
+// data logs of the controller's log period, with one (local transports) it gets the latest raw samples of all data
+// (n = 1, each with its own data time) every data log period instead
+class LoggerTransport
+{
+
+  protected:
+
+    // rate limit
+    unsigned long send_interval; // minimum time between sends (in ms)
+    unsigned long last_send = 0;
+
+    // data logs
+    unsigned long data_log_period; // 0 = averaged data logs, otherwise latest samples every data_log_period ms
+    unsigned long last_data_log = 0;
+
+  public:
+
+    // transport name (for debug and status messages)
+    const char* name;
+
+    // log stacks (provided by the derived transport)
+    LoggerLogStackBase* state_logs;
+    LoggerLogStackBase* data_logs;
+
+    // stats
+    unsigned long connects = 0; // connection attempts
+    unsigned long sent = 0; // logs sent
+    unsigned long failed = 0; // failed send attempts (the log stays on the stack)
+    unsigned long dropped = 0; // logs not queued because the stack was full
+
+    // newest data time (millis64()) of the samples already logged (transports with a data log period)
+    uint64_t last_sample_time = 0;
+
+    /*** constructors ***/
+    LoggerTransport (const char* name, unsigned long send_interval, unsigned long data_log_period, LoggerLogStackBase* state_logs, LoggerLogStackBase* data_logs) :
+      send_interval(send_interval), data_log_period(data_log_period), name(name), state_logs(state_logs), data_logs(data_logs) {}
+
+    /*** connection ***/
+    // whether logs can be sent right now (transports with a connection (re)connect here as needed)
+    virtual bool isConnected() = 0;
+
+    /*** queue ***/
+    // @return whether the log fit onto the stack for its type
+    bool queueLog(uint8_t type, const char* log);
+    LoggerLogStackBase* getLogs(uint8_t type);
+    bool hasLogs();
+
+    /*** data logs ***/
+    bool hasDataLogPeriod(); // whether the transport gets the latest samples instead of the averaged data logs
+    bool isTimeForDataLog(); // whether the data log period is up
+    void markDataLog(); // restarts the data log period
+
+    /*** send ***/
+    bool isTimeToSend(); // whether the send interval is up
+    void markSendAttempt(); // restarts the send interval
+    // send a log (the caller pops it from the stack if successful)
+    // @return whether the log was sent
+    virtual bool send(uint8_t type, const char* log) = 0;
+
+};
+
+/*** particle cloud ***/
+
+// publishes the logs as particle events (picked up by the state/data log webhooks)
+class LoggerParticleTransport : public LoggerTransport
+{
+
+  private:
+
+    const char* state_event;
+    const char* data_event;
+
+  public:
+
+    // log stacks (these are the controller's primary log stacks so they are large)
+    LoggerLogStack<STATE_LOG_STACK_SIZE> state_log_stack;
+    LoggerLogStack<DATA_LOG_STACK_SIZE> data_log_stack;
+
+    LoggerParticleTransport (const char* state_event, const char* data_event, unsigned long send_interval = PARTICLE_PUBLISH_INTERVAL) :
+      LoggerTransport("particle", send_interval, 0, &state_log_stack, &data_log_stack), state_event(state_event), data_event(data_event) {}
+
+    bool isConnected();
+    bool send(uint8_t type, const char* log);
+
+};
+
+/*** tcp ***/
+
+// streams the logs to a local collector as length-prefixed frames (see TRANSPORT_FRAME_HEADER)
+// a failed or partial write drops the connection (so the collector never sees half a frame followed by the next one)
+class LoggerTCPTransport : public LoggerTransport
+{
+
+  private:
+
+    TCPClient client;
+    IPAddress server;
+    uint16_t port;
+    unsigned long last_connect = 0;
+    unsigned long reconnect_interval = 0; // wait before the next connection attempt (0 = try right away)
+
+  public:
+
+    LoggerLogStack<LOCAL_STATE_LOG_STACK_SIZE> state_log_stack;
+    LoggerLogStack<LOCAL_DATA_LOG_STACK_SIZE> data_log_stack;
+
+    LoggerTCPTransport (IPAddress server, uint16_t port, unsigned long send_interval = TRANSPORT_LOCAL_SEND_INTERVAL, unsigned long data_log_period = TRANSPORT_LOCAL_DATA_LOG_PERIOD) :
+      LoggerTransport("tcp", send_interval, data_log_period, &state_log_stack, &data_log_stack), server(server), port(port) {}
+
+    bool isConnected();
+    bool send(uint8_t type, const char* log);
+
+};
+
+/*** udp ***/
+
+// sends each log as one datagram (same frame as the TCP transport) to a local collector
+// there is no acknowledgement: a datagram lost on the way is not resent
+class LoggerUDPTransport : public LoggerTransport
+{
+
+  private:
+
+    UDP udp;
+    IPAddress server;
+    uint16_t port; // also used as the local port
+    bool started = false;
+
+  public:
+
+    LoggerLogStack<LOCAL_STATE_LOG_STACK_SIZE> state_log_stack;
+    LoggerLogStack<LOCAL_DATA_LOG_STACK_SIZE> data_log_stack;
+
+    LoggerUDPTransport (IPAddress server, uint16_t port, unsigned long send_interval = TRANSPORT_LOCAL_SEND_INTERVAL, unsigned long data_log_period = TRANSPORT_LOCAL_DATA_LOG_PERIOD) :
+      LoggerTransport("udp", send_interval, data_log_period, &state_log_stack, &data_log_stack), server(server), port(port) {}
+
+    bool isConnected();
+    bool send(uint8_t type, const char* log);
+
+};
@@ -8,19 +8,19 @@
 // NOTE: consider implementing better error catching for overlong key/value pairs
 
 // formatting patterns
-#define PATTERN_IKVSUNT_JSON      "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d,\"to\":%lu}"
+#define PATTERN_IKVSUNT_JSON      "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d,\"t\":%s}"
 #define PATTERN_IKVSUN_JSON       "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d}"
 #define PATTERN_IKVSUN_SIMPLE     "#%d %s: %s+/-%s%s (%d)"
 
-#define PATTERN_KVSUNT_JSON       "{\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d,\"to\":%lu}"
+#define PATTERN_KVSUNT_JSON       "{\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d,\"t\":%s}"
 #define PATTERN_KVSUN_JSON        "{\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d}"
 #define PATTERN_KVSUN_SIMPLE      "%s: %s+/-%s%s (%d)"
 
-#define PATTERN_IKVUNT_JSON       "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"u\":\"%s\",\"n\":%d,\"to\":%lu}"
+#define PATTERN_IKVUNT_JSON       "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"u\":\"%s\",\"n\":%d,\"t\":%s}"
 #define PATTERN_IKVUN_JSON        "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"u\":\"%s\",\"n\":%d}"
 #define PATTERN_IKVUN_SIMPLE      "#%d %s: %s%s (%d)"
 
-#define PATTERN_KVUNT_JSON        "{\"k\":\"%s\",\"v\":%s,\"u\":\"%s\",\"n\":%d,\"to\":%lu}"
+#define PATTERN_KVUNT_JSON        "{\"k\":\"%s\",\"v\":%s,\"u\":\"%s\",\"n\":%d,\"t\":%s}"
 #define PATTERN_KVUN_JSON         "{\"k\":\"%s\",\"v\":%s,\"u\":\"%s\",\"n\":%d}"
 #define PATTERN_KVUN_JSON_QUOTED  "{\"k\":\"%s\",\"v\":\"%s\",\"u\":\"%s\",\"n\":%d}"
 #define PATTERN_KVUN_SIMPLE       "%s: %s%s (%d)"
@@ -47,122 +47,160 @@
 
 /**** GENERAL UTILITY FUNCTIONS ****/
 
-static void getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(char* target, int size, int idx, char* key, char* value, char* sigma, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVSUNT_JSON) {
-  snprintf(target, size, pattern, idx, key, value, sigma, units, n, time_offset);
+#define EPOCH_TEXT_SIZE 21 // enough for any 64 bit number
+
+// UTC epoch time (in ms) as JSON number, null if there is no time (0 = clock not yet synced)
+// @note digits are assembled here because printf on the device (newlib nano) does not support %llu
+static void getEpochMillisText(uint64_t time, char* target, int size) {
+  if (time == 0) {
+    snprintf(target, size, "null");
+    return;
+  }
+  char digits[EPOCH_TEXT_SIZE];
+  int i = sizeof(digits) - 1;
+  digits[i] = 0;
+  do {
+    digits[--i] = '0' + (time % 10);
+    time /= 10;
+  } while (time > 0);
+  snprintf(target, size, "%s", digits + i);
+}
+
+static void getInfoIdxKeyValueSigmaUnitsNumberTime(char* target, int size, int idx, const char* key, const char* value, const char* sigma, const char* units, int n, uint64_t time, const char* pattern = PATTERN_IKVSUNT_JSON) {
+  char time_text[EPOCH_TEXT_SIZE];
+  getEpochMillisText(time, time_text, sizeof(time_text));
+  snprintf(target, size, pattern, idx, key, value, sigma, units, n, time_text);
 }
 
-static void getInfoKeyValueSigmaUnitsNumberTimeOffset(char* target, int size, char* key, char* value, char* sigma, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVSUNT_JSON) {
-  snprintf(target, size, pattern, key, value, sigma, units, n, time_offset);
+static void getInfoKeyValueSigmaUnitsNumberTime(char* target, int size, const char* key, const char* value, const char* sigma, const char* units, int n, uint64_t time, const char* pattern = PATTERN_IKVSUNT_JSON) {
+  char time_text[EPOCH_TEXT_SIZE];
+  getEpochMillisText(time, time_text, sizeof(time_text));
+  snprintf(target, size, pattern, key, value, sigma, units, n, time_text);
 }
 
-static void getInfoIdxKeyValueUnitsNumberTimeOffset(char* target, int size, int idx, char* key, char* value, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_IKVUNT_JSON) {
-  snprintf(target, size, pattern, idx, key, value, units, n, time_offset);
+static void getInfoIdxKeyValueUnitsNumberTime(char* target, int size, int idx, const char* key, const char* value, const char* units, int n, uint64_t time, const char* pattern = PATTERN_IKVUNT_JSON) {
+  char time_text[EPOCH_TEXT_SIZE];
+  getEpochMillisText(time, time_text, sizeof(time_text));
+  snprintf(target, size, pattern, idx, key, value, units, n, time_text);
 }
 
-static void getInfoKeyValueUnitsNumberTimeOffset(char* target, int size, char* key, char* value, char* units, int n, unsigned long time_offset, const char* pattern = PATTERN_KVUNT_JSON) {
-  snprintf(target, size, pattern, key, value, units, n, time_offset);
+static void getInfoKeyValueUnitsNumberTime(char* target, int size, const char* key, const char* value, const char* units, int n, uint64_t time, const char* pattern = PATTERN_KVUNT_JSON) {
+  char time_text[EPOCH_TEXT_SIZE];
+  getEpochMillisText(time, time_text, sizeof(time_text));
+  snprintf(target, size, pattern, key, value, units, n, time_text);
 }
 
-static void getInfoKeyValueUnitsNumber(char* target, int size, char* key, char* value, char* units, int n, const char* pattern = PATTERN_KVUN_SIMPLE) {
+static void getInfoKeyValueUnitsNumber(char* target, int size, const char* key, const char* value, const char* units, int n, const char* pattern = PATTERN_KVUN_SIMPLE) {
   snprintf(target, size, pattern, key, value, units, n);
 }
 
-static void getInfoValueUnitsNumber(char* target, int size, char* value, char* units, int n, const char* pattern = PATTERN_VUN_SIMPLE) {
+static void getInfoValueUnitsNumber(char* target, int size, const char* value, const char* units, int n, const char* pattern = PATTERN_VUN_SIMPLE) {
   snprintf(target, size, pattern, value, units, n);
 }
 
-static void getInfoIdxKeyValueUnits(char* target, int size, int idx, char* key, char* value, char* units, const char* pattern = PATTERN_IKVU_SIMPLE) {
+static void getInfoIdxKeyValueUnits(char* target, int size, int idx, const char* key, const char* value, const char* units, const char* pattern = PATTERN_IKVU_SIMPLE) {
   snprintf(target, size, pattern, idx, key, value, units);
 }
 
-static void getInfoKeyValueUnits(char* target, int size, char* key, char* value, char* units, const char* pattern = PATTERN_KVU_SIMPLE) {
+static void getInfoKeyValueUnits(char* target, int size, const char* key, const char* value, const char* units, const char* pattern = PATTERN_KVU_SIMPLE) {
   snprintf(target, size, pattern, key, value, units);
 }
 
-static void getInfoIdxKeyValue(char* target, int size, int idx, char* key, char* value, const char* pattern = PATTERN_IKV_SIMPLE) {
+static void getInfoIdxKeyValue(char* target, int size, int idx, const char* key, const char* value, const char* pattern = PATTERN_IKV_SIMPLE) {
   snprintf(target, size, pattern, idx, key, value);
 }
 
-static void getInfoKeyValue(char* target, int size, char* key, char* value, const char* pattern = PATTERN_KV_SIMPLE) {
+static void getInfoKeyValue(char* target, int size, const char* key, const char* value, const char* pattern = PATTERN_KV_SIMPLE) {
   snprintf(target, size, pattern, key, value);
 }
 
-static void getInfoValueUnits(char* target, int size, char* value, char* units, const char* pattern = PATTERN_VU_SIMPLE) {
+static void getInfoValueUnits(char* target, int size, const char* value, const char* units, const char* pattern = PATTERN_VU_SIMPLE) {
   snprintf(target, size, pattern, value, units);
 }
 
-static void getInfoValue(char* target, int size, char* value, const char* pattern = PATTERN_V_SIMPLE) {
+static void getInfoValue(char* target, int size, const char* value, const char* pattern = PATTERN_V_SIMPLE) {
   snprintf(target, size, pattern, value);
 }
 
+// appends text to a separated list in target (length = current length of the list, updated)
+// @return whether the text fit (if not, target is left unchanged)
+static bool addToList(char* target, int size, int* length, const char* text, const char* separator) {
+  int sep_length = (*length > 0) ? strlen(separator) : 0;
+  int text_length = strlen(text);
+  if (*length + sep_length + text_length >= size) return(false);
+  snprintf(target + *length, size - *length, "%s%s", (*length > 0) ? separator : "", text);
+  *length += sep_length + text_length;
+  return(true);
+}
+
 /**** DATA INFO FUNCTIONS ****/
 // Note: whenever idx is negative, it is excluded from the printing
 
-static void getDataDoubleWithSigmaText(int idx, char* key, double value, double sigma, char* units, int n, unsigned long time_offset, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleWithSigmaText(int idx, const char* key, double value, double sigma, const char* units, int n, uint64_t time, char* target, int size, const char* pattern, int decimals) {
   char value_text[20];
   print_to_decimals(value_text, sizeof(value_text), value, decimals);
   char sigma_text[20];
   print_to_decimals(sigma_text, sizeof(sigma_text), sigma, decimals);
   (idx >= 0) ?
-    getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(target, size, idx, key, value_text, sigma_text, units, n, time_offset, pattern) :
-    getInfoKeyValueSigmaUnitsNumberTimeOffset(target, size, key, value_text, sigma_text, units, n, time_offset, pattern);
+    getInfoIdxKeyValueSigmaUnitsNumberTime(target, size, idx, key, value_text, sigma_text, units, n, time, pattern) :
+    getInfoKeyValueSigmaUnitsNumberTime(target, size, key, value_text, sigma_text, units, n, time, pattern);
 
 }
 
-static void getDataDoubleWithSigmaText(int idx, char* key, double value, double sigma, char* units, int n, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleWithSigmaText(idx, key, value, sigma, units, n, -1, target, size, pattern, decimals);
+static void getDataDoubleWithSigmaText(int idx, const char* key, double value, double sigma, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleWithSigmaText(idx, key, value, sigma, units, n, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleWithSigmaText(char* key, double value, double sigma, char* units, int n, char* target, int size, char* pattern, int decimals) {
-  getDataDoubleWithSigmaText(-1, key, value, sigma, units, n, -1, target, size, pattern, decimals);
+static void getDataDoubleWithSigmaText(const char* key, double value, double sigma, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleWithSigmaText(-1, key, value, sigma, units, n, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* units, int n, unsigned long time_offset, char* target, int size, const char* pattern, int decimals) {
+static void getDataDoubleText(int idx, const char* key, double value, const char* units, int n, uint64_t time, char* target, int size, const char* pattern, int decimals) {
   char value_text[20];
   print_to_decimals(value_text, sizeof(value_text), value, decimals);
   (idx >= 0) ?
-    getInfoIdxKeyValueUnitsNumberTimeOffset(target, size, idx, key, value_text, units, n, time_offset, pattern) :
-    getInfoKeyValueUnitsNumberTimeOffset(target, size, key, value_text, units, n, time_offset, pattern);
+    getInfoIdxKeyValueUnitsNumberTime(target, size, idx, key, value_text, units, n, time, pattern) :
+    getInfoKeyValueUnitsNumberTime(target, size, key, value_text, units, n, time, pattern);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* units, int n, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleText(idx, key, value, units, n, -1, target, size, pattern, decimals);
+static void getDataDoubleText(int idx, const char* key, double value, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleText(idx, key, value, units, n, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* units, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleText(idx, key, value, units, -1, -1, target, size, pattern, decimals);
+static void getDataDoubleText(int idx, const char* key, double value, const char* units, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleText(idx, key, value, units, -1, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(int idx, char* key, double value, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleText(idx, key, value, "", -1, -1, target, size, pattern, decimals);
+static void getDataDoubleText(int idx, const char* key, double value, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleText(idx, key, value, "", -1, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(char* key, double value, char* units, int n, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleText(-1, key, value, units, n, -1, target, size, pattern, decimals);
+static void getDataDoubleText(const char* key, double value, const char* units, int n, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleText(-1, key, value, units, n, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(char* key, double value, char* units, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleText(-1, key, value, units, -1, -1, target, size, pattern, decimals);
+static void getDataDoubleText(const char* key, double value, const char* units, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleText(-1, key, value, units, -1, 0, target, size, pattern, decimals);
 }
 
-static void getDataDoubleText(char* key, double value, char* target, int size, const char* pattern, int decimals) {
-  getDataDoubleText(-1, key, value, "", -1, -1, target, size, pattern, decimals);
+static void getDataDoubleText(const char* key, double value, char* target, int size, const char* pattern, int decimals) {
+  getDataDoubleText(-1, key, value, "", -1, 0, target, size, pattern, decimals);
 }
 
-static void getDataNullText(int idx, char* key, char* target, int size, const char* pattern) {
+static void getDataNullText(int idx, const char* key, char* target, int size, const char* pattern) {
   char value_text[] = "null";
   (idx >= 0) ?
     getInfoIdxKeyValue(target, size, idx, key, value_text, pattern) :
     getInfoKeyValue(target, size, key, value_text, pattern);
 }
 
-static void getDataNullText(char* key, char* target, int size, const char* pattern) {
+static void getDataNullText(const char* key, char* target, int size, const char* pattern) {
   getDataNullText(-1, key, target, size, pattern);
 }
 /**** STATE INFO FUNCTIONS ****/
 
 // helper function to assemble char/string state text
-static void getStateStringText(char* key, char* value, char* target, int size, const char* pattern, bool include_key = true) {
+static void getStateStringText(const char* key, const char* value, char* target, int size, const char* pattern, bool include_key = true) {
   if (include_key)
     getInfoKeyValue(target, size, key, value, pattern);
   else
@@ -170,7 +208,7 @@ static void getStateStringText(char* key, char* value, char* target, int size, c
 }
 
 // helper function to assemble boolean state text
-static void getStateBooleanText(char* key, bool value, char* value_true, char* value_false, char* target, int size, const char* pattern, bool include_key = true) {
+static void getStateBooleanText(const char* key, bool value, const char* value_true, const char* value_false, char* target, int size, const char* pattern, bool include_key = true) {
   char value_text[20];
   value_text[sizeof(value_text) - 1] = 0; // make sure last index is null pointer just to be extra safe
   value ? strncpy(value_text, value_true, sizeof(value_text) - 1) : strncpy(value_text, value_false, sizeof(value_text) - 1);
@@ -181,7 +219,7 @@ static void getStateBooleanText(char* key, bool value, char* value_true, char* v
 }
 
 // helper function to assemble integer state text
-static void getStateIntText(char* key, int value, char* units, char* target, int size, const char* pattern, bool include_key = true) {
+static void getStateIntText(const char* key, int value, const char* units, char* target, int size, const char* pattern, bool include_key = true) {
   char value_text[10];
   snprintf(value_text, sizeof(value_text), "%d", value);
   if (include_key)
@@ -191,7 +229,7 @@ static void getStateIntText(char* key, int value, char* units, char* target, int
 }
 
 // helper function to assemble double state text
-static void getStateDoubleText(char* key, double value, char* units, char* target, int size, const char* pattern, int decimals, bool include_key = true) {
+static void getStateDoubleText(const char* key, double value, const char* units, char* target, int size, const char* pattern, int decimals, bool include_key = true) {
   char value_text[20];
   print_to_decimals(value_text, sizeof(value_text), value, decimals);
   (include_key) ?
@@ -1,6 +1,20 @@
 #include "application.h"
 #include "SerialReaderLoggerComponent.h"
 
+/*** debug ***/
+
+void SerialReaderLoggerComponent::captureSerial() {
+    capture_serial = true;
+}
+
+void SerialReaderLoggerComponent::flushCapture() {
+    if (capture_n == 0) return;
+    char hex[2 * SERIAL_CAPTURE_CHUNK + 1];
+    for (uint8_t i = 0; i < capture_n; i++) snprintf(hex + 2 * i, 3, "%02X", capture_buffer[i]);
+    Serial.printlnf("CAPTURE: %lu %s", millis(), hex);
+    capture_n = 0;
+}
+
 /*** setup ***/
 
 void SerialReaderLoggerComponent::init() {
@@ -13,6 +27,23 @@ void SerialReaderLoggerComponent::init() {
     while (Serial1.available()) Serial1.read();
 }
 
+/*** serial source ***/
+
+bool SerialReaderLoggerComponent::isSerialDataAvailable() {
+    if (replay_data) return(replay_pos < replay_size);
+    return(Serial1.available());
+}
+
+byte SerialReaderLoggerComponent::readSerialByte() {
+    if (replay_data) return(replay_data[replay_pos++]);
+    byte b = Serial1.read();
+    if (capture_serial) {
+        capture_buffer[capture_n++] = b;
+        if (capture_n == SERIAL_CAPTURE_CHUNK) flushCapture();
+    }
+    return(b);
+}
+
 /*** read data ***/
 
 void SerialReaderLoggerComponent::sendSerialDataRequest() {
@@ -24,22 +55,30 @@ void SerialReaderLoggerComponent::sendSerialDataRequest() {
 
 void SerialReaderLoggerComponent::idleDataRead() {
     // discard everyhing coming from the serial connection
-    while (Serial1.available()) Serial1.read();
+    while (isSerialDataAvailable()) readSerialByte();
+    flushCapture();
+}
+
+void SerialReaderLoggerComponent::sendDataRequest() {
+    if (capture_serial) {
+        flushCapture();
+        Serial.printlnf("CAPTURE: %lu REQUEST", millis());
+    }
+    if (!replay_data) sendSerialDataRequest();
 }
 
 void SerialReaderLoggerComponent::initiateDataRead() {
-    // initiate data read by sending command and registering resetting number of received bytes
+    // initiate data read by resetting number of received bytes (the request was sent in sendDataRequest)
     DataReaderLoggerComponent::initiateDataRead();
-    if (!isManualDataReader()) sendSerialDataRequest();
     n_byte = 0;
 }
 
 void SerialReaderLoggerComponent::readData() {
     // check serial connection for data
-    while (data_read_status == DATA_READ_WAITING && Serial1.available()) {
+    while (data_read_status == DATA_READ_WAITING && isSerialDataAvailable()) {
 
         // read byte
-        new_byte = Serial1.read();
+        new_byte = readSerialByte();
         n_byte++;
 
         // first byte
@@ -54,6 +93,7 @@ void SerialReaderLoggerComponent::readData() {
         }
 
     }
+    if (data_read_status != DATA_READ_WAITING) flushCapture();
 }
 
 void SerialReaderLoggerComponent::completeDataRead() {
@@ -73,6 +113,29 @@ void SerialReaderLoggerComponent::handleDataReadTimeout() {
     }
 }
 
+/*** replay ***/
+
+// runs one complete read (request to finished data) on recorded bytes instead of Serial1
+// the recorded bytes are the response to one request, the read goes through the same state machine steps as in update()
+// (data, read statistics and data variable are updated as for a regular read, no request goes out on Serial1)
+int SerialReaderLoggerComponent::replaySerialData(const byte* data, size_t size) {
+    replay_data = data;
+    replay_size = size;
+    replay_pos = 0;
+    unsigned long completes = read_stats.completes;
+    requestDataRead();
+    for (uint8_t step = 0; step < DATA_READ_MAX_STEPS && read_stats.completes == completes && stepDataRead(); step++);
+    int errors = error_counter;
+    if (read_stats.completes == completes) {
+        // recording ended before the data pattern was complete --> drop the read
+        data_read_status = DATA_READ_IDLE;
+        popDataReadRequest();
+        errors = -1;
+    }
+    replay_data = NULL;
+    return(errors);
+}
+
 /*** manage data ***/
 
 void SerialReaderLoggerComponent::startData() {
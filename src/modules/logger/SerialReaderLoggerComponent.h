@@ -1,6 +1,11 @@
 #pragma once
 #include "DataReaderLoggerComponent.h"
 
+// capture: received bytes per CAPTURE line (bytes are collected and printed as hex at the end of each read or when this many are in)
+#ifndef SERIAL_CAPTURE_CHUNK
+#define SERIAL_CAPTURE_CHUNK 16
+#endif
+
 /* component */
 class SerialReaderLoggerComponent : public DataReaderLoggerComponent
 {
@@ -18,6 +23,17 @@ class SerialReaderLoggerComponent : public DataReaderLoggerComponent
     unsigned int data_pattern_size = 0;
     byte new_byte;
 
+    // capture (dump raw serial bytes with arrival times to USB serial)
+    bool capture_serial = false;
+    byte capture_buffer[SERIAL_CAPTURE_CHUNK];
+    uint8_t capture_n = 0;
+    void flushCapture(); // prints the collected bytes ("CAPTURE: <ms> <hex bytes>")
+
+    // replay (feed recorded serial bytes instead of Serial1)
+    const byte *replay_data = NULL;
+    size_t replay_size = 0;
+    size_t replay_pos = 0;
+
     // buffers
     char data_buffer[500];
     int data_charcounter;
@@ -36,11 +52,24 @@ class SerialReaderLoggerComponent : public DataReaderLoggerComponent
     SerialReaderLoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset, const long baud_rate, const long serial_config, const char *request_command) : 
       SerialReaderLoggerComponent(id, ctrl, data_have_same_time_offset, baud_rate, serial_config, request_command, 0) {}
 
+    /*** debug ***/
+    void captureSerial();
+
     /*** setup ***/
     virtual void init();
 
+    /*** serial source ***/
+    bool isSerialDataAvailable();
+    byte readSerialByte();
+
+    /*** replay ***/
+    // runs one read on the recorded bytes through the read state machine of update()
+    // @return the number of read errors, -1 if the data did not complete a read
+    int replaySerialData(const byte* data, size_t size);
+
     /*** read data ***/
     virtual void sendSerialDataRequest();
+    virtual void sendDataRequest();
     virtual void idleDataRead();
     virtual void initiateDataRead();
     virtual void readData();
@@ -11,6 +11,8 @@ uint8_t ScaleLoggerComponent::setupDataVector(uint8_t start_idx) {
     // add data: idx, key
     data[0] = LoggerData(1, "weight");
     data[1] = LoggerData(2, "rate");
+    // weights have a fixed number of decimals --> average as scaled integers (much cheaper than double precision)
+    data[0].setScaledStats(weight_decimals);
     // rate is persistent (i.e. not cleared after each log since it's calculated from two weights)
     data[1].makePersistent();
 
@@ -23,34 +25,53 @@ size_t ScaleLoggerComponent::getStateSize() {
     return(sizeof(*state));
 }
 
+void* ScaleLoggerComponent::getStateData() {
+    return(state);
+}
+
 void ScaleLoggerComponent::saveState() { 
-    EEPROM.put(eeprom_start, *state);
-    if (ctrl->debug_state) {
-        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
-    }
+    saveStateRecord(state, sizeof(*state), state->version);
 } 
 
 bool ScaleLoggerComponent::restoreState() {
-    ScaleState *saved_state = new ScaleState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState();
-    }
-    return(recoverable);
+    return(restoreStateRecord(state, sizeof(*state), &state->version));
 }
 
 void ScaleLoggerComponent::resetState() {
+    SerialReaderLoggerComponent::resetState();
     state->version = 0; // force reset of state on restart
     saveState();
 }
 
+/*** retained data ***/
+
+size_t ScaleLoggerComponent::getRetainedSize() {
+    return(sizeof(prev_weight1) + sizeof(prev_weight2) + sizeof(prev_data_time1) + sizeof(prev_data_time2));
+}
+
+void ScaleLoggerComponent::retain(uint8_t* target) {
+    memcpy(target, &prev_weight1, sizeof(prev_weight1)); target += sizeof(prev_weight1);
+    memcpy(target, &prev_weight2, sizeof(prev_weight2)); target += sizeof(prev_weight2);
+    memcpy(target, &prev_data_time1, sizeof(prev_data_time1)); target += sizeof(prev_data_time1);
+    memcpy(target, &prev_data_time2, sizeof(prev_data_time2));
+}
+
+void ScaleLoggerComponent::restoreRetained(const uint8_t* source, int64_t time_shift) {
+    memcpy(&prev_weight1, source, sizeof(prev_weight1)); source += sizeof(prev_weight1);
+    memcpy(&prev_weight2, source, sizeof(prev_weight2)); source += sizeof(prev_weight2);
+    memcpy(&prev_data_time1, source, sizeof(prev_data_time1)); source += sizeof(prev_data_time1);
+    memcpy(&prev_data_time2, source, sizeof(prev_data_time2));
+    // data times from before the reset on the current time line
+    prev_data_time1 += time_shift;
+    prev_data_time2 += time_shift;
+}
+
 /*** command parsing ***/
 
+void ScaleLoggerComponent::registerCommands() {
+  registerCommand(CMD_CALC_RATE, "calc-rate off/s/m/h/d");
+}
+
 bool ScaleLoggerComponent::parseCommand(LoggerCommand *command) {
   if (parseCalcRate(command)) {
     // calc rate command parsed
@@ -102,7 +123,7 @@ bool ScaleLoggerComponent::changeCalcRate(uint rate) {
     Serial.printlnf("INFO: setting rate to %d", rate):
     Serial.printlnf("INFO: rate unchanged (%d)", rate);
 
-  if (changed) saveState();
+  if (changed) markStateDirty();
 
   return(changed);
 }
@@ -117,9 +138,9 @@ void ScaleLoggerComponent::calculateRate() {
   } else {
     // set rate units text
     char rate_units[10];
-    strncpy(rate_units, data[0].units, sizeof(rate_units) - 1);
-    strcpy(rate_units + strlen(data[0].units), "/");
-    getStateCalcRateText(state->calc_rate, rate_units + strlen(data[0].units) + 1, sizeof(rate_units), true);
+    strncpy(rate_units, data[0].getUnits(), sizeof(rate_units) - 1);
+    strcpy(rate_units + strlen(data[0].getUnits()), "/");
+    getStateCalcRateText(state->calc_rate, rate_units + strlen(data[0].getUnits()) + 1, sizeof(rate_units), true);
     rate_units[sizeof(rate_units) - 1] = 0; // safety
     data[1].setUnits(rate_units);
     
@@ -133,14 +154,13 @@ void ScaleLoggerComponent::calculateRate() {
     data[1].setNewestValue(rate);
 
     // calculate mean data time
-    unsigned long data_time = (unsigned long) round( 0.5 * (double) prev_data_time1 + 0.5 * (double) prev_data_time2 );
+    uint64_t data_time = prev_data_time2 + (prev_data_time1 - prev_data_time2 + 1) / 2;
     data[1].setNewestDataTime(data_time);
     data[1].saveNewestValue(false);
 
     // n and variance
-    data[1].value.n = prev_weight1.getN() + prev_weight2.getN();
     double variance = (prev_weight1.getVariance() + prev_weight2.getVariance()) / (time_diff * time_diff);
-    data[1].value.M2 = variance * (data[1].value.n - 1); // a bit round-about but works
+    data[1].setValueStats(prev_weight1.getN() + prev_weight2.getN(), rate, variance);
 
     // set decimals to 5 significant digits
     data[1].setDecimals(find_signif_decimals (rate, 5, false, 6));
@@ -160,6 +180,7 @@ void ScaleLoggerComponent::finishData() {
 /*** logger state variable ***/
 
 void ScaleLoggerComponent::assembleStateVariable() {
+    SerialReaderLoggerComponent::assembleStateVariable();
     char pair[60];
     getStateCalcRateText(state->calc_rate, pair, sizeof(pair)); ctrl->addToStateVariableBuffer(pair);
 }
@@ -178,8 +199,9 @@ void ScaleLoggerComponent::clearData(bool clear_persistent) {
 void ScaleLoggerComponent::logData() {
   prev_weight2 = prev_weight1;
   prev_data_time2 = prev_data_time1;
-  prev_weight1 = data[0].value;
-  prev_data_time1 = data[0].data_time.getMean();
+  prev_weight1.set(data[0].getN(), data[0].getValue(), data[0].getVariance());
+  prev_data_time1 = data[0].getDataTime();
+  markRetainedDirty();
   calculateRate();
   SerialReaderLoggerComponent::logData();
 }
\ No newline at end of file
@@ -64,8 +64,11 @@ class ScaleLoggerComponent : public SerialReaderLoggerComponent
     // weight memory for rate calculation
     RunningStats prev_weight1;
     RunningStats prev_weight2;
-    unsigned long prev_data_time1;
-    unsigned long prev_data_time2;
+    uint64_t prev_data_time1;
+    uint64_t prev_data_time2;
+
+    // decimals the instrument reports weights with (used for the scaled integer averaging)
+    uint8_t weight_decimals;
 
   public:
 
@@ -74,8 +77,10 @@ class ScaleLoggerComponent : public SerialReaderLoggerComponent
 
     /*** constructors ***/
     // scale does not have global time offset since rate timestampe is beween two serial reads
+    ScaleLoggerComponent (const char *id, LoggerController *ctrl, ScaleState* state, const long baud_rate, const long serial_config, const char *request_command, unsigned int data_pattern_size, uint8_t weight_decimals) : 
+      SerialReaderLoggerComponent(id, ctrl, false, baud_rate, serial_config, request_command, data_pattern_size), weight_decimals(weight_decimals), state(state) {}
     ScaleLoggerComponent (const char *id, LoggerController *ctrl, ScaleState* state, const long baud_rate, const long serial_config, const char *request_command, unsigned int data_pattern_size) : 
-      SerialReaderLoggerComponent(id, ctrl, false, baud_rate, serial_config, request_command, data_pattern_size), state(state) {}
+      ScaleLoggerComponent(id, ctrl, state, baud_rate, serial_config, request_command, data_pattern_size, 4) {}
     ScaleLoggerComponent (const char *id, LoggerController *ctrl, ScaleState* state, const long baud_rate, const long serial_config, const char *request_command) : 
       ScaleLoggerComponent(id, ctrl, state, baud_rate, serial_config, request_command, 0) {}
 
@@ -84,11 +89,18 @@ class ScaleLoggerComponent : public SerialReaderLoggerComponent
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual void* getStateData();
     virtual void saveState();
     virtual bool restoreState();
     virtual void resetState();
 
+    /*** retained data ***/
+    virtual size_t getRetainedSize(); // weight memory for the rate calculation
+    virtual void retain(uint8_t* target);
+    virtual void restoreRetained(const uint8_t* source, int64_t time_shift);
+
     /*** command parsing ***/
+    void registerCommands();
     bool parseCommand(LoggerCommand *command);
     bool parseCalcRate(LoggerCommand *command);
 
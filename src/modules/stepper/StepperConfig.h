@@ -139,17 +139,23 @@ struct MicrostepMode {
 
 /*** stepper driver ***/
 
+// maximum number of microstepping modes (1, 2, 4, ... 256 steps)
+#define STEPPER_MS_MODES_MAX 9
+
 struct StepperDriver {
   const bool dir_cw; // is clockwise LOW or HIGH?
   const bool step_on; // is a step made on LOW or HIGH?
   const bool enable_on; // is enable on LOW or HIGH?
   const int ms_modes_n; // number of microstepping modes
-  MicrostepMode* ms_modes; // microstepping modes
+  MicrostepMode ms_modes[STEPPER_MS_MODES_MAX]; // microstepping modes
   StepperDriver(bool dir_cw, bool step_on, bool enable_on, MicrostepMode* ms_modes, int ms_modes_n) :
-    dir_cw(dir_cw), step_on(step_on), enable_on(enable_on), ms_modes_n(ms_modes_n) {
-      // allocate microstep modes (FIXME: is there a better way to do this with pointers?)
-      this->ms_modes = new MicrostepMode[ms_modes_n];
-      for (int i = 0; i < ms_modes_n; i++) this->ms_modes[i] = ms_modes[i];
+    dir_cw(dir_cw), step_on(step_on), enable_on(enable_on), 
+    ms_modes_n(ms_modes_n > STEPPER_MS_MODES_MAX ? STEPPER_MS_MODES_MAX : ms_modes_n) {
+      if (ms_modes_n > STEPPER_MS_MODES_MAX) {
+        Serial.println("ERROR: more microstepping modes than STEPPER_MS_MODES_MAX, only the first ones are used!!!");
+      }
+      // copy microstep modes
+      for (int i = 0; i < this->ms_modes_n; i++) this->ms_modes[i] = ms_modes[i];
     };
 
   // calculates rpm limits for all modes
@@ -197,10 +203,7 @@ struct StepperDriver {
     return(rpm > getRpmLimit(index));
   }
 
-  // destructor (deallocate ms_modes)
-  virtual ~StepperDriver(){
-     delete[] ms_modes;
-  }
+  virtual ~StepperDriver(){}
 
 };
 
@@ -76,25 +76,16 @@ size_t StepperLoggerComponent::getStateSize() {
     return(sizeof(*state));
 }
 
+void* StepperLoggerComponent::getStateData() {
+    return(state);
+}
+
 void StepperLoggerComponent::saveState() { 
-    EEPROM.put(eeprom_start, *state);
-    if (ctrl->debug_state) {
-        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
-    }
+    saveStateRecord(state, sizeof(*state), state->version);
 } 
 
 bool StepperLoggerComponent::restoreState() {
-    StepperState *saved_state = new StepperState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState();
-    }
-    return(recoverable);
+    return(restoreStateRecord(state, sizeof(*state), &state->version));
 }
 
 void StepperLoggerComponent::resetState() {
@@ -102,8 +93,24 @@ void StepperLoggerComponent::resetState() {
     saveState();
 }
 
+bool StepperLoggerComponent::rollbackState(const uint8_t* source) {
+    bool changed = ControllerLoggerComponent::rollbackState(source);
+    if (changed) updateStepper(); // back to the restored status, direction and speed
+    return(changed);
+}
+
 /*** command parsing ***/
 
+void StepperLoggerComponent::registerCommands() {
+  registerCommand(CMD_START, "start");
+  registerCommand(CMD_STOP, "stop");
+  registerCommand(CMD_HOLD, "hold");
+  registerCommand(CMD_ROTATE, "rotate number");
+  registerCommand(CMD_DIR, "direction cw/cc/switch");
+  registerCommand(CMD_SPEED, "speed number rpm");
+  registerCommand(CMD_STEP, "ms number/auto");
+}
+
 bool StepperLoggerComponent::parseCommand(LoggerCommand *command) {
   if (parseStatus(command)) {
     // check for status commands
@@ -260,7 +267,7 @@ bool StepperLoggerComponent::changeStatus(int status) {
   if (changed) {
     state->status = status;
     updateStepper();
-    saveState();
+    saveState(); // status saved right away (motor must not restart unexpectedly)
   }
   return(changed);
 }
@@ -293,9 +300,12 @@ bool StepperLoggerComponent::changeDirection(int direction) {
       // if rotating to a specific position, changing direction turns the pump off
       Serial.println("INFO: stepper stopped due to change in direction during 'rotate'");
       state->status = STATUS_OFF;
+      updateStepper();
+      saveState(); // status saved right away
+    } else {
+      updateStepper();
+      markStateDirty();
     }
-    updateStepper();
-    saveState();
   }
 
   return(changed);
@@ -315,7 +325,7 @@ bool StepperLoggerComponent::changeSpeedRpm(float rpm) {
 
   if (changed) {
     updateStepper();
-    saveState();
+    markStateDirty();
   }
   return(changed);
 }
@@ -333,7 +343,7 @@ bool StepperLoggerComponent::changeToAutoMicrosteppingMode() {
     state->ms_index = findMicrostepIndexForRpm(state->rpm);
     state->ms_mode = driver->getMode(state->ms_index); // tracked for convenience
     updateStepper();
-    saveState();
+    markStateDirty();
   }
   return(changed);
 }
@@ -361,7 +371,7 @@ bool StepperLoggerComponent::changeMicrosteppingMode(int ms_mode) {
     state->ms_mode = driver->getMode(ms_index); // tracked for convenience
     setSpeedWithSteppingLimit(state->rpm); // update speed (if necessary)
     updateStepper();
-    saveState();
+    markStateDirty();
   }
   return(changed);
 }
@@ -407,7 +417,7 @@ void StepperLoggerComponent::updateStepper() {
         if (debug_mode) {
             Serial.printf("DEBUG: logging speed shift from %.4f to %.4frpm\n", data[0].getValue(), new_rpm);
         }
-        data[1].setNewestDataTime(millis() - 1); // old value logged 1 ms before new value
+        data[1].setNewestDataTime(millis64() - 1); // old value logged 1 ms before new value
         data[1].setNewestValue(data[0].getValue());
         data[1].saveNewestValue(false); // no averaging
     } 
@@ -479,7 +489,7 @@ void StepperLoggerComponent::assembleStateVariable() {
 
 void StepperLoggerComponent::logData() {
   // always log data[0] with latest current time
-  data[0].setNewestDataTime(millis());
+  data[0].setNewestDataTime(millis64());
   data[0].saveNewestValue(false);
   ControllerLoggerComponent::logData();
 }
@@ -770,7 +780,7 @@ int StepperLoggerComponent::findMicrostepIndexForRpm(float rpm) {
 
 bool StepperLoggerComponent::assembleDataLog() {
   // always reset time offset to 0
-  data[0].setNewestDataTime(millis());
+  data[0].setNewestDataTime(millis64());
   data[0].saveNewestValue(false); // no averaging
   // individual time offsets
   return(LoggerController::assembleDataLog(false));
@@ -801,12 +811,12 @@ void StepperLoggerComponent::changeData() {
 
     if (data[0].newest_value_valid) {
       data[1].setNewestValue(data[0].getValue());
-      data[1].setNewestDataTime(millis() - 1);
+      data[1].setNewestDataTime(millis64() - 1);
       data[1].saveNewestValue(false); // no averaging
     }
     // set newet value (date time and averaging will happens assembledatalog)
     data[0].setNewestValue(new_rpm);
-    data[0].setNewestDataTime(millis());
+    data[0].setNewestDataTime(millis64());
     data[0].saveNewestValue(false); // no averagings
     last_data_log = millis();
     logData();
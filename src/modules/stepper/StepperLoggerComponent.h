@@ -70,11 +70,14 @@ class StepperLoggerComponent : public ControllerLoggerComponent {
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual void* getStateData();
     virtual void saveState();
     virtual bool restoreState();
     virtual void resetState();
+    virtual bool rollbackState(const uint8_t* source);
 
     /*** command parsing ***/
+    void registerCommands();
     bool parseCommand(LoggerCommand *command);
     bool parseStatus(LoggerCommand *command);
     bool parseDirection(LoggerCommand *command);
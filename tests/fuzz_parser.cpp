@@ -0,0 +1,55 @@
+// host fuzzer for the command tokenizer, the controller's command processing and the scale serial parser
+// (same targets as the on-device debug/parser_fuzz, see parser_fuzz_targets.h), built with address sanitizer
+//  - make -C tests fuzz_parser: replays the seed corpora and a fixed number of random mutations (part of make test)
+//  - make -C tests fuzz: libFuzzer build (requires clang), e.g. tests/build/fuzz_parser_libfuzzer -max_total_time=600
+//    the first byte of each input selects the target
+#include "application.h"
+#include "../src/debug/parser_fuzz/parser_fuzz_targets.h"
+#include "test.h"
+
+// mutated inputs per target for the standalone run
+#ifndef FUZZ_ITERATIONS
+#define FUZZ_ITERATIONS 20000
+#endif
+
+typedef int (*FuzzTarget)(const uint8_t*, size_t);
+const FuzzTarget FUZZ_TARGETS[] = {fuzzCommandTokenizer, fuzzReceiveCommand, fuzzSerialParser};
+const int FUZZ_TARGETS_N = sizeof(FUZZ_TARGETS) / sizeof(FUZZ_TARGETS[0]);
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) {
+  setupFuzzTargets();
+  return(0);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size == 0) return(0);
+  Serial.output.clear(); // keep the captured serial output from growing
+  return(FUZZ_TARGETS[data[0] % FUZZ_TARGETS_N](data + 1, size - 1));
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+static void fuzz(const char* name, FuzzTarget target, const char** corpus, int corpus_n) {
+  for (int i = 0; i < corpus_n; i++) target((const uint8_t*) corpus[i], strlen(corpus[i]));
+  for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+    size_t size = mutateFuzzInput(corpus[random(corpus_n)]);
+    Serial.output.clear();
+    target(fuzz_input, size);
+  }
+  printf("INFO: %s survived %d seeds and %d mutated inputs\n", name, corpus_n, FUZZ_ITERATIONS);
+}
+
+int main() {
+  randomSeed(1);
+  setupFuzzTargets();
+  fuzz("tokenizer", fuzzCommandTokenizer, COMMAND_CORPUS, COMMAND_CORPUS_N);
+  fuzz("controller", fuzzReceiveCommand, CONTROLLER_CORPUS, CONTROLLER_CORPUS_N);
+  fuzz("serial", fuzzSerialParser, SERIAL_CORPUS, SERIAL_CORPUS_N);
+  // the store is never started --> nothing may have been written to the EEPROM
+  bool eeprom_untouched = true;
+  for (int i = 0; i < HOST_EEPROM_SIZE; i++) if (EEPROM.writes[i] > 0) eeprom_untouched = false;
+  CHECK(eeprom_untouched);
+  return(TEST_RESULT());
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include "application.h"
+#include <stdarg.h>
+
+/*** time ***/
+
+unsigned long host_millis = 0;
+
+unsigned long millis() { return(host_millis); }
+unsigned long micros() { return(host_millis * 1000UL); }
+void delay(unsigned long ms) { host_millis += ms; }
+void delayMicroseconds(unsigned int us) {}
+
+/*** pins ***/
+
+int host_pins[20];
+
+void pinMode(int pin, int mode) {}
+int digitalRead(int pin) { return(host_pins[pin]); }
+void digitalWrite(int pin, int value) { host_pins[pin] = value; }
+
+/*** random ***/
+
+long random(long max) { return( (max > 0) ? rand() % max : 0 ); }
+long random(long min, long max) { return( min + random(max - min) ); }
+void randomSeed(unsigned long seed) { srand(seed); }
+
+/*** string ***/
+
+void String::toCharArray(char* buffer, unsigned int size) const {
+  if (size == 0) return;
+  strncpy(buffer, text.c_str(), size - 1);
+  buffer[size - 1] = 0;
+}
+
+String operator+(const char* a, const String& b) { return(String(a) + b); }
+
+/*** serial ***/
+
+Stream Serial;
+Stream Serial1;
+
+int Stream::read() {
+  if (input.empty()) return(-1);
+  uint8_t b = input.front();
+  input.pop_front();
+  return(b);
+}
+
+size_t Stream::write(const uint8_t* data, size_t size) {
+  output.append((const char*) data, size);
+  if (echo) fwrite(data, 1, size, stdout);
+  return(size);
+}
+
+size_t Stream::print(const char* text) {
+  return(write((const uint8_t*) text, strlen(text)));
+}
+
+size_t Stream::print(int value) {
+  char text[12];
+  snprintf(text, sizeof(text), "%d", value);
+  return(print(text));
+}
+
+size_t Stream::printf(const char* format, ...) {
+  char text[1024];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return(print(text));
+}
+
+size_t Stream::printlnf(const char* format, ...) {
+  char text[1024];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return(println(text));
+}
+
+void Stream::feed(const char* text) {
+  for (const char* c = text; *c != 0; c++) input.push_back((uint8_t) *c);
+}
+
+/*** i2c ***/
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address) {
+  transactions.push_back(HostI2CTransaction());
+  transactions.back().address = address;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  return(0);
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+  if (transactions.empty()) return(0);
+  transactions.back().data.insert(transactions.back().data.end(), data, data + size);
+  return(size);
+}
+
+/*** time ***/
+
+TimeClass Time;
+
+String TimeClass::format(time_t t, const char* format) {
+  t += (time_t) (host_zone * 3600);
+  struct tm calendar_time;
+  gmtime_r(&t, &calendar_time);
+  char text[100];
+  strftime(text, sizeof(text), format, &calendar_time);
+  return(String(text));
+}
+
+/*** eeprom ***/
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() {
+  clear();
+}
+
+void EEPROMClass::clear() {
+  memset(bytes, 0xff, sizeof(bytes));
+  memset(writes, 0, sizeof(writes));
+  fail_after = -1;
+}
+
+uint8_t EEPROMClass::read(int address) {
+  if (address < 0 || address >= HOST_EEPROM_SIZE) {
+    fprintf(stderr, "EEPROM read out of range: %d\n", address);
+    abort();
+  }
+  return(bytes[address]);
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address < 0 || address >= HOST_EEPROM_SIZE) {
+    fprintf(stderr, "EEPROM write out of range: %d\n", address);
+    abort();
+  }
+  if (fail_after == 0) return; // power is gone
+  if (fail_after > 0) fail_after--;
+  bytes[address] = value;
+  writes[address]++;
+}
+
+/*** cloud, wifi, system ***/
+
+CloudClass Particle;
+WiFiClass WiFi;
+SystemClass System;
+
+bool CloudClass::publish(const char* event, const char* data, int flags) {
+  if (!host_connected) return(false);
+  published.push_back(std::string(event) + " " + data);
+  return(true);
+}
+
+int HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved) {
+  info->largest_free_block_heap = 50000;
+  return(0);
+}
+
+/*** network ***/
+
+bool host_tcp_listening = false;
+unsigned long host_tcp_connect_ms = 0;
+int host_tcp_connects = 0;
+std::string host_tcp_sent;
+std::vector<std::string> host_udp_packets;
+
+bool TCPClient::connect(IPAddress server, uint16_t port) {
+  host_tcp_connects++;
+  if (!host_tcp_listening) host_millis += host_tcp_connect_ms; // connecting to nothing blocks until the timeout
+  is_connected = host_tcp_listening;
+  return(is_connected);
+}
+
+size_t TCPClient::write(const uint8_t* data, size_t size) {
+  if (!connected()) return(0);
+  host_tcp_sent.append((const char*) data, size);
+  return(size);
+}
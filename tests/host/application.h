@@ -0,0 +1,274 @@
+#pragma once
+// host stand-in for the Device OS application.h (only what the logger modules use)
+// the clock and the peripherals are plain host_* variables so the tests can drive and inspect them
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+using namespace std::chrono_literals;
+
+typedef unsigned int uint;
+typedef uint8_t byte;
+typedef uint32_t system_tick_t;
+
+/*** system macros ***/
+#define retained
+#define STARTUP(x)
+#define SYSTEM_THREAD(x)
+#define SYSTEM_MODE(x)
+#define waitFor(condition, timeout) (condition())
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define A5 15
+#define D0 0
+#define D2 2
+#define D3 3
+#define D4 4
+#define D5 5
+#define D6 6
+#define D7 7
+#define SERIAL_8N1 0
+#define PRIVATE 1
+#define WITH_ACK 2
+#define MY_DEVICES 0
+#define ALL_DEVICES 1
+#define RESET_NO_WAIT 1
+#define RESET_REASON_USER 140
+#define FEATURE_RESET_INFO 1
+#define FEATURE_RETAINED_MEMORY 2
+
+/*** time ***/
+extern unsigned long host_millis; // current millis(), advanced by the tests (and by delay)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/*** pins ***/
+extern int host_pins[20]; // digitalRead values
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+
+/*** random ***/
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/*** string ***/
+class String {
+  private:
+    std::string text;
+  public:
+    String() {}
+    String(const char* t) : text(t) {}
+    String(int value) : text(std::to_string(value)) {}
+    const char* c_str() const { return(text.c_str()); }
+    operator const char*() const { return(text.c_str()); }
+    unsigned length() const { return(text.length()); }
+    void toCharArray(char* buffer, unsigned int size) const;
+    String operator+(const String& other) const { String s; s.text = text + other.text; return(s); }
+    int indexOf(char c) const { size_t i = text.find(c); return(i == std::string::npos ? -1 : (int) i); }
+    int indexOf(const char* t) const { size_t i = text.find(t); return(i == std::string::npos ? -1 : (int) i); }
+};
+String operator+(const char* a, const String& b);
+
+/*** serial ***/
+class Stream {
+  public:
+    std::deque<uint8_t> input; // bytes waiting to be read
+    std::string output; // everything written
+    bool echo = false; // also print the output to stdout
+    int write_capacity = 64; // availableForWrite
+    void begin(long baud) {}
+    void begin(long baud, long config) {}
+    bool isConnected() { return(true); }
+    int available() { return(input.size()); }
+    int availableForWrite() { return(write_capacity); }
+    int read();
+    int peek() { return(input.empty() ? -1 : input.front()); }
+    void flush() {}
+    size_t write(uint8_t b) { return(write(&b, 1)); }
+    size_t write(const uint8_t* data, size_t size);
+    size_t print(const char* text);
+    size_t print(const String& text) { return(print(text.c_str())); }
+    size_t print(char c) { return(write((uint8_t) c)); }
+    size_t print(int value);
+    size_t println() { return(print("\n")); }
+    size_t println(const char* text) { return(print(text) + println()); }
+    size_t println(const String& text) { return(println(text.c_str())); }
+    size_t println(char c) { return(print(c) + println()); }
+    size_t println(int value) { return(print(value) + println()); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t printlnf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void feed(const char* text); // queue text as input
+};
+extern Stream Serial;
+extern Stream Serial1;
+
+/*** i2c ***/
+struct HostI2CTransaction {
+  uint8_t address;
+  std::vector<uint8_t> data;
+};
+class TwoWire {
+  public:
+    std::vector<HostI2CTransaction> transactions; // completed transactions
+    void begin() {}
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool stop = true);
+    size_t write(uint8_t b) { return(write(&b, 1)); }
+    size_t write(const uint8_t* data, size_t size);
+};
+extern TwoWire Wire;
+
+/*** time ***/
+class TimeClass {
+  public:
+    time_t host_time = 0; // current UTC time (s)
+    bool host_valid = false;
+    float host_zone = 0; // hours
+    time_t now() { return(host_time); }
+    time_t local() { return(host_time + (time_t) (host_zone * 3600)); }
+    bool isValid() { return(host_valid); }
+    void zone(float hours) { host_zone = hours; }
+    String format(time_t t, const char* format);
+};
+extern TimeClass Time;
+
+/*** eeprom ***/
+#define HOST_EEPROM_SIZE 2047 // same as the Photon
+class EEPROMClass {
+  public:
+    uint8_t bytes[HOST_EEPROM_SIZE];
+    unsigned long writes[HOST_EEPROM_SIZE]; // number of writes per address (wear)
+    long fail_after = -1; // if >= 0: number of byte writes until a simulated power cut (later writes are lost)
+    EEPROMClass();
+    void clear(); // erased state (all 0xff)
+    size_t length() { return(HOST_EEPROM_SIZE); }
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    template<class T> T& get(int address, T& t) { memcpy(&t, bytes + address, sizeof(T)); return(t); }
+    template<class T> const T& put(int address, const T& t) {
+      for (size_t i = 0; i < sizeof(T); i++) write(address + i, ((const uint8_t*) &t)[i]);
+      return(t);
+    }
+};
+extern EEPROMClass EEPROM;
+
+/*** cloud ***/
+class CloudClass {
+  public:
+    bool host_connected = false;
+    time_t host_sync_time = 0; // epoch time (s) of the last time sync
+    system_tick_t host_sync_millis = 0; // millis() of the last time sync (0 = none yet)
+    std::vector<std::string> published;
+    bool connected() { return(host_connected); }
+    void process() {}
+    void connect() {}
+    void syncTime() {}
+    bool syncTimePending() { return(false); }
+    system_tick_t timeSyncedLast() { return(host_sync_millis); }
+    system_tick_t timeSyncedLast(time_t& t) { t = host_sync_time; return(host_sync_millis); }
+    bool publish(const char* event, int flags) { return(publish(event, "", flags)); }
+    bool publish(const char* event, const char* data, int flags);
+    template<class T> bool subscribe(const char*, void (T::*)(const char*, const char*), T*, int) { return(true); }
+    bool subscribe(const char*, void (*)(const char*, const char*), int) { return(true); }
+    void unsubscribe() {}
+    template<class T> bool function(const char*, int (T::*)(String), T*) { return(true); }
+    bool variable(const char*, const char*) { return(true); }
+};
+extern CloudClass Particle;
+
+/*** wifi ***/
+class WiFiClass {
+  public:
+    bool host_ready = false;
+    void on() {}
+    bool ready() { return(host_ready); }
+    void macAddress(uint8_t* mac) { memset(mac, 0, 6); }
+};
+extern WiFiClass WiFi;
+
+/*** system ***/
+class SystemClass {
+  public:
+    int host_reset_reason = 0;
+    uint32_t host_reset_reason_data = 0;
+    int host_resets = 0;
+    uint32_t freeMemory() { return(60000); }
+    int resetReason() { return(host_reset_reason); }
+    uint32_t resetReasonData() { return(host_reset_reason_data); }
+    void enableFeature(int) {}
+    void reset() { host_resets++; }
+    void reset(uint32_t, int) { host_resets++; }
+};
+extern SystemClass System;
+
+class ApplicationWatchdog {
+  public:
+    ApplicationWatchdog(std::chrono::seconds, void (*)(), unsigned) {}
+    void checkin() {}
+};
+
+typedef struct {
+  uint16_t size;
+  uint16_t flags;
+  uint32_t freeheap;
+  uint32_t system_version;
+  uint32_t total_init_heap;
+  uint32_t total_heap;
+  uint32_t max_used_heap;
+  uint32_t user_static_ram;
+  uint32_t largest_free_block_heap;
+} runtime_info_t;
+int HAL_Core_Runtime_Info(runtime_info_t* info, void* reserved);
+
+/*** network ***/
+class IPAddress {
+  public:
+    uint8_t octets[4] = {0, 0, 0, 0};
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    operator bool() const { return(octets[0] || octets[1] || octets[2] || octets[3]); }
+};
+
+// connect/write results and the data sent are shared by all clients (tests use one at a time)
+extern bool host_tcp_listening; // whether connect succeeds
+extern unsigned long host_tcp_connect_ms; // how long a connect attempt blocks (advances millis)
+extern int host_tcp_connects; // connect attempts
+extern std::string host_tcp_sent; // bytes written to the connection
+class TCPClient {
+  private:
+    bool is_connected = false;
+  public:
+    bool connect(IPAddress server, uint16_t port);
+    bool connected() { return(is_connected && host_tcp_listening); }
+    size_t write(const uint8_t* data, size_t size);
+    void stop() { is_connected = false; }
+    int available() { return(0); }
+    int read() { return(-1); }
+};
+
+extern std::vector<std::string> host_udp_packets; // datagrams sent
+class UDP {
+  private:
+    std::string packet;
+  public:
+    uint8_t begin(uint16_t port) { return(1); }
+    int beginPacket(IPAddress server, uint16_t port) { packet.clear(); return(1); }
+    size_t write(const uint8_t* data, size_t size) { packet.append((const char*) data, size); return(size); }
+    int endPacket() { host_udp_packets.push_back(packet); return(1); }
+    void stop() {}
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdio.h>
+#include <math.h>
+
+// minimal checks for the host tests: failed checks are printed and counted, main returns TEST_RESULT()
+static int test_checks = 0;
+static int test_failures = 0;
+
+#define CHECK(condition) do { \
+    test_checks++; \
+    if (!(condition)) { \
+      test_failures++; \
+      printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+    } \
+  } while (0)
+
+#define CHECK_CLOSE(a, b, tolerance) do { \
+    test_checks++; \
+    double _a = (a), _b = (b); \
+    if (!(fabs(_a - _b) <= (tolerance))) { \
+      test_failures++; \
+      printf("FAIL: %s:%d: %s = %.15g vs %s = %.15g (tolerance %g)\n", __FILE__, __LINE__, #a, _a, #b, _b, (double) (tolerance)); \
+    } \
+  } while (0)
+
+#define TEST_RESULT() ( \
+    printf("%s: %d checks, %d failed\n", (test_failures == 0) ? "PASS" : "FAIL", test_checks, test_failures), \
+    (test_failures == 0) ? 0 : 1 )
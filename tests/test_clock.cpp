@@ -0,0 +1,105 @@
+// tests of the epoch mapping (LoggerClock.h), the epoch times in the data logs (LoggerUtils.h) and the local time text
+//  - 100 days of a clock that runs 40 ppm fast with daily cloud syncs (seconds resolution, up to 300 ms latency)
+//    plus reconnect syncs in between (too close together for a drift estimate)
+#include "application.h"
+#include "LoggerClock.h"
+#include "LoggerUtils.h"
+#include "test.h"
+
+static void testEpochText() {
+  char text[EPOCH_TEXT_SIZE];
+  getEpochMillisText(0, text, sizeof(text));
+  CHECK(strcmp(text, "null") == 0);
+  getEpochMillisText(7, text, sizeof(text));
+  CHECK(strcmp(text, "7") == 0);
+  getEpochMillisText(999, text, sizeof(text));
+  CHECK(strcmp(text, "999") == 0);
+  getEpochMillisText(1000, text, sizeof(text));
+  CHECK(strcmp(text, "1000") == 0);
+  getEpochMillisText(1700000000123ULL, text, sizeof(text));
+  CHECK(strcmp(text, "1700000000123") == 0);
+  getEpochMillisText(UINT64_MAX, text, sizeof(text));
+  CHECK(strcmp(text, "18446744073709551615") == 0);
+
+  // unsynced and early times are valid JSON numbers (or null)
+  char json[100];
+  getInfoIdxKeyValueUnitsNumberTime(json, sizeof(json), 1, "weight", "1.5", "g", 3, 0);
+  CHECK(strcmp(json, "{\"i\":1,\"k\":\"weight\",\"v\":1.5,\"u\":\"g\",\"n\":3,\"t\":null}") == 0);
+  getInfoIdxKeyValueUnitsNumberTime(json, sizeof(json), 1, "weight", "1.5", "g", 3, 42);
+  CHECK(strcmp(json, "{\"i\":1,\"k\":\"weight\",\"v\":1.5,\"u\":\"g\",\"n\":3,\"t\":42}") == 0);
+}
+
+// local time with its UTC offset (not the GMT strftime would print for a gmtime calendar time)
+static void testLocalTimeText() {
+  Time.host_time = 1700000000; // 2023-11-14 22:13:20 UTC
+  Time.zone(1);
+  CHECK(strcmp(getLocalTimeText(), "2023-11-14 23:13:20 +01:00") == 0);
+  Time.zone(-3.5);
+  CHECK(strcmp(getLocalTimeText(), "2023-11-14 18:43:20 -03:30") == 0);
+  Time.zone(0);
+  CHECK(strcmp(getLocalTimeText("at %H:%M %Z (100%%)"), "at 22:13 +00:00 (100%)") == 0);
+  char text[27];
+  formatLocalTime(text, sizeof(text));
+  CHECK(strlen(text) == 26);
+  Time.host_time = 0;
+}
+
+static void testDrift() {
+  const double ppm = 40.0; // local crystal runs fast
+  const double epoch0 = 1.7e12 + 123.0; // true UTC (ms) at the start
+  const double step = 50;
+  const double days = 100;
+  host_millis = 0xFFFFFFFFUL - 3600000UL; // millis() overflows after 1 h
+  double local = 0; // elapsed local ms
+  double next_sync = 0, next_reconnect = 7200e3;
+  uint64_t last_epoch = 0;
+  int backwards = 0;
+  double max_error_late = 0;
+  long max_drift_late = -1000, min_drift_late = 1000;
+
+  srand(1);
+  while (local < days * 86400e3) {
+    local += step;
+    host_millis += (unsigned long) step;
+    double truth = epoch0 + local / (1 + ppm * 1e-6);
+    bool sync = false;
+    if (local >= next_sync) {
+      sync = true;
+      next_sync += 86400e3;
+    } else if (local >= next_reconnect) {
+      // cloud reconnect (also syncs the time)
+      sync = true;
+      next_reconnect += 7200e3 + (rand() % 3600) * 1e3;
+    }
+    if (sync) {
+      Particle.host_sync_millis = (system_tick_t) host_millis;
+      Particle.host_sync_time = (time_t) floor((truth - (rand() % 300)) / 1000.0);
+    }
+    updateClock();
+    if (!isClockSynced()) continue;
+    uint64_t epoch = getEpochMillis();
+    if (epoch < last_epoch) backwards++;
+    last_epoch = epoch;
+    if (local > 10 * 86400e3) {
+      double error = fabs((double) epoch - truth);
+      if (error > max_error_late) max_error_late = error;
+      if (getClockDrift() > max_drift_late) max_drift_late = getClockDrift();
+      if (getClockDrift() < min_drift_late) min_drift_late = getClockDrift();
+    }
+  }
+  printf("INFO: %lu syncs, drift compensation %ld to %ld ppm after day 10 (actual %.0f ppm), max error %.0f ms\n",
+    getClockSyncs(), min_drift_late, max_drift_late, -ppm, max_error_late);
+  CHECK(backwards == 0);
+  // estimates from daily syncs are +/- 12 ppm, the filter narrows that further
+  CHECK(min_drift_late >= -ppm - 12);
+  CHECK(max_drift_late <= -ppm + 12);
+  // less than 1.5 s off at any time (sync resolution + latency + residual drift over a day)
+  CHECK(max_error_late < 1500);
+}
+
+int main() {
+  testEpochText();
+  testLocalTimeText();
+  testDrift();
+  return(TEST_RESULT());
+}
@@ -0,0 +1,93 @@
+// tests of the cloud command handler (LoggerController::receiveCommand): unknown and locked commands are rejected
+// right away (with the lock state the queued commands leave behind), everything else is queued and runs in
+// processCommandQueue (controller not initialized, nothing is saved), command batches that fail part way are rolled back
+#include "application.h"
+#include "LoggerController.h"
+#include "ChemglassScaleLoggerComponent.h"
+#include "LoggerStream.h"
+#include "test.h"
+
+LoggerControllerState controller_state(false, false, false, 3600, LOG_BY_TIME, 2000, 5000);
+LoggerDisplay lcd;
+LoggerController controller("test 0.1", A5, &lcd, &controller_state);
+ScaleState scale_state(CALC_RATE_OFF);
+ChemglassScaleLoggerComponent scale("scale", &controller, &scale_state);
+
+static int receive(const char* text) {
+  String command(text);
+  return(controller.receiveCommand(command));
+}
+
+int main() {
+  controller.addComponent(&scale);
+
+  // unknown commands
+  CHECK(receive("") == CMD_RET_ERR_CMD);
+  CHECK(receive("   ") == CMD_RET_ERR_CMD);
+  CHECK(receive("bogus") == CMD_RET_ERR_CMD);
+  CHECK(receive(" help") == CMD_RET_ERR_CMD); // leading space = empty first token (same as when it runs)
+  CHECK(receive("help-me") == CMD_RET_ERR_CMD);
+  CHECK(receive("averyveryverylongvariablenamethatexceedsthevariablebuffer") == CMD_RET_ERR_CMD);
+  CHECK(receive(";;") == CMD_RET_ERR_CMD);
+  CHECK(receive("help; bogus") == CMD_RET_ERR_CMD);
+  CHECK(controller.checkCommand("help") == CMD_RET_SUCCESS);
+
+  // registered commands (controller and component)
+  CHECK(receive("help") == CMD_RET_QUEUED);
+  CHECK(receive("calc-rate m") == CMD_RET_QUEUED);
+  CHECK(receive(" help ;mem; ") == CMD_RET_QUEUED);
+  CHECK(receive("log-period 0 x") == CMD_RET_QUEUED); // values are only checked when the command runs
+  CHECK(receive("mem") == CMD_RET_ERR_QUEUE_FULL);
+  controller.processCommandQueue();
+  CHECK(receive("mem") == CMD_RET_QUEUED);
+  controller.processCommandQueue();
+
+  // locked
+  controller_state.locked = true;
+  CHECK(receive("data-log on") == CMD_RET_ERR_LOCKED);
+  CHECK(receive("help") == CMD_RET_ERR_LOCKED);
+  CHECK(receive("data-log on; lock off") == CMD_RET_ERR_LOCKED);
+  CHECK(receive("bogus") == CMD_RET_ERR_CMD);
+  CHECK(receive("lock off") == CMD_RET_QUEUED);
+  CHECK(receive("lock off; data-log on") == CMD_RET_QUEUED);
+  controller.processCommandQueue();
+  CHECK(!controller_state.locked);
+  CHECK(controller_state.data_logging);
+
+  // queued lock commands count for the commands received after them (before the queue has run)
+  controller_state.locked = true;
+  CHECK(receive("lock off") == CMD_RET_QUEUED);
+  CHECK(receive("data-log off") == CMD_RET_QUEUED);
+  CHECK(receive("lock on") == CMD_RET_QUEUED);
+  CHECK(receive("help") == CMD_RET_ERR_LOCKED);
+  controller.processCommandQueue();
+  CHECK(controller_state.locked);
+  CHECK(!controller_state.data_logging);
+  CHECK(receive("lock") == CMD_RET_QUEUED); // no value --> stays locked
+  CHECK(receive("help") == CMD_RET_ERR_LOCKED);
+  controller.processCommandQueue();
+  controller_state.locked = false; // e.g. unlocked on the device
+  CHECK(receive("help") == CMD_RET_QUEUED); // empty queue --> current lock state
+  controller.processCommandQueue();
+
+  // a batch that fails part way is rolled back (states, stream, pending restart), "reset data" only runs if all succeed
+  CHECK(!controller_state.data_logging && !isStreaming());
+  CHECK(scale_state.calc_rate == CALC_RATE_MIN);
+  uint period = controller_state.data_logging_period;
+  CHECK(controller.executeCommand("data-log on; calc-rate s; stream on; restart; log-period 0 x") == CMD_RET_ERR_VAL);
+  CHECK(!controller_state.data_logging);
+  CHECK(controller_state.data_logging_period == period);
+  CHECK(scale_state.calc_rate == CALC_RATE_MIN);
+  CHECK(!isStreaming());
+  CHECK(controller.executeCommand("read-period scale 3 s; log-period 0 x") == CMD_RET_ERR_VAL);
+  CHECK(!scale.hasOwnDataReadPeriod());
+  scale.data[0].setNewestValue(1.0);
+  scale.data[0].saveNewestValue(true);
+  CHECK(controller.executeCommand("reset data; calc-rate x") < 0);
+  CHECK(scale.data[0].getN() == 1);
+  CHECK(controller.executeCommand("reset data; calc-rate s") == CMD_RET_SUCCESS);
+  CHECK(scale.data[0].getN() == 0);
+  CHECK(scale_state.calc_rate == CALC_RATE_SEC);
+
+  return(TEST_RESULT());
+}
@@ -0,0 +1,140 @@
+// tests of the data statistics (LoggerData.h): compact layout, exact mean data times relative to the newest data time
+// (also across the 32 bit millis() overflow and for persistent data), retained accumulators, interned units
+#include "application.h"
+#include "LoggerData.h"
+#include "LoggerClock.h"
+#include "test.h"
+
+// reproducible pseudo random numbers (independent of the libc rand implementation)
+static uint32_t random_state = 1;
+static uint32_t nextRandom() {
+  random_state = random_state * 1664525UL + 1013904223UL;
+  return(random_state >> 8);
+}
+
+// mean data times are exact (rounded to the nearest ms)
+static void testDataTime() {
+  host_millis = 0xFFFFFFFFUL - 500000UL; // millis() overflows during the series
+  int mismatches = 0;
+  for (int series = 0; series < 200; series++) {
+    LoggerData data(1, "x");
+    int n = 1 + nextRandom() % 2000;
+    uint64_t first = millis64(), sum = 0;
+    for (int i = 0; i < n; i++) {
+      uint64_t t = millis64();
+      data.setNewestDataTime(t);
+      data.setNewestValue(1.0);
+      data.saveNewestValue(true);
+      sum += t - first;
+      host_millis += 1 + nextRandom() % 2000;
+    }
+    if (data.getN() != n || data.getDataTime() != first + (sum + n / 2) / n) mismatches++;
+  }
+  CHECK(mismatches == 0);
+
+  // time stamps that are not in order (e.g. a derived value logged 1 ms before the newest one)
+  LoggerData data(1, "x");
+  uint64_t now = millis64();
+  data.setNewestDataTime(now - 10);
+  data.setNewestValue(1.0);
+  data.saveNewestValue(true);
+  data.setNewestDataTime(now - 20);
+  data.setNewestValue(2.0);
+  data.saveNewestValue(true);
+  data.setNewestDataTime(now - 1);
+  data.setNewestValue(3.0);
+  data.saveNewestValue(true);
+  CHECK(data.getDataTime() == now - 10);
+  CHECK(data.getNewestDataTime() == now - 1);
+  CHECK_CLOSE(data.getValue(), 2.0, 1e-12);
+
+  // not averaging --> only the last value and its time
+  data.setNewestDataTime(now);
+  data.setNewestValue(5.0);
+  data.saveNewestValue(false);
+  CHECK(data.getN() == 1 && data.getDataTime() == now);
+
+  // persistent data keep their statistics (and mean time) across clears, also a month later
+  data.makePersistent();
+  data.clear();
+  host_millis += 30UL * 86400000UL;
+  CHECK(data.getN() == 1 && data.getDataTime() == now);
+  CHECK(data.getNewestDataTime() == now);
+}
+
+// derived values (e.g. a rate from two averages) keep their data time
+static void testSetValueStats() {
+  LoggerData rate(2, "rate");
+  uint64_t t = millis64() - 5000;
+  rate.setNewestDataTime(t);
+  rate.setNewestValue(0.5);
+  rate.saveNewestValue(false);
+  rate.setValueStats(240, 0.5, 0.01);
+  CHECK(rate.getN() == 240);
+  CHECK(rate.getDataTime() == t);
+  CHECK_CLOSE(rate.getValue(), 0.5, 1e-12);
+  CHECK_CLOSE(rate.getVariance(), 0.01, 1e-12);
+
+  // scaled statistics
+  LoggerData weight(1, "weight");
+  weight.setScaledStats(2);
+  for (int i = 0; i < 100; i++) {
+    weight.setNewestDataTime(millis64());
+    weight.setNewestValue((i % 2 == 0) ? 10.0 : 10.2);
+    weight.saveNewestValue(true);
+  }
+  CHECK(weight.getN() == 100);
+  CHECK_CLOSE(weight.getValue(), 10.1, 1e-9);
+  CHECK_CLOSE(weight.getStdDev(), sqrt(0.01 * 100 / 99), 1e-9);
+}
+
+// retained accumulators continue on the time line after a reset
+static void testRetained() {
+  LoggerData data(1, "x");
+  data.setScaledStats(3);
+  uint64_t start = millis64();
+  for (int i = 0; i < 10; i++) {
+    data.setNewestDataTime(millis64());
+    data.setNewestValue(1.5 + i * 0.001);
+    data.saveNewestValue(true);
+    host_millis += 1000;
+  }
+  uint64_t mean_time = data.getDataTime();
+  CHECK(mean_time == start + 4500);
+  uint8_t buffer[LOGGER_DATA_RETAINED_SIZE];
+  data.retain(buffer);
+
+  // restart: the old time line is 1 h ahead of the new one
+  LoggerData restored(1, "x");
+  restored.setScaledStats(3);
+  restored.restoreRetained(buffer, -3600000LL);
+  CHECK(restored.getN() == 10);
+  CHECK_CLOSE(restored.getValue(), data.getValue(), 1e-12);
+  CHECK_CLOSE(restored.getStdDev(), data.getStdDev(), 1e-12);
+  CHECK(restored.getDataTime() == mean_time - 3600000ULL);
+}
+
+// units are shared offsets into the units table
+static void testUnits() {
+  LoggerData a(1, "a", "g"), b(2, "b", "g"), c(3, "c");
+  CHECK(strcmp(a.getUnits(), "g") == 0);
+  CHECK(a.getUnits() == b.getUnits());
+  CHECK(strcmp(c.getUnits(), "") == 0);
+  c.setUnits("g/min");
+  CHECK(c.isUnitsIdentical("g/min"));
+  LoggerData::json[0] = 0;
+  c.setNewestValue(1.25);
+  c.setDecimals(2);
+  c.assembleInfo();
+  CHECK(strstr(LoggerData::json, "\"u\":\"g/min\"") != NULL);
+}
+
+int main() {
+  printf("INFO: LoggerData is %zu bytes on the host (%zu on the Photon)\n", sizeof(LoggerData), LOGGER_DATA_DEVICE_SIZE);
+  CHECK(LOGGER_DATA_DEVICE_SIZE == 56);
+  testDataTime();
+  testSetValueStats();
+  testRetained();
+  testUnits();
+  return(TEST_RESULT());
+}
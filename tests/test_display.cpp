@@ -0,0 +1,176 @@
+// tests of the burst I2C lcd driver (LoggerDisplayI2C.h) on the host Wire shim: the PCF8574 backpack output is decoded
+// back into the HD44780 display memory (4 bit interface, nibbles latched on the falling enable edge) and the I2C
+// traffic is compared with the transport of the LiquidCrystal_I2C library (3 single byte transactions per nibble)
+#include "application.h"
+#include "LoggerDisplayI2C.h"
+#include "test.h"
+
+#define LCD_ADDR  0x27
+#define LCD_COLS  20
+#define LCD_LINES 4
+
+/*** HD44780 behind the backpack ***/
+
+struct HostLCD {
+  bool four_bit = false;
+  bool high_nibble = true; // next nibble in 4 bit mode is the upper one
+  uint8_t value = 0, rs = 0;
+  uint8_t last = 0; // last output of the backpack
+  uint8_t address = 0;
+  char ddram[128];
+  int instructions = 0, characters = 0;
+  bool backlight_always = true, backlight_never = true;
+
+  HostLCD() { memset(ddram, ' ', sizeof(ddram)); }
+
+  void execute(uint8_t byte, uint8_t mode) {
+    if (mode) {
+      ddram[address & 0x7f] = (char) byte;
+      address++;
+      characters++;
+      return;
+    }
+    instructions++;
+    if (byte & 0x80) address = byte & 0x7f;
+    else if (byte & 0x20) four_bit = !(byte & 0x10);
+    else if (byte == LCD_I2C_CMD_CLEAR) {
+      memset(ddram, ' ', sizeof(ddram));
+      address = 0;
+    }
+  }
+
+  void output(uint8_t out) {
+    if (out & LCD_I2C_BACKLIGHT) backlight_never = false;
+    else backlight_always = false;
+    // falling enable edge --> the lcd reads the data lines of the previous output
+    if ((last & LCD_I2C_EN) && !(out & LCD_I2C_EN)) {
+      uint8_t nibble = last & 0xf0, mode = last & LCD_I2C_RS;
+      if (!four_bit) {
+        execute(nibble, mode); // 8 bit mode during init: lower data lines are not connected
+      } else if (high_nibble) {
+        value = nibble;
+        rs = mode;
+        high_nibble = false;
+      } else {
+        execute(value | (nibble >> 4), rs);
+        high_nibble = true;
+      }
+    }
+    last = out;
+  }
+
+  // decode all I2C transactions recorded by the Wire shim since the last call
+  void decode() {
+    for (size_t i = 0; i < Wire.transactions.size(); i++) {
+      for (size_t j = 0; j < Wire.transactions[i].data.size(); j++) output(Wire.transactions[i].data[j]);
+    }
+    Wire.transactions.clear();
+  }
+
+  char at(uint8_t col, uint8_t row) {
+    const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+    return(ddram[row_offsets[row] + col]);
+  }
+};
+
+/*** tests ***/
+
+// reproducible pseudo random numbers (independent of the libc rand implementation)
+static uint32_t random_state = 1;
+static uint32_t nextRandom() {
+  random_state = random_state * 1664525UL + 1013904223UL;
+  return(random_state >> 8);
+}
+
+// random full screen redraws decode to the same screen with at most LCD_I2C_BURST_MAX bytes per transaction
+static void testRedraws() {
+  Wire.transactions.clear();
+  HostLCD host;
+  LoggerDisplayI2C lcd(LCD_ADDR, LCD_COLS, LCD_LINES);
+  lcd.init();
+  host.decode();
+  CHECK(host.four_bit);
+  CHECK(host.high_nibble);
+
+  const int redraws = 100;
+  int mismatches = 0, too_long = 0, wrong_address = 0;
+  unsigned long transactions = 0, bytes = 0;
+  char screen[LCD_LINES][LCD_COLS + 1];
+  for (int i = 0; i < redraws; i++) {
+    unsigned long start_transactions = lcd.getTransactions(), start_bytes = lcd.getBytes();
+    for (int row = 0; row < LCD_LINES; row++) {
+      for (int col = 0; col < LCD_COLS; col++) screen[row][col] = (char) (' ' + nextRandom() % 95);
+      screen[row][LCD_COLS] = 0;
+      lcd.setCursor(0, row);
+      lcd.print(screen[row]);
+    }
+    transactions += lcd.getTransactions() - start_transactions;
+    bytes += lcd.getBytes() - start_bytes;
+    for (size_t t = 0; t < Wire.transactions.size(); t++) {
+      if (Wire.transactions[t].data.size() > LCD_I2C_BURST_MAX) too_long++;
+      if (Wire.transactions[t].address != LCD_ADDR) wrong_address++;
+    }
+    host.decode();
+    for (int row = 0; row < LCD_LINES; row++) {
+      for (int col = 0; col < LCD_COLS; col++) if (host.at(col, row) != screen[row][col]) mismatches++;
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(too_long == 0);
+  CHECK(wrong_address == 0);
+  CHECK(host.backlight_always);
+
+  // LiquidCrystal_I2C: each nibble is expanderWrite + pulseEnable (high, low) = 3 transactions of address + 1 byte
+  unsigned long library_transactions = (unsigned long) redraws * LCD_LINES * (LCD_COLS + 1) * 2 * 3;
+  unsigned long library_bytes = 2 * library_transactions;
+  printf("INFO: %dx%d redraw: %lu I2C transactions / %lu bytes (~%lu ms at 100 kHz) vs %lu / %lu (~%lu ms) with the library\n",
+    LCD_COLS, LCD_LINES, transactions / redraws, bytes / redraws, bytes * 9 / 100 / redraws,
+    library_transactions / redraws, library_bytes / redraws, library_bytes * 9 / 100 / redraws);
+  // 4 bytes per character + register select changes, split into bursts of LCD_I2C_BURST_MAX bytes
+  CHECK(transactions / redraws <= 12);
+  CHECK(bytes / redraws <= 360);
+  CHECK(bytes * 2 < library_bytes);
+  CHECK(host.instructions > 0 && host.characters == redraws * LCD_LINES * LCD_COLS);
+}
+
+// backlight switches send a single byte, clear and init reset the display memory
+static void testBacklightAndClear() {
+  Wire.transactions.clear();
+  HostLCD host;
+  LoggerDisplayI2C lcd(LCD_ADDR, 16, 2);
+  lcd.init();
+  lcd.setCursor(3, 1);
+  lcd.print("abc");
+  host.decode();
+  CHECK(host.at(3, 1) == 'a' && host.at(5, 1) == 'c');
+
+  // rows beyond the display go to the last row
+  lcd.setCursor(0, 3);
+  lcd.print("x");
+  host.decode();
+  CHECK(host.at(0, 1) == 'x');
+
+  unsigned long transactions = lcd.getTransactions();
+  lcd.noBacklight();
+  CHECK(lcd.getTransactions() == transactions + 1);
+  CHECK(Wire.transactions.size() == 1 && Wire.transactions[0].data.size() == 1);
+  CHECK(!(Wire.transactions[0].data[0] & LCD_I2C_BACKLIGHT));
+  lcd.print("d");
+  host.backlight_never = true;
+  host.decode();
+  CHECK(host.backlight_never);
+  lcd.backlight();
+  CHECK(Wire.transactions.size() == 1 && (Wire.transactions[0].data[0] & LCD_I2C_BACKLIGHT));
+  host.decode();
+
+  lcd.clear();
+  host.decode();
+  CHECK(host.at(3, 1) == ' ' && host.at(0, 1) == ' ');
+  CHECK(host.address == 0);
+}
+
+int main() {
+  testRedraws();
+  testBacklightAndClear();
+  return(TEST_RESULT());
+}
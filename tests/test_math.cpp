@@ -0,0 +1,88 @@
+// statistics in LoggerMath.h: scaled integer statistics vs the double precision reference
+#include "application.h"
+#include "LoggerMath.h"
+#include "test.h"
+
+// reproducible pseudo random numbers (independent of the libc rand implementation)
+static uint32_t random_state = 1;
+static uint32_t nextRandom() {
+  random_state = random_state * 1664525UL + 1013904223UL;
+  return(random_state >> 8);
+}
+
+// value with the given decimals (as reported by an instrument)
+static double randomValue(double base, double spread, int decimals) {
+  double x = base + spread * ((double) (nextRandom() % 20001) / 10000.0 - 1.0);
+  return(round_to_decimals(x, decimals));
+}
+
+// scaled statistics agree with the double precision statistics for values with a fixed number of decimals
+static void testScaledAgreement(int decimals) {
+  double max_mean_diff = 0.0;
+  double max_sd_diff = 0.0;
+  for (int series = 0; series < 1000; series++) {
+    RunningStats reference;
+    ScaledRunningStats scaled(decimals);
+    double base = (nextRandom() % 200000) / 100.0;
+    int n = 1 + nextRandom() % 2000;
+    for (int i = 0; i < n; i++) {
+      double x = randomValue(base, 10.0, decimals);
+      reference.add(x);
+      scaled.add(x);
+    }
+    CHECK(scaled.getN() == reference.getN());
+    double mean_diff = fabs(scaled.getMean() - reference.getMean());
+    double sd_diff = fabs(scaled.getStdDev() - reference.getStdDev()) / (reference.getStdDev() + 1e-12);
+    if (mean_diff > max_mean_diff) max_mean_diff = mean_diff;
+    if (sd_diff > max_sd_diff) max_sd_diff = sd_diff;
+  }
+  printf("INFO: %d decimals: max mean difference %g, max relative sd difference %g\n", decimals, max_mean_diff, max_sd_diff);
+  CHECK(max_mean_diff < 1e-9);
+  CHECK(max_sd_diff < 1e-9);
+}
+
+// a slow drift over a long averaging period (sum of scaled deviations beyond the 32 bit range)
+static void testScaledDrift() {
+  RunningStats reference;
+  ScaledRunningStats scaled(4);
+  // 1 read/s for an hour, drifting 200g away from the first value
+  for (int i = 0; i < 3600; i++) {
+    double x = round_to_decimals(100.0 + 200.0 * i / 3600.0, 4);
+    reference.add(x);
+    scaled.add(x);
+  }
+  CHECK(fabs((double) scaled.sums.sum) > 2147483647.0);
+  CHECK_CLOSE(scaled.getMean(), reference.getMean(), 1e-9);
+  CHECK_CLOSE(scaled.getStdDev(), reference.getStdDev(), 1e-6);
+}
+
+// derived values set directly
+static void testScaledSet() {
+  ScaledRunningStats scaled(2);
+  scaled.set(10, 12.34, 0.25);
+  CHECK(scaled.getN() == 10);
+  CHECK_CLOSE(scaled.getMean(), 12.34, 1e-12);
+  CHECK_CLOSE(scaled.getVariance(), 0.25, 1e-12);
+  scaled.clear();
+  CHECK(scaled.getN() == 0);
+  CHECK_CLOSE(scaled.getMean(), 0.0, 0.0);
+}
+
+// counts beyond 2^24 (10 reads/s for 20 days)
+static void testScaledCount() {
+  ScaledRunningStats scaled(1);
+  const int n = 17280000;
+  for (int i = 0; i < n; i++) scaled.add((i % 2 == 0) ? 10.0 : 10.2);
+  CHECK(scaled.getN() == n);
+  CHECK_CLOSE(scaled.getMean(), 10.1, 1e-9);
+  CHECK_CLOSE(scaled.getStdDev(), 0.1, 1e-6);
+}
+
+int main() {
+  testScaledAgreement(2);
+  testScaledAgreement(4);
+  testScaledDrift();
+  testScaledSet();
+  testScaledCount();
+  return(TEST_RESULT());
+}
@@ -0,0 +1,315 @@
+// tests of the data read state machine (DataReaderLoggerComponent.h) with a simulated instrument on the host clock:
+//  - latency: a response is finalized and the next due request goes out in the loop pass that sees the response
+//    (also when the loop pass comes after the read timeout)
+//  - read policy: retries and backoff with a dead, recovered and flapping instrument
+//  - cadence: requests stay on the read period grid with irregular loop passes and stalls (skip / catch up)
+#include "application.h"
+#include "LoggerController.h"
+#include "DataReaderLoggerComponent.h"
+#include "test.h"
+
+LoggerControllerState controller_state(false, false, false, 3600, LOG_BY_TIME, 1000, 5000);
+LoggerDisplay lcd;
+LoggerController controller("test 0.1", A5, &lcd, &controller_state);
+
+/*** simulated instrument ***/
+
+// answers each request after a fixed latency (unless dead, or every other request if flapping)
+class TestInstrument : public DataReaderLoggerComponent {
+
+  public:
+
+    unsigned long latency = 30;
+    bool dead = false, flapping = false;
+    unsigned long flaps = 0;
+    std::vector<unsigned long> responses; // when the responses to the outstanding requests arrive
+    std::vector<unsigned long> requests, completes; // when requests went out / reads completed
+
+    TestInstrument() : DataReaderLoggerComponent("instrument", &controller, true) {}
+
+    void sendDataRequest() {
+      requests.push_back(millis());
+      if (dead || (flapping && flaps++ % 2 == 0)) return;
+      responses.push_back(millis() + latency);
+    }
+
+    void readData() {
+      if (!responses.empty() && (long) (millis() - responses.front()) >= 0) {
+        responses.erase(responses.begin());
+        startData();
+        data_read_status = DATA_READ_COMPLETE;
+      }
+    }
+
+    void completeDataRead() {
+      completes.push_back(millis());
+      DataReaderLoggerComponent::completeDataRead();
+    }
+
+    void handleDataReadTimeout() {
+      DataReaderLoggerComponent::handleDataReadTimeout();
+      // late response to the abandoned request is not matched to the next one
+      if (!responses.empty()) responses.erase(responses.begin());
+    }
+
+    DataReadJitter* getStartJitter() {
+      return(&read_start_jitter);
+    }
+
+    unsigned long getBackoff() {
+      return(read_backoff);
+    }
+
+    // mean time from request to completed read (in ms)
+    double getMeanLatency() {
+      double sum = 0;
+      for (size_t i = 0; i < completes.size(); i++) sum += completes[i] - requests[i];
+      return((completes.empty()) ? 0 : sum / completes.size());
+    }
+
+    // mean time between requests (in ms)
+    double getMeanInterval() {
+      return((requests.size() < 2) ? 0 : (double) (requests.back() - requests.front()) / (requests.size() - 1));
+    }
+
+};
+
+// loop passes of pass ms for duration ms
+static void runReader(TestInstrument* instrument, unsigned long pass, unsigned long duration) {
+  unsigned long start = millis();
+  while (millis() - start < duration) {
+    instrument->update();
+    host_millis += pass;
+  }
+}
+
+/*** latency ***/
+
+// 10 ms loop passes, 30 ms instrument latency, 200 ms read period: the read completes in the pass that sees the response
+static void testLatency() {
+  controller_state.data_reading_period = 200;
+  TestInstrument instrument;
+  instrument.latency = 30;
+  runReader(&instrument, 10, 600000);
+  printf("INFO: 30 ms instrument, 10 ms loop passes: %.1f ms from request to complete\n", instrument.getMeanLatency());
+  CHECK(instrument.completes.size() >= 2999);
+  CHECK_CLOSE(instrument.getMeanLatency(), 30.0, 0.01);
+  CHECK(instrument.getDataReadStats()->timeouts == 0);
+}
+
+// 95 ms instrument latency with a 100 ms read period: the next request goes out in the pass that completes the read
+static void testBackToBack() {
+  controller_state.data_reading_period = 100;
+  TestInstrument instrument;
+  instrument.latency = 95;
+  runReader(&instrument, 10, 600000);
+  double rate = 1000.0 * instrument.completes.size() / 600000;
+  printf("INFO: 95 ms instrument, 100 ms period, 10 ms loop passes: %.1f ms between requests, %.2f reads/s\n",
+    instrument.getMeanInterval(), rate);
+  // response is seen at the latest one pass after it arrived, the next request goes out in that same pass
+  CHECK(instrument.getMeanInterval() <= 110.0);
+  CHECK(rate >= 9.0);
+  CHECK(instrument.getDataReadStats()->timeouts == 0);
+}
+
+// 5 ms instrument latency with a 1 ms read period (default timeout 1 ms, shorter than a loop pass):
+// responses that are in when the loop gets to them are not timed out, one read per loop pass
+static void testShortPeriod() {
+  controller_state.data_reading_period = 1;
+  TestInstrument instrument;
+  instrument.latency = 5;
+  runReader(&instrument, 10, 60000);
+  printf("INFO: 5 ms instrument, 1 ms period, 10 ms loop passes: %.1f reads/s, %lu timeouts\n",
+    instrument.completes.size() / 60.0, instrument.getDataReadStats()->timeouts);
+  CHECK(instrument.completes.size() >= 5999);
+  CHECK(instrument.getDataReadStats()->timeouts == 0);
+}
+
+// a full read cycle fits into a single update (state machine runs to quiescence)
+static void testQuiescence() {
+  controller_state.data_reading_period = 200;
+  TestInstrument instrument;
+  instrument.latency = 0;
+  instrument.update();
+  CHECK(instrument.requests.size() == 1);
+  CHECK(instrument.completes.size() == 1);
+  host_millis += 200;
+  instrument.update();
+  CHECK(instrument.requests.size() == 2);
+  CHECK(instrument.completes.size() == 2);
+}
+
+/*** read policy ***/
+
+// requests in the time window [from, to) ms after start
+static size_t countRequests(TestInstrument* instrument, unsigned long from, unsigned long to) {
+  size_t n = 0;
+  for (size_t i = 0; i < instrument->requests.size(); i++) {
+    if (instrument->requests[i] >= from && instrument->requests[i] < to) n++;
+  }
+  return(n);
+}
+
+// 1 s reader with a 200 ms timeout, 1 retry and 1-16 s backoff
+static void testBackoff() {
+  controller_state.data_reading_period = 1000;
+  TestInstrument instrument;
+  instrument.setDataReadTimeout(200);
+  instrument.setDataReadRetries(1);
+  instrument.setDataReadBackoff(1000, 16000);
+  unsigned long start = millis();
+
+  // healthy: full rate
+  runReader(&instrument, 10, 10000);
+  CHECK(countRequests(&instrument, start, start + 10000) == 10);
+  CHECK(instrument.getBackoff() == 0);
+
+  // dead for 60 s: each failed read and its retry double the backoff up to the maximum (one read + retry per 17 s)
+  instrument.dead = true;
+  runReader(&instrument, 10, 60000);
+  size_t dead_requests = countRequests(&instrument, start + 36000, start + 70000);
+  printf("INFO: dead instrument: %zu requests in the last 34 s, backoff %lu ms\n", dead_requests, instrument.getBackoff());
+  CHECK(instrument.getBackoff() == 16000);
+  CHECK(dead_requests <= 4);
+  CHECK(instrument.getDataReadStats()->timeouts >= 8);
+
+  // recovered: backoff halves every 2 successful reads (the first read can still be 17 s out)
+  instrument.dead = false;
+  instrument.responses.clear();
+  unsigned long recovered = millis();
+  while (instrument.getBackoff() > 0 && millis() - recovered < 120000) runReader(&instrument, 10, 10);
+  unsigned long recovery = millis() - recovered;
+  runReader(&instrument, 10, 10000);
+  size_t recovered_requests = countRequests(&instrument, millis() - 10000, millis());
+  printf("INFO: recovered instrument: back to the full read rate after %lu s\n", recovery / 1000);
+  CHECK(recovery < 90000);
+  CHECK(recovered_requests >= 9 && recovered_requests <= 11);
+
+  // flapping (every other request unanswered): the retry succeeds but never 2 reads in a row --> stays slowed down
+  instrument.flapping = true;
+  unsigned long timeouts = instrument.getDataReadStats()->timeouts;
+  runReader(&instrument, 10, 120000);
+  size_t flapping_requests = countRequests(&instrument, millis() - 60000, millis());
+  printf("INFO: flapping instrument: %zu requests in the last 60 s, backoff %lu ms\n", flapping_requests, instrument.getBackoff());
+  CHECK(instrument.getBackoff() == 16000);
+  CHECK(flapping_requests <= 8);
+  CHECK(instrument.getDataReadStats()->timeouts > timeouts);
+}
+
+// manual readers wait for the instrument (no timeout unless set) and are not retried
+static void testManualReader() {
+  controller_state.data_reading_period = READ_MANUAL;
+  TestInstrument instrument;
+  instrument.setDataReadRetries(2);
+  runReader(&instrument, 10, 10000);
+  CHECK(instrument.requests.empty());
+  CHECK(instrument.getDataReadStats()->reads == 1);
+  CHECK(instrument.getDataReadStats()->timeouts == 0);
+  // with a timeout set, the manual read gives up after 500 ms (seen one loop pass later) and starts over
+  instrument.setDataReadTimeout(500);
+  runReader(&instrument, 10, 10000);
+  CHECK(instrument.getDataReadStats()->timeouts == 1 + 10000 / 510);
+  CHECK(instrument.requests.empty());
+}
+
+/*** cadence ***/
+
+// reproducible pseudo random numbers (independent of the libc rand implementation)
+static uint32_t random_state = 1;
+static uint32_t nextRandom() {
+  random_state = random_state * 1664525UL + 1013904223UL;
+  return(random_state >> 8);
+}
+
+// 1 h of random 1-20 ms loop passes with a 200 ms read period (and a stall of stall ms every minute)
+// @return requests per second
+static double runCadence(TestInstrument* instrument, unsigned long stall) {
+  controller_state.data_reading_period = 200;
+  random_state = 1;
+  unsigned long start = millis(), last_stall = millis();
+  while (millis() - start < 3600000UL) {
+    instrument->update();
+    host_millis += 1 + nextRandom() % 20;
+    if (stall > 0 && millis() - last_stall >= 60000) {
+      last_stall = millis();
+      host_millis += stall;
+    }
+  }
+  return(1000.0 * instrument->requests.size() / (millis() - start));
+}
+
+static void testCadence() {
+  // irregular loop passes: late requests do not push back the following ones
+  TestInstrument instrument;
+  double rate = runCadence(&instrument, 0);
+  printf("INFO: 200 ms period, 1-20 ms loop passes: %.3f reads/s (nominal %.3f), requests %.1f +/- %.1f ms after their deadline\n",
+    rate, instrument.getNominalDataReadRate(), instrument.getStartJitter()->getMean(), instrument.getStartJitter()->getStdDev());
+  CHECK_CLOSE(rate, 5.0, 0.002);
+  CHECK_CLOSE(instrument.getAchievedDataReadRate(), 5.0, 0.002);
+  CHECK(instrument.getStartJitter()->getMean() < 20.0);
+  CHECK(instrument.getStartJitter()->max < 20);
+
+  // integer jitter sums give the same mean and standard deviation as the floating point running statistics
+  DataReadJitter jitter;
+  RunningStats reference;
+  for (uint32_t i = 0; i < 100000; i++) {
+    uint32_t late = (i % 97 == 0) ? 1500 : (i * 7919) % 23;
+    jitter.add(late);
+    reference.add(late);
+  }
+  CHECK(jitter.n == 100000 && jitter.max == 1500);
+  CHECK_CLOSE(jitter.getMean(), reference.getMean(), 1e-4);
+  CHECK_CLOSE(jitter.getStdDev(), reference.getStdDev(), 1e-3);
+
+  // 1 s stall every minute: skipped deadlines are lost, catching up makes up for them
+  TestInstrument skipping;
+  double skip_rate = runCadence(&skipping, 1000);
+  TestInstrument catching_up;
+  catching_up.setDataReadCadencePolicy(DATA_READ_CATCH_UP);
+  double catch_up_rate = runCadence(&catching_up, 1000);
+  printf("INFO: 1 s stall every minute: %.3f reads/s skipping, %.3f reads/s catching up\n", skip_rate, catch_up_rate);
+  CHECK(skip_rate < 4.95 && skip_rate > 4.9);
+  CHECK(catch_up_rate > skip_rate);
+  CHECK(catch_up_rate > 4.97);
+  CHECK(catching_up.getDataReadStats()->timeouts == 0);
+}
+
+// a changed read period restarts the cadence, readers with the same period are staggered by their phase
+static void testCadenceRestart() {
+  controller_state.data_reading_period = 1000;
+  TestInstrument first, second;
+  first.setDataReadPhase(0, 2);
+  second.setDataReadPhase(1, 2);
+  host_millis = 1000000; // on the grid
+  for (int i = 0; i < 300; i++) {
+    first.update();
+    second.update();
+    host_millis += 10;
+  }
+  CHECK(first.requests.size() == 3 && second.requests.size() == 3);
+  CHECK(first.requests[0] == 1000000 && second.requests[0] == 1000500);
+  CHECK(second.requests[1] - first.requests[1] == 500);
+
+  // new grid of 200 ms from the next multiple of the period (loop passes are 5 ms off the grid)
+  controller_state.data_reading_period = 200;
+  host_millis += 5;
+  size_t n = first.requests.size();
+  runReader(&first, 10, 1000);
+  CHECK(first.requests.size() - n == 4);
+  CHECK(first.requests[n] == 1003205);
+  CHECK(first.requests.back() % 200 == 5);
+  CHECK_CLOSE(first.getNominalDataReadRate(), 5.0, 1e-6);
+}
+
+int main() {
+  host_millis = 1000;
+  testLatency();
+  testBackToBack();
+  testShortPeriod();
+  testQuiescence();
+  testBackoff();
+  testManualReader();
+  testCadence();
+  testCadenceRestart();
+  return(TEST_RESULT());
+}
@@ -0,0 +1,159 @@
+// tests of the serial capture and replay (SerialReaderLoggerComponent.h) with the chemglass scale parser:
+//  - capture: a simulated balance answers the scale's requests on Serial1, the CAPTURE lines are collected
+//  - replay: the captured bytes are fed back into Serial1 at their capture times and read through update(),
+//    and frame by frame through replaySerialData (debug/scale_replay), both give the same data as the capture run
+#include "application.h"
+#include "LoggerController.h"
+#include "ChemglassScaleLoggerComponent.h"
+#include "test.h"
+
+// controller with a 500 ms read period
+LoggerControllerState controller_state(false, false, false, 3600, LOG_BY_TIME, 500, 500);
+LoggerDisplay lcd;
+LoggerController controller("test 0.1", A5, &lcd, &controller_state);
+
+// scales for the capture run, the replay through update() and the frame by frame replay
+ScaleState capture_state(CALC_RATE_OFF), replay_state(CALC_RATE_OFF), frames_state(CALC_RATE_OFF);
+ChemglassScaleLoggerComponent capture_scale("capture", &controller, &capture_state);
+ChemglassScaleLoggerComponent replay_scale("replay", &controller, &replay_state);
+ChemglassScaleLoggerComponent frames_scale("frames", &controller, &frames_state);
+
+// bytes arriving on Serial1 at a given time
+struct SerialEvent {
+  unsigned long time;
+  std::string bytes; // empty = read request (replay only)
+};
+
+// runs the scale's update every 5 ms and puts the bytes on Serial1 once their time has come
+static void run(ChemglassScaleLoggerComponent* scale, std::vector<SerialEvent>* incoming, unsigned long until) {
+  size_t next = 0;
+  while (host_millis < until) {
+    for (; next < incoming->size() && (*incoming)[next].time <= host_millis; next++) Serial1.feed((*incoming)[next].bytes.c_str());
+    scale->update();
+    host_millis += 5;
+  }
+}
+
+// @return the captured bytes and requests from the serial output
+static std::vector<SerialEvent> parseCapture(const std::string& output) {
+  std::vector<SerialEvent> events;
+  size_t start = 0;
+  while (start < output.size()) {
+    size_t end = output.find('\n', start);
+    if (end == std::string::npos) end = output.size();
+    std::string line = output.substr(start, end - start);
+    start = end + 1;
+    unsigned long time;
+    char value[64];
+    if (sscanf(line.c_str(), "CAPTURE: %lu %63s", &time, value) != 2) continue;
+    SerialEvent event = {time, ""};
+    if (strcmp(value, "REQUEST") != 0) {
+      for (size_t i = 0; i + 1 < strlen(value); i += 2) {
+        char hex[3] = {value[i], value[i + 1], 0};
+        event.bytes += (char) strtol(hex, NULL, 16);
+      }
+    }
+    events.push_back(event);
+  }
+  return(events);
+}
+
+int main() {
+  controller.addComponent(&capture_scale);
+  controller.addComponent(&replay_scale);
+  controller.addComponent(&frames_scale);
+  // the controller staggers its readers, the capture and the replay need the same phase
+  capture_scale.setDataReadPhase(0, 1);
+  replay_scale.setDataReadPhase(0, 1);
+  const unsigned long start = 100000;
+  const unsigned long duration = 20000;
+
+  /*** capture ***/
+
+  // the balance answers each request 60 ms later, at 4800 baud (~2 ms per byte, so the frame arrives over several loop passes)
+  capture_scale.captureSerial();
+  host_millis = start;
+  Serial.output.clear();
+  Serial1.output.clear();
+  Serial1.input.clear();
+  int requests = 0, frame_bytes = 0;
+  std::vector<SerialEvent> balance;
+  while (host_millis < start + duration) {
+    if (Serial1.output.find('#') != std::string::npos) {
+      Serial1.output.clear();
+      char frame[20];
+      snprintf(frame, sizeof(frame), "%9.2f  GS\r\n", 100.0 + requests * 0.01);
+      if (requests == 7) frame[4] = 'a'; // corrupted value
+      for (size_t i = 0; i < strlen(frame); i++) balance.push_back({host_millis + 60 + 2 * (unsigned long) i, std::string(1, frame[i])});
+      frame_bytes += strlen(frame);
+      requests++;
+    }
+    size_t next = 0;
+    for (; next < balance.size() && balance[next].time <= host_millis; next++) Serial1.feed(balance[next].bytes.c_str());
+    balance.erase(balance.begin(), balance.begin() + next);
+    capture_scale.update();
+    host_millis += 5;
+  }
+  std::vector<SerialEvent> captured = parseCapture(Serial.output);
+  int request_lines = 0, byte_lines = 0, captured_bytes = 0;
+  for (size_t i = 0; i < captured.size(); i++) {
+    if (captured[i].bytes.empty()) request_lines++;
+    else {
+      byte_lines++;
+      captured_bytes += captured[i].bytes.size();
+    }
+  }
+  printf("INFO: %d requests, %d bytes captured in %d lines (%d lines with one line per byte)\n",
+    requests, captured_bytes, request_lines + byte_lines, request_lines + captured_bytes);
+  CHECK(requests == (int) (duration / 500));
+  CHECK(request_lines == requests);
+  CHECK(captured_bytes + (int) balance.size() + (int) Serial1.input.size() == frame_bytes); // all bytes that arrived
+  CHECK(byte_lines == requests); // one line per read (15 byte frames)
+  const DataReadStats* capture_stats = capture_scale.getDataReadStats();
+  CHECK(capture_stats->completes > 30);
+  CHECK(capture_stats->errors > 0);
+
+  /*** replay through update() ***/
+
+  // same read period and phase --> the requests go out at the captured times and get the captured bytes
+  std::vector<SerialEvent> incoming;
+  for (size_t i = 0; i < captured.size(); i++) if (!captured[i].bytes.empty()) incoming.push_back(captured[i]);
+  host_millis = start;
+  Serial1.input.clear();
+  run(&replay_scale, &incoming, start + duration);
+  const DataReadStats* replay_stats = replay_scale.getDataReadStats();
+  printf("INFO: capture: %lu reads, %lu errors, %d weights (mean %.4f) - replay: %lu reads, %lu errors, %d weights (mean %.4f)\n",
+    capture_stats->completes, capture_stats->errors, capture_scale.data[0].getN(), capture_scale.data[0].getValue(),
+    replay_stats->completes, replay_stats->errors, replay_scale.data[0].getN(), replay_scale.data[0].getValue());
+  CHECK(replay_stats->completes == capture_stats->completes);
+  CHECK(replay_stats->errors == capture_stats->errors);
+  CHECK(replay_scale.data[0].getN() == capture_scale.data[0].getN());
+  CHECK_CLOSE(replay_scale.data[0].getValue(), capture_scale.data[0].getValue(), 1e-9);
+  CHECK(strcmp(replay_scale.data[0].getUnits(), "g") == 0);
+
+  /*** replay frame by frame ***/
+
+  // bytes between two requests are one frame
+  std::string frame;
+  int incomplete = 0;
+  for (size_t i = 0; i <= captured.size(); i++) {
+    if (i == captured.size() || captured[i].bytes.empty()) {
+      if (!frame.empty() && frames_scale.replaySerialData((const byte*) frame.data(), frame.size()) < 0) incomplete++;
+      frame.clear();
+    } else {
+      frame += captured[i].bytes;
+    }
+  }
+  const DataReadStats* frames_stats = frames_scale.getDataReadStats();
+  CHECK(incomplete == 0);
+  CHECK(frames_stats->completes == capture_stats->completes);
+  CHECK(frames_stats->errors == capture_stats->errors);
+  CHECK(frames_scale.data[0].getN() == capture_scale.data[0].getN());
+  CHECK_CLOSE(frames_scale.data[0].getValue(), capture_scale.data[0].getValue(), 1e-9);
+
+  // truncated frame
+  CHECK(frames_scale.replaySerialData((const byte*) "   123.4", 8) == -1);
+  CHECK(frames_stats->completes == capture_stats->completes);
+
+  return(TEST_RESULT());
+}
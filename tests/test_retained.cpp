@@ -0,0 +1,78 @@
+// tests of the retained snapshots (LoggerRetained.h): table driven CRC, two alternating snapshot buffers
+// (a snapshot that is being assembled never touches the newest intact one), layout key
+#include "application.h"
+#include "LoggerRetained.h"
+#include "test.h"
+
+// bitwise CRC-16/CCITT (reference)
+static uint16_t crcBitwise(uint16_t crc, const uint8_t* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    crc ^= (uint16_t) data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return(crc);
+}
+
+static void testCRC() {
+  const char* check = "123456789";
+  CHECK(calculateRetainedCRC(0xffff, (const uint8_t*) check, strlen(check)) == 0x29b1);
+  uint8_t data[RETAINED_SIZE];
+  for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t) (i * 37 + (i >> 3));
+  CHECK(calculateRetainedCRC(0xffff, data, sizeof(data)) == crcBitwise(0xffff, data, sizeof(data)));
+  // in pieces
+  uint16_t crc = calculateRetainedCRC(0xffff, data, 100);
+  CHECK(calculateRetainedCRC(crc, data + 100, sizeof(data) - 100) == crcBitwise(0xffff, data, sizeof(data)));
+}
+
+static void testSnapshots() {
+  clearRetained();
+  CHECK(checkRetained(1) == 0);
+  CHECK(getRetainedSnapshot() == NULL);
+
+  // first snapshot
+  uint8_t* buffer = getRetainedBuffer();
+  memset(buffer, 0xa1, 100);
+  commitRetained(1, 100);
+  CHECK(checkRetained(1) == 100);
+  CHECK(checkRetained(2) == 0); // different layout
+  CHECK(getRetainedSnapshot() == buffer);
+  CHECK(!isRetainedDirty());
+
+  // the next snapshot goes to the other buffer, the newest one stays intact while it is assembled
+  int mismatches = 0;
+  for (int i = 0; i < 10; i++) {
+    const uint8_t* previous = getRetainedSnapshot();
+    uint8_t* next = getRetainedBuffer();
+    CHECK(next != previous);
+    memset(next, 0xee, RETAINED_SIZE); // e.g. reset before the commit
+    if (previous[0] != (uint8_t) (0xa1 + i) || checkRetained(1) != (size_t) (100 + i - (i > 0 ? 1 : 0))) mismatches++;
+    memset(next, 0xa2 + i, 100 + i);
+    markRetainedDirty();
+    commitRetained(1, 100 + i);
+    CHECK(!isRetainedDirty());
+    if (getRetainedSnapshot() != next || getRetainedSnapshot()[0] != (uint8_t) (0xa2 + i)) mismatches++;
+  }
+  CHECK(mismatches == 0);
+
+  // too large --> not committed
+  const uint8_t* newest = getRetainedSnapshot();
+  commitRetained(1, RETAINED_SIZE + 1);
+  CHECK(getRetainedSnapshot() == newest);
+
+  clearRetained();
+  CHECK(checkRetained(1) == 0);
+}
+
+static void testLayout() {
+  uint32_t a = hashRetainedLayout(hashRetainedLayout(RETAINED_LAYOUT_SEED, "ab"), "c");
+  uint32_t b = hashRetainedLayout(hashRetainedLayout(RETAINED_LAYOUT_SEED, "a"), "bc");
+  CHECK(a != b);
+  CHECK(hashRetainedLayout(RETAINED_LAYOUT_SEED, (uint32_t) 3) != hashRetainedLayout(RETAINED_LAYOUT_SEED, (uint32_t) 4));
+}
+
+int main() {
+  testCRC();
+  testSnapshots();
+  testLayout();
+  return(TEST_RESULT());
+}
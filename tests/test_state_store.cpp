@@ -0,0 +1,177 @@
+// tests of the journaled state store (LoggerStateStore.h) on the host EEPROM (wear counts, simulated power cuts)
+// and of the import of states saved by older firmware (LoggerController::importLegacyState)
+#include "application.h"
+#include "LoggerController.h"
+#include "ChemglassScaleLoggerComponent.h"
+#include "test.h"
+
+struct TestState {
+  uint32_t counter;
+  uint8_t payload[20];
+};
+
+static TestState makeState(uint32_t counter) {
+  TestState state;
+  state.counter = counter;
+  for (size_t i = 0; i < sizeof(state.payload); i++) state.payload[i] = (uint8_t) (counter * 31 + i);
+  return(state);
+}
+
+// @return the counter of the loaded state (0 if there is none or it is not a consistent state)
+static uint32_t loadCounter(LoggerStateStore* store, uint16_t key) {
+  uint8_t version;
+  size_t size;
+  const uint8_t* data = store->load(key, &version, &size);
+  if (data == NULL || version != 1 || size != sizeof(TestState)) return(0);
+  TestState state;
+  memcpy(&state, data, sizeof(state));
+  TestState expected = makeState(state.counter);
+  return((memcmp(&state, &expected, sizeof(state)) == 0) ? state.counter : 0);
+}
+
+// a year of daily state changes for three records with random power cuts while saving
+static void testWearAndPowerCuts() {
+  EEPROM.clear();
+  const uint16_t keys[] = {LoggerStateStore::getKey("controller"), LoggerStateStore::getKey("scale"), LoggerStateStore::getKey("stepper")};
+  const int keys_n = sizeof(keys) / sizeof(keys[0]);
+  uint32_t saved[keys_n] = {0, 0, 0}; // last counter that was saved completely
+  int power_cuts = 0, restored = 0, lost = 0;
+  LoggerStateStore* store = new LoggerStateStore();
+  store->begin();
+  srand(2);
+  for (uint32_t counter = 1; counter <= 36500; counter++) {
+    int k = counter % keys_n;
+    TestState state = makeState(counter);
+    bool cut = (rand() % 500 == 0);
+    if (cut) EEPROM.fail_after = rand() % 40; // power goes out somewhere during the save (or a compaction)
+    store->save(keys[k], 1, &state, sizeof(state));
+    if (cut) {
+      // restart
+      power_cuts++;
+      EEPROM.fail_after = -1;
+      delete store;
+      store = new LoggerStateStore();
+      store->begin();
+      for (int i = 0; i < keys_n; i++) {
+        uint32_t loaded = loadCounter(store, keys[i]);
+        // either the interrupted save made it or the previous state is still there
+        if (loaded == saved[i] || (i == k && loaded == counter)) restored++;
+        else lost++;
+        saved[i] = loaded;
+      }
+    } else {
+      saved[k] = counter;
+    }
+  }
+  for (int i = 0; i < keys_n; i++) CHECK(loadCounter(store, keys[i]) == saved[i]);
+  unsigned long max_writes = 0;
+  for (int i = 0; i < HOST_EEPROM_SIZE; i++) if (EEPROM.writes[i] > max_writes) max_writes = EEPROM.writes[i];
+  printf("INFO: 36500 saves with %d power cuts: %d records restored, %d lost, %lu compactions since the last restart, max %lu writes per byte\n",
+    power_cuts, restored, lost, store->getCompactions(), max_writes);
+  CHECK(power_cuts > 0);
+  CHECK(lost == 0);
+  // in place (old layout), the hottest byte would see every save of its record (~12,000)
+  CHECK(max_writes < 2500);
+  delete store;
+}
+
+// a corrupted record in the middle of the bank does not hide the records after it
+static void testCorruptedRecord() {
+  EEPROM.clear();
+  LoggerStateStore store;
+  store.begin();
+  TestState a1 = makeState(1), b1 = makeState(2), a2 = makeState(3), c1 = makeState(4);
+  store.save(1, 1, &a1, sizeof(a1));
+  store.save(2, 1, &b1, sizeof(b1));
+  store.save(1, 1, &a2, sizeof(a2));
+  store.save(3, 1, &c1, sizeof(c1));
+
+  // flip a data byte of the record of key 2 (second bank, records of 6 + 24 bytes after the 4 byte bank header)
+  size_t bank = HOST_EEPROM_SIZE / 2;
+  size_t record = STATE_STORE_RECORD_OVERHEAD + sizeof(TestState);
+  EEPROM.bytes[bank + STATE_STORE_BANK_HEADER + record + 4 + 5] ^= 0x10;
+
+  LoggerStateStore restarted;
+  restarted.begin();
+  CHECK(loadCounter(&restarted, 1) == 3);
+  CHECK(loadCounter(&restarted, 2) == 0); // corrupted, no older record
+  CHECK(loadCounter(&restarted, 3) == 4); // after the corrupted record
+  CHECK(restarted.getBadRecords() == 1);
+
+  // new records still go after the existing ones
+  TestState b2 = makeState(5);
+  CHECK(restarted.save(2, 1, &b2, sizeof(b2)));
+  LoggerStateStore again;
+  again.begin();
+  CHECK(loadCounter(&again, 1) == 3);
+  CHECK(loadCounter(&again, 2) == 5);
+  CHECK(loadCounter(&again, 3) == 4);
+
+  // two corrupted records in a row --> the sizes are not trusted either, scanning stops at the second one
+  EEPROM.bytes[bank + STATE_STORE_BANK_HEADER + 2 * record + 4 + 5] ^= 0x10;
+  LoggerStateStore stopped;
+  stopped.begin();
+  CHECK(loadCounter(&stopped, 1) == 1); // the older record of key 1
+  CHECK(loadCounter(&stopped, 2) == 0);
+  CHECK(loadCounter(&stopped, 3) == 0);
+  CHECK(stopped.getBadRecords() == 1);
+}
+
+// first start after the upgrade: controller and scale states saved with EEPROM.put at the old offsets are imported
+static void testLegacyImport() {
+  EEPROM.clear();
+  LoggerControllerState old_controller(true, true, true, 600, LOG_BY_TIME, 500, 2000);
+  ScaleState old_scale(CALC_RATE_MIN);
+  EEPROM.put(0, old_controller);
+  EEPROM.put(sizeof(LoggerControllerState), old_scale);
+
+  LoggerControllerState controller_state(false, false, false, 3600, LOG_BY_TIME, 2000, 5000);
+  LoggerController controller("test 0.1", A5, &controller_state);
+  ScaleState scale_state(CALC_RATE_OFF);
+  ChemglassScaleLoggerComponent scale("scale", &controller, &scale_state);
+  controller.addComponent(&scale);
+  controller.state_store.begin();
+  controller.loadState(false);
+  controller.loadComponentsState(false);
+  CHECK(controller_state.locked);
+  CHECK(controller_state.data_logging_period == 600);
+  CHECK(controller_state.data_reading_period == 2000);
+  CHECK(scale_state.calc_rate == CALC_RATE_MIN);
+
+  // saved in the store --> the next start restores them from there (and the old layout is not read again)
+  LoggerControllerState restarted_state(false, false, false, 3600, LOG_BY_TIME, 2000, 5000);
+  LoggerController restarted("test 0.1", A5, &restarted_state);
+  ScaleState restarted_scale_state(CALC_RATE_OFF);
+  ChemglassScaleLoggerComponent restarted_scale("scale", &restarted, &restarted_scale_state);
+  restarted.addComponent(&restarted_scale);
+  restarted.state_store.begin();
+  CHECK(restarted.state_store.loadLegacy(0, sizeof(LoggerControllerState)) == NULL);
+  restarted.loadState(false);
+  restarted.loadComponentsState(false);
+  CHECK(restarted_state.locked);
+  CHECK(restarted_scale_state.calc_rate == CALC_RATE_MIN);
+
+  // erased memory or a different version is not imported
+  EEPROM.clear();
+  ScaleState other_version(CALC_RATE_MIN);
+  other_version.version++;
+  EEPROM.put(sizeof(LoggerControllerState), other_version);
+  LoggerControllerState fresh_state(false, false, false, 3600, LOG_BY_TIME, 2000, 5000);
+  LoggerController fresh("test 0.1", A5, &fresh_state);
+  ScaleState fresh_scale_state(CALC_RATE_OFF);
+  ChemglassScaleLoggerComponent fresh_scale("scale", &fresh, &fresh_scale_state);
+  fresh.addComponent(&fresh_scale);
+  fresh.state_store.begin();
+  fresh.loadState(false);
+  fresh.loadComponentsState(false);
+  CHECK(!fresh_state.locked);
+  CHECK(fresh_state.data_logging_period == 3600);
+  CHECK(fresh_scale_state.calc_rate == CALC_RATE_OFF);
+}
+
+int main() {
+  testWearAndPowerCuts();
+  testCorruptedRecord();
+  testLegacyImport();
+  return(TEST_RESULT());
+}
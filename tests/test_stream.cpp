@@ -0,0 +1,149 @@
+// tests of the raw data stream (LoggerStream.h): COBS encoding, records decoded back from the serial output
+// with text printed between the frames, frames dropped when the serial buffer is full
+#include "application.h"
+#include "LoggerStream.h"
+#include "LoggerClock.h"
+#include "test.h"
+
+// reproducible pseudo random numbers (independent of the libc rand implementation)
+static uint32_t random_state = 1;
+static uint32_t nextRandom() {
+  random_state = random_state * 1664525UL + 1013904223UL;
+  return(random_state >> 8);
+}
+
+/*** reader side (same as tools/stream_reader.py) ***/
+
+// @return number of decoded bytes (0 if the data is not valid COBS)
+static size_t decodeCOBS(const uint8_t* data, size_t size, uint8_t* target) {
+  size_t pos = 0, n = 0;
+  while (pos < size) {
+    uint8_t code = data[pos++];
+    if (code == 0 || pos + code - 1 > size) return(0);
+    for (uint8_t i = 1; i < code; i++) target[n++] = data[pos++];
+    if (code < 0xff && pos < size) target[n++] = 0;
+  }
+  return(n);
+}
+
+static uint8_t crc8(const uint8_t* data, size_t size) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return(crc);
+}
+
+struct StreamRecord {
+  uint8_t idx;
+  uint64_t epoch_ms;
+  double value;
+};
+
+// splits the output at the delimiters and keeps the chunks that decode to a record with a valid CRC
+static std::vector<StreamRecord> readRecords(const std::string& output, int* text_chunks) {
+  std::vector<StreamRecord> records;
+  *text_chunks = 0;
+  size_t start = 0;
+  while (start <= output.size()) {
+    size_t end = output.find((char) STREAM_DELIMITER, start);
+    if (end == std::string::npos) end = output.size();
+    if (end > start) {
+      uint8_t decoded[600];
+      size_t n = (end - start <= 512) ? decodeCOBS((const uint8_t*) output.data() + start, end - start, decoded) : 0;
+      if (n == STREAM_RECORD_SIZE && crc8(decoded, STREAM_RECORD_SIZE - 1) == decoded[STREAM_RECORD_SIZE - 1]) {
+        StreamRecord record;
+        record.idx = decoded[0];
+        memcpy(&record.epoch_ms, decoded + 1, sizeof(record.epoch_ms));
+        memcpy(&record.value, decoded + 9, sizeof(record.value));
+        records.push_back(record);
+      } else {
+        (*text_chunks)++;
+      }
+    }
+    start = end + 1;
+  }
+  return(records);
+}
+
+/*** tests ***/
+
+// random data with runs of zeros and blocks longer than 254 bytes
+static void testCOBS() {
+  int failures = 0;
+  uint8_t data[600], encoded[620], decoded[620];
+  for (int i = 0; i < 2000; i++) {
+    size_t size = 1 + nextRandom() % 600;
+    int zeros = nextRandom() % 4; // none, few, many, all
+    for (size_t j = 0; j < size; j++) {
+      data[j] = (zeros == 3 || (zeros > 0 && nextRandom() % (zeros == 1 ? 100 : 3) == 0)) ? 0 : 1 + nextRandom() % 255;
+    }
+    size_t n = encodeCOBS(data, size, encoded);
+    if (n > size + size / 254 + 1 || memchr(encoded, 0, n) != NULL) failures++;
+    else if (decodeCOBS(encoded, n, decoded) != size || memcmp(data, decoded, size) != 0) failures++;
+  }
+  CHECK(failures == 0);
+}
+
+static void testStream() {
+  // synced clock
+  host_millis = 5000;
+  Particle.host_sync_millis = 5000;
+  Particle.host_sync_time = 1700000000;
+  updateClock();
+  CHECK(isClockSynced());
+
+  Serial.output.clear();
+  Serial.write_capacity = 64;
+  streamValue(1, millis64(), 1.0);
+  CHECK(Serial.output.empty()); // not streaming
+
+  startStream();
+  std::vector<StreamRecord> sent;
+  for (int i = 0; i <= 1000; i++) {
+    StreamRecord record;
+    record.idx = i % 5;
+    record.value = (i % 10 == 0) ? 0.0 : (double) (nextRandom() % 200001) / 100.0 - 1000.0; // also all-zero values
+    uint64_t local_ms = millis64();
+    record.epoch_ms = getEpochMillis(local_ms);
+    streamValue(record.idx, local_ms, record.value);
+    sent.push_back(record);
+    if (i % 7 == 0) Serial.printlnf("INFO: text between the frames #%d", i);
+    host_millis += 1 + nextRandom() % 50;
+  }
+  CHECK(getStreamedRecords() == 1001);
+  CHECK(getStreamDropped() == 0);
+
+  int text_chunks = 0;
+  std::vector<StreamRecord> received = readRecords(Serial.output, &text_chunks);
+  int mismatches = 0;
+  for (size_t i = 0; i < sent.size() && i < received.size(); i++) {
+    if (received[i].idx != sent[i].idx || received[i].epoch_ms != sent[i].epoch_ms || received[i].value != sent[i].value) mismatches++;
+  }
+  printf("INFO: %zu records sent, %zu decoded, %d text chunks\n", sent.size(), received.size(), text_chunks);
+  CHECK(received.size() == sent.size());
+  CHECK(mismatches == 0);
+  CHECK(text_chunks == 1000 / 7 + 1);
+  CHECK(received[0].epoch_ms > 1700000000000ULL);
+
+  // serial buffer full --> dropped, nothing written
+  size_t written = Serial.output.size();
+  Serial.write_capacity = STREAM_FRAME_MAX - 4;
+  streamValue(2, millis64(), 3.0);
+  streamValue(2, millis64(), 3.0);
+  CHECK(getStreamDropped() == 2);
+  CHECK(getStreamedRecords() == 1001);
+  CHECK(Serial.output.size() == written);
+  Serial.write_capacity = 64;
+
+  stopStream();
+  streamValue(2, millis64(), 3.0);
+  CHECK(Serial.output.size() == written);
+}
+
+int main() {
+  testCOBS();
+  testStream();
+  return(TEST_RESULT());
+}
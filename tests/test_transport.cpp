@@ -0,0 +1,205 @@
+// tests of the local log transports (LoggerTransport.h): TCP reconnect backoff while the collector is down
+// (each connect attempt blocks), frames on the wire, UDP datagrams, data logs of each transport at its own period
+#include "application.h"
+#include "LoggerTransport.h"
+#include "LoggerController.h"
+#include "LoggerComponent.h"
+#include "LoggerClock.h"
+#include "test.h"
+
+// controller with data logging every 10 s
+LoggerControllerState controller_state(false, false, true, 10, LOG_BY_TIME);
+LoggerDisplay test_lcd;
+
+class TestController : public LoggerController {
+
+  public:
+
+    TestController() : LoggerController("test 0.1", A5, &test_lcd, &controller_state) {}
+
+    void start() { startup_complete = true; }
+    LoggerTransport* getParticleTransport() { return(&particle_transport); }
+    using LoggerController::updateDataLogs;
+
+};
+
+TestController controller;
+
+// one data that receives a sample whenever sample() is called
+class TestSensor : public LoggerComponent {
+
+  public:
+
+    TestSensor() : LoggerComponent("sensor", &controller, true, true) {}
+
+    uint8_t setupDataVector(uint8_t start_idx) {
+      data.push_back(LoggerData(start_idx + 1, "temp", "C", 2));
+      return(start_idx + data.size());
+    }
+
+    void sample(double value) {
+      data[0].setNewestDataTime(millis64());
+      data[0].setNewestValue(value);
+      data[0].saveNewestValue(true);
+    }
+
+};
+
+TestSensor sensor;
+
+// one loop of the controller's transport handling (see LoggerController::update) with the loop taking step ms
+static void runTransport(LoggerTransport* transport, unsigned long step) {
+  if (transport->isTimeToSend() && transport->hasLogs() && transport->isConnected()) {
+    LoggerLogStackBase* logs = transport->state_logs->empty() ? transport->data_logs : transport->state_logs;
+    if (transport->send(transport->state_logs->empty() ? TRANSPORT_DATA_LOG : TRANSPORT_STATE_LOG, logs->back())) logs->pop();
+    transport->markSendAttempt();
+  }
+  host_millis += step;
+}
+
+// time the loop spends blocked in connect attempts over an hour with the collector down (a data log every 10 s)
+static void testBackoff() {
+  LoggerTCPTransport tcp(IPAddress(192, 168, 1, 10), 5555);
+  WiFi.host_ready = true;
+  host_tcp_listening = false;
+  host_tcp_connect_ms = 5000;
+  host_tcp_connects = 0;
+  unsigned long start = host_millis;
+  unsigned long next_log = host_millis;
+  while (host_millis - start < 3600000UL) {
+    if (host_millis >= next_log) {
+      tcp.queueLog(TRANSPORT_DATA_LOG, "{\"id\":\"test\",\"d\":[]}");
+      next_log += 10000;
+    }
+    runTransport(&tcp, 10);
+  }
+  unsigned long blocked = host_tcp_connects * host_tcp_connect_ms;
+  printf("INFO: collector down for 1 h: %d connect attempts, loop blocked %lu s (%.2f%%)\n",
+    host_tcp_connects, blocked / 1000, 100.0 * blocked / 3600000UL);
+  // backoff 10 s, 20 s, ... up to TRANSPORT_RECONNECT_MAX instead of an attempt every 10 s (360)
+  CHECK(host_tcp_connects <= 15);
+  CHECK(tcp.connects == (unsigned long) host_tcp_connects);
+  CHECK(tcp.sent == 0);
+  CHECK(tcp.dropped > 0); // the stack filled up in the meantime
+
+  // collector comes back --> connects within TRANSPORT_RECONNECT_MAX and sends everything waiting
+  host_tcp_listening = true;
+  host_tcp_sent.clear();
+  size_t waiting = tcp.data_logs->size();
+  start = host_millis;
+  while (tcp.hasLogs() && host_millis - start < TRANSPORT_RECONNECT_MAX + 60000UL) runTransport(&tcp, 10);
+  CHECK(!tcp.hasLogs());
+  CHECK(tcp.sent == waiting);
+
+  // a dropped connection is retried right away and then backs off from the first interval again
+  int connects = host_tcp_connects;
+  tcp.queueLog(TRANSPORT_STATE_LOG, "{\"s\":1}");
+  host_tcp_listening = false; // drops the connection
+  host_millis += TRANSPORT_LOCAL_SEND_INTERVAL + 1;
+  runTransport(&tcp, 100);
+  CHECK(host_tcp_connects == connects + 1);
+  host_tcp_listening = true;
+  start = host_millis;
+  while (tcp.hasLogs() && host_millis - start < 2 * TRANSPORT_RECONNECT_INTERVAL) runTransport(&tcp, 10);
+  CHECK(host_tcp_connects == connects + 2);
+  CHECK(!tcp.hasLogs());
+  CHECK(host_millis - start >= TRANSPORT_RECONNECT_INTERVAL - 100); // the failed attempt was 100 ms before start
+}
+
+// frames: length of type + log (big endian), type, log
+static void testFrames() {
+  LoggerTCPTransport tcp(IPAddress(192, 168, 1, 10), 5555);
+  host_tcp_listening = true;
+  host_tcp_sent.clear();
+  CHECK(tcp.isConnected());
+  CHECK(tcp.send(TRANSPORT_STATE_LOG, "{\"a\":1}"));
+  CHECK(tcp.send(TRANSPORT_DATA_LOG, ""));
+  CHECK(host_tcp_sent == std::string("\x00\x08S{\"a\":1}\x00\x01" "D", 13));
+
+  LoggerUDPTransport udp(IPAddress(192, 168, 1, 10), 5556);
+  host_udp_packets.clear();
+  CHECK(udp.isConnected());
+  CHECK(udp.send(TRANSPORT_DATA_LOG, "{\"b\":2}"));
+  CHECK(host_udp_packets.size() == 1);
+  CHECK(host_udp_packets[0] == std::string("\x00\x08" "D{\"b\":2}", 10));
+}
+
+// @return the logs on the stack (oldest first), the stack is emptied
+static std::vector<std::string> popLogs(LoggerLogStackBase* logs) {
+  std::vector<std::string> texts;
+  while (!logs->empty()) {
+    texts.insert(texts.begin(), logs->back());
+    logs->pop();
+  }
+  return(texts);
+}
+
+// the cloud gets the averages of the controller's log period, a local transport the latest samples at its own period
+static void testDataLogPeriods() {
+  host_millis = 5000;
+  Particle.host_sync_millis = 5000;
+  Particle.host_sync_time = 1700000000;
+  updateClock();
+  LoggerUDPTransport udp(IPAddress(192, 168, 1, 10), 5557, TRANSPORT_LOCAL_SEND_INTERVAL, 1000);
+  controller.addComponent(&sensor);
+  controller.addTransport(&udp);
+  controller.start();
+  LoggerTransport* cloud = controller.getParticleTransport();
+
+  // a sample every 400 ms for 30 s (loop every 10 ms)
+  int samples = 0;
+  unsigned long start = host_millis;
+  while (host_millis - start < 30000UL) {
+    if ((host_millis - start) % 400 == 0) sensor.sample(samples++);
+    controller.updateDataLogs();
+    host_millis += 10;
+  }
+
+  std::vector<std::string> averages = popLogs(cloud->data_logs), latest = popLogs(udp.data_logs);
+  printf("INFO: %d samples in 30 s: %zu averaged data logs to the cloud, %zu sample logs to the local transport\n",
+    samples, averages.size(), latest.size());
+  printf("INFO: cloud: %s\nINFO: local: %s\n", averages.front().c_str(), latest.front().c_str());
+  CHECK(averages.size() == 3);
+  CHECK(latest.size() >= 29 && latest.size() <= 31);
+  int averaged = 0, mismatches = 0;
+  for (size_t i = 0; i < averages.size(); i++) {
+    const char* n = strstr(averages[i].c_str(), "\"n\":");
+    if (n != NULL) averaged += atoi(n + 4);
+  }
+  CHECK(averaged == samples - 12); // all samples up to the last averaged log (~25 s after the start)
+  // every log of the local transport has one sample and a newer value than the one before
+  double last = -1;
+  for (size_t i = 0; i < latest.size(); i++) {
+    const char* n = strstr(latest[i].c_str(), "\"n\":1");
+    const char* v = strstr(latest[i].c_str(), "\"v\":");
+    if (n == NULL || v == NULL || atof(v + 4) <= last) mismatches++;
+    else last = atof(v + 4);
+  }
+  CHECK(mismatches == 0);
+  CHECK(last >= samples - 3); // samples of the last second are in the next log
+
+  // the rest --> no new sample, no log
+  host_millis += 1000;
+  controller.updateDataLogs();
+  latest = popLogs(udp.data_logs);
+  CHECK(latest.size() == 1 && atof(strstr(latest[0].c_str(), "\"v\":") + 4) == samples - 1);
+
+  host_millis += 1000;
+  controller.updateDataLogs();
+  CHECK(udp.data_logs->empty());
+
+  // a sample right before the averaged data log clears it is still logged for the local transport
+  sensor.sample(1000.5);
+  host_millis += 10000;
+  controller.updateDataLogs();
+  latest = popLogs(udp.data_logs);
+  CHECK(latest.size() == 1 && strstr(latest[0].c_str(), "\"v\":1000.5") != NULL);
+  CHECK(popLogs(cloud->data_logs).size() == 1);
+}
+
+int main() {
+  testBackoff();
+  testFrames();
+  testDataLogPeriods();
+  return(TEST_RESULT());
+}
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Local collector for the state and data logs of a lablogger device sent with the TCP or UDP transport
+(controller.addTransport() with a LoggerTCPTransport / LoggerUDPTransport, see src/modules/logger/LoggerTransport.h).
+
+Frames are the log text with a 3 byte header:
+  length of type + log (uint16, big endian), type ('S' = state log, 'D' = data log), followed by the log text (JSON).
+TCP streams the frames back to back (one device connection at a time), UDP sends one frame per datagram.
+Each log is printed (with the sender and the time it arrived) and appended as one line to the output files if given.
+
+usage:
+  log_listener.py --tcp 5555                      # listen for a TCP transport on port 5555
+  log_listener.py --udp 5556                      # listen for a UDP transport on port 5556
+  log_listener.py --tcp 5555 --udp 5556 --state state.jsonl --data data.jsonl
+"""
+
+import argparse
+import datetime
+import json
+import selectors
+import socket
+import struct
+import sys
+
+HEADER = struct.Struct(">Hc")
+TYPES = {b"S": "state", b"D": "data"}
+
+
+class FrameReader:
+    """reassembles the frames of a TCP stream"""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        """@return the (type, log) frames that are complete"""
+        self.buffer += data
+        frames = []
+        while len(self.buffer) >= HEADER.size:
+            length, log_type = HEADER.unpack_from(self.buffer)
+            if len(self.buffer) < 2 + length:
+                break
+            frames.append((log_type, bytes(self.buffer[HEADER.size:2 + length])))
+            del self.buffer[:2 + length]
+        return frames
+
+
+def parse_datagram(data):
+    """@return (type, log) or None if the datagram is not a complete frame"""
+    if len(data) < HEADER.size:
+        return None
+    length, log_type = HEADER.unpack_from(data)
+    if len(data) != 2 + length:
+        return None
+    return log_type, data[HEADER.size:]
+
+
+class Collector:
+
+    def __init__(self, outputs):
+        self.outputs = outputs
+        self.logs = {"state": 0, "data": 0}
+        self.invalid = 0
+
+    def log(self, sender, log_type, log):
+        kind = TYPES.get(log_type)
+        text = log.decode("utf-8", errors="replace")
+        if kind is None:
+            self.invalid += 1
+            sys.stderr.write("{}: unknown frame type {!r} ignored\n".format(sender, log_type))
+            return
+        try:
+            json.loads(text)
+        except ValueError:
+            sys.stderr.write("{}: {} log is not valid JSON: {}\n".format(sender, kind, text))
+        self.logs[kind] += 1
+        received = datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="milliseconds")
+        print("{} {} {} log: {}".format(received, sender, kind, text), flush=True)
+        out = self.outputs.get(kind)
+        if out is not None:
+            out.write(text + "\n")
+            out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="collect the logs of a lablogger device sent via TCP or UDP")
+    parser.add_argument("--tcp", type=int, help="TCP port to listen on")
+    parser.add_argument("--udp", type=int, help="UDP port to listen on")
+    parser.add_argument("--bind", default="0.0.0.0", help="address to listen on")
+    parser.add_argument("--state", help="append the state logs to this file (one JSON log per line)")
+    parser.add_argument("--data", help="append the data logs to this file (one JSON log per line)")
+    args = parser.parse_args()
+    if args.tcp is None and args.udp is None:
+        parser.error("at least one of --tcp or --udp is required")
+
+    outputs = {kind: open(path, "a") for kind, path in (("state", args.state), ("data", args.data)) if path}
+    collector = Collector(outputs)
+    selector = selectors.DefaultSelector()
+    if args.tcp is not None:
+        server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind((args.bind, args.tcp))
+        server.listen()
+        selector.register(server, selectors.EVENT_READ, "accept")
+        sys.stderr.write("log listener: TCP on port {}\n".format(args.tcp))
+    if args.udp is not None:
+        udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        udp.bind((args.bind, args.udp))
+        selector.register(udp, selectors.EVENT_READ, "udp")
+        sys.stderr.write("log listener: UDP on port {}\n".format(args.udp))
+
+    try:
+        while True:
+            for key, _ in selector.select():
+                sock = key.fileobj
+                if key.data == "accept":
+                    connection, address = sock.accept()
+                    sys.stderr.write("{}: connected\n".format(address[0]))
+                    selector.register(connection, selectors.EVENT_READ, (address[0], FrameReader()))
+                elif key.data == "udp":
+                    data, address = sock.recvfrom(65535)
+                    frame = parse_datagram(data)
+                    if frame is None:
+                        collector.invalid += 1
+                        sys.stderr.write("{}: incomplete datagram ignored\n".format(address[0]))
+                    else:
+                        collector.log(address[0], *frame)
+                else:
+                    sender, reader = key.data
+                    try:
+                        data = sock.recv(4096)
+                    except ConnectionError:
+                        data = b""
+                    if not data:
+                        # the device starts over with a new connection after a failed write
+                        sys.stderr.write("{}: disconnected\n".format(sender))
+                        selector.unregister(sock)
+                        sock.close()
+                        continue
+                    for frame in reader.feed(data):
+                        collector.log(sender, *frame)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for out in outputs.values():
+            out.close()
+
+    sys.stderr.write("log listener: {} state logs, {} data logs, {} invalid frames\n".format(
+        collector.logs["state"], collector.logs["data"], collector.invalid))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Reads the raw data stream of a lablogger device (device "stream on", see src/modules/logger/LoggerStream.h)
+from USB serial (or a capture file) and writes the records to CSV or Parquet.
+
+Frames are COBS encoded records delimited by 0x00:
+  data index (uint8), data time as UTC epoch in ms (uint64), value (double), CRC-8 (poly 0x07) - little endian.
+Anything between the frames that is not a valid record is device text output (INFO/DEBUG messages), it is
+passed through to stderr. The channel map the device prints when the stream starts ("STREAM: #idx variable [units] (component)")
+is used to add the variable, units and component to each record.
+
+usage:
+  stream_reader.py /dev/ttyACM0 data.csv          # read from the device until Ctrl-C
+  stream_reader.py /dev/ttyACM0 data.parquet      # same but write Parquet (requires pandas + pyarrow)
+  stream_reader.py capture.bin data.csv           # read a capture (e.g. cat /dev/ttyACM0 > capture.bin)
+"""
+
+import argparse
+import csv
+import datetime
+import os
+import re
+import stat
+import struct
+import sys
+
+RECORD = struct.Struct("<BQd")
+RECORD_SIZE = RECORD.size + 1  # + CRC-8
+CHANNEL = re.compile(r"STREAM: #(\d+) (.*) \[(.*)\] \((.*)\)")
+COLUMNS = ["idx", "variable", "units", "component", "epoch_ms", "datetime", "value"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def decode_cobs(data):
+    """@return decoded bytes or None if the data is not valid COBS"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_record(chunk):
+    """@return (idx, epoch_ms, value) or None if the chunk is not a valid record"""
+    record = decode_cobs(chunk)
+    if record is None or len(record) != RECORD_SIZE or crc8(record[:-1]) != record[-1]:
+        return None
+    return RECORD.unpack(record[:-1])
+
+
+class StreamReader:
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.channels = {}
+        self.records = 0
+        self.invalid = 0
+
+    def feed(self, data):
+        """@return the records in the data (as dicts)"""
+        self.buffer += data
+        rows = []
+        while True:
+            end = self.buffer.find(0)
+            if end < 0:
+                break
+            chunk = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if len(chunk) == 0:
+                continue
+            record = parse_record(chunk)
+            if record is not None:
+                rows.append(self.to_row(*record))
+            else:
+                self.text(chunk)
+        return rows
+
+    def text(self, chunk):
+        text = chunk.decode("utf-8", errors="replace")
+        for line in text.splitlines():
+            match = CHANNEL.search(line)
+            if match:
+                self.channels[int(match.group(1))] = match.group(2, 3, 4)
+        if any(c.isprintable() for c in text):
+            sys.stderr.write(text if text.endswith("\n") else text + "\n")
+        else:
+            self.invalid += 1
+
+    def to_row(self, idx, epoch_ms, value):
+        self.records += 1
+        variable, units, component = self.channels.get(idx, ("", "", ""))
+        dt = datetime.datetime.fromtimestamp(epoch_ms / 1000, datetime.timezone.utc).isoformat(timespec="milliseconds") if epoch_ms > 0 else ""
+        return {"idx": idx, "variable": variable, "units": units, "component": component,
+                "epoch_ms": epoch_ms, "datetime": dt, "value": value}
+
+
+def open_source(path, baud):
+    """@return the source and whether it is a live serial port (empty reads are timeouts, not the end)"""
+    if os.path.exists(path) and stat.S_ISCHR(os.stat(path).st_mode):
+        import serial  # pyserial
+        return serial.Serial(path, baud, timeout=0.5), True
+    return open(path, "rb"), False
+
+
+def read_chunks(source, live):
+    while True:
+        data = source.read(4096)
+        if data:
+            yield data
+        elif not live:
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description="read the raw data stream of a lablogger device")
+    parser.add_argument("source", help="serial port (e.g. /dev/ttyACM0) or capture file")
+    parser.add_argument("output", help="output file (.csv or .parquet)")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate (USB serial ignores it)")
+    args = parser.parse_args()
+
+    parquet = args.output.endswith(".parquet")
+    reader = StreamReader()
+    rows = []
+    out = None
+    writer = None
+    if not parquet:
+        out = open(args.output, "w", newline="")
+        writer = csv.DictWriter(out, fieldnames=COLUMNS)
+        writer.writeheader()
+
+    source, live = open_source(args.source, args.baud)
+    try:
+        for data in read_chunks(source, live):
+            new_rows = reader.feed(data)
+            if parquet:
+                rows += new_rows
+            elif new_rows:
+                writer.writerows(new_rows)
+                out.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+        if out is not None:
+            out.close()
+
+    if parquet:
+        import pandas  # requires pyarrow (or fastparquet) as well
+        pandas.DataFrame(rows, columns=COLUMNS).to_parquet(args.output, index=False)
+
+    sys.stderr.write("stream reader: {} records written to {}, {} unreadable chunks\n".format(reader.records, args.output, reader.invalid))
+
+
+if __name__ == "__main__":
+    main()